@@ -0,0 +1,93 @@
+#include "TMIChannelState.h"
+
+template<typename T>
+static void UpdateField(T& Current, const T& Incoming, ETWChannelStateField Field, ETWChannelStateField& OutChanged)
+{
+  if (Current != Incoming)
+  {
+    Current = Incoming;
+    OutChanged |= Field;
+  }
+}
+
+FTWChannelState& FTMIChannelStateStore::FindOrAdd(const FString& Channel, bool& bOutAdded)
+{
+  FTWChannelState* State = States.Find(Channel);
+  bOutAdded = State == nullptr;
+
+  if (bOutAdded)
+  {
+    State = &States.Add(Channel, FTWChannelState(Channel));
+  }
+
+  return *State;
+}
+
+ETWChannelStateField FTMIChannelStateStore::ApplyRoomState(const FString& Channel, const FTWRoomStateTags& Tags)
+{
+  bool bAdded;
+  FTWChannelState& State = FindOrAdd(Channel, bAdded);
+  ETWChannelStateField Changed = ETWChannelStateField::None;
+  ETWChannelStateField Present = ETWChannelStateField::None;
+
+  // Only touch what the server actually sent, everything else keeps its last known value
+  if (Tags.HasField(ETWRoomStateField::EmoteOnly))
+  {
+    Present |= ETWChannelStateField::EmoteOnly;
+    UpdateField(State.EmoteOnly, Tags.EmoteOnly, ETWChannelStateField::EmoteOnly, Changed);
+  }
+
+  if (Tags.HasField(ETWRoomStateField::FollowersOnly))
+  {
+    Present |= ETWChannelStateField::FollowersOnly;
+    UpdateField(State.FollowersOnlyMinMinutes, Tags.FollowersOnlyMinMinutes, ETWChannelStateField::FollowersOnly, Changed);
+  }
+
+  if (Tags.HasField(ETWRoomStateField::R9K))
+  {
+    Present |= ETWChannelStateField::R9K;
+    UpdateField(State.R9K, Tags.R9K, ETWChannelStateField::R9K, Changed);
+  }
+
+  if (Tags.HasField(ETWRoomStateField::Slow))
+  {
+    Present |= ETWChannelStateField::Slow;
+    UpdateField(State.SlowModeSeconds, Tags.SlowModeSeconds, ETWChannelStateField::Slow, Changed);
+  }
+
+  if (Tags.HasField(ETWRoomStateField::SubsOnly))
+  {
+    Present |= ETWChannelStateField::SubsOnly;
+    UpdateField(State.SubscribersOnly, Tags.SubscribersOnly, ETWChannelStateField::SubsOnly, Changed);
+  }
+
+  return bAdded ? Present : Changed;
+}
+
+ETWChannelStateField FTMIChannelStateStore::ApplyUserState(const FString& Channel, const FTWUserStateTags& Tags)
+{
+  bool bAdded;
+  FTWChannelState& State = FindOrAdd(Channel, bAdded);
+  ETWChannelStateField Changed = ETWChannelStateField::None;
+
+  const bool bBroadcaster = Tags.Badges.Contains(TEXT("broadcaster"));
+  const bool bModerator = Tags.Mod || Tags.Badges.Contains(TEXT("moderator"));
+
+  if (State.bIsBroadcaster != bBroadcaster || State.bIsModerator != bModerator)
+  {
+    State.bIsBroadcaster = bBroadcaster;
+    State.bIsModerator = bModerator;
+    Changed |= ETWChannelStateField::Moderator;
+  }
+
+  UpdateField(State.bIsVIP, Tags.Badges.Contains(TEXT("vip")), ETWChannelStateField::VIP, Changed);
+  UpdateField(State.bIsSubscriber, Tags.Subscriber || Tags.Badges.Contains(TEXT("subscriber")), ETWChannelStateField::Subscriber, Changed);
+
+  // USERSTATE is resent after every message we send, only copy the badges when they differ
+  if (!State.Badges.OrderIndependentCompareEqual(Tags.Badges))
+  {
+    State.Badges = Tags.Badges;
+  }
+
+  return bAdded ? (ETWChannelStateField::Moderator | ETWChannelStateField::VIP | ETWChannelStateField::Subscriber) : Changed;
+}
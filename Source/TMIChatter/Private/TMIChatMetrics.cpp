@@ -0,0 +1,126 @@
+#include "TMIChatMetrics.h"
+
+FTMIChatMetrics::FTMIChatMetrics()
+  : Windows({ 10.f, 60.f, 300.f })
+{
+}
+
+void FTMIChatMetrics::SetWindows(const TArray<float>& WindowSeconds)
+{
+  Windows.Reset();
+
+  for (float Seconds : WindowSeconds)
+  {
+    if (Seconds > 0.f)
+      Windows.Add(Seconds);
+  }
+
+  Channels.Reset();
+}
+
+void FTMIChatMetrics::FWindowCounters::Advance(double Now)
+{
+  const int64 Bucket = FMath::FloorToInt64(Now / BucketSeconds);
+
+  if (Bucket <= HeadBucket)
+    return;
+
+  // Everything older than a full ring is gone anyway
+  const int64 Steps = FMath::Min<int64>(Bucket - HeadBucket, BucketsPerWindow);
+
+  for (int64 Step = 1; Step <= Steps; ++Step)
+  {
+    int64* Slot = Counts[(HeadBucket + Step) % BucketsPerWindow];
+
+    for (int32 Metric = 0; Metric < MetricCount; ++Metric)
+    {
+      Sums[Metric] -= Slot[Metric];
+      Slot[Metric] = 0;
+    }
+  }
+
+  HeadBucket = Bucket;
+}
+
+void FTMIChatMetrics::Record(const FString& Channel, ETWChatMetric Metric, int64 Amount, double Now)
+{
+  if (Metric == ETWChatMetric::Count || Windows.Num() == 0)
+    return;
+
+  FChannelCounters* Counters = Channels.Find(Channel);
+
+  if (!Counters)
+  {
+    Counters = &Channels.Add(Channel);
+    Counters->SetNum(Windows.Num());
+
+    for (int32 Index = 0; Index < Windows.Num(); ++Index)
+    {
+      FWindowCounters& Window = (*Counters)[Index];
+      Window.BucketSeconds = Windows[Index] / BucketsPerWindow;
+      Window.HeadBucket = FMath::FloorToInt64(Now / Window.BucketSeconds);
+    }
+  }
+
+  const int32 MetricIndex = static_cast<int32>(Metric);
+
+  for (FWindowCounters& Window : *Counters)
+  {
+    Window.Advance(Now);
+    Window.Counts[Window.HeadBucket % BucketsPerWindow][MetricIndex] += Amount;
+    Window.Sums[MetricIndex] += Amount;
+  }
+}
+
+FTMIChatMetrics::FWindowCounters* FTMIChatMetrics::FindWindow(const FString& Channel, int32 WindowIndex, double Now) const
+{
+  FChannelCounters* Counters = Channels.Find(Channel);
+
+  if (!Counters || !Counters->IsValidIndex(WindowIndex))
+    return nullptr;
+
+  FWindowCounters& Window = (*Counters)[WindowIndex];
+  Window.Advance(Now);
+  return &Window;
+}
+
+int64 FTMIChatMetrics::GetCount(const FString& Channel, ETWChatMetric Metric, int32 WindowIndex, double Now) const
+{
+  const FWindowCounters* Window = Metric != ETWChatMetric::Count ? FindWindow(Channel, WindowIndex, Now) : nullptr;
+  return Window ? Window->Sums[static_cast<int32>(Metric)] : 0;
+}
+
+bool FTMIChatMetrics::GetRates(const FString& Channel, int32 WindowIndex, double Now, FTWChatRates& OutRates) const
+{
+  OutRates = FTWChatRates();
+
+  if (!Windows.IsValidIndex(WindowIndex))
+    return false;
+
+  OutRates.WindowSeconds = Windows[WindowIndex];
+
+  const FWindowCounters* Window = FindWindow(Channel, WindowIndex, Now);
+
+  if (!Window)
+    return false;
+
+  const float Minutes = OutRates.WindowSeconds / 60.f;
+
+  OutRates.Messages = Window->Sums[static_cast<int32>(ETWChatMetric::Messages)];
+  OutRates.Bits = Window->Sums[static_cast<int32>(ETWChatMetric::Bits)];
+  OutRates.Subscriptions = Window->Sums[static_cast<int32>(ETWChatMetric::Subscriptions)];
+  OutRates.MessagesPerSecond = OutRates.Messages / OutRates.WindowSeconds;
+  OutRates.BitsPerMinute = OutRates.Bits / Minutes;
+  OutRates.SubsPerMinute = OutRates.Subscriptions / Minutes;
+  return true;
+}
+
+void FTMIChatMetrics::Remove(const FString& Channel)
+{
+  Channels.Remove(Channel);
+}
+
+void FTMIChatMetrics::Reset()
+{
+  Channels.Reset();
+}
@@ -0,0 +1,48 @@
+#include "TMIChatMetrics.h"
+
+BEGIN_DEFINE_SPEC(TMIChatMetricsSpec, "TMIChatMetrics", EAutomationTestFlags::ProductFilter | EAutomationTestFlags::ApplicationContextMask)
+
+FTMIChatMetrics Metrics;
+
+END_DEFINE_SPEC(TMIChatMetricsSpec);
+
+void TMIChatMetricsSpec::Define()
+{
+  BeforeEach([this]()
+  {
+    Metrics.SetWindows({ 10.f, 60.f });
+  });
+
+  It("should count into every window", [this]()
+  {
+    Metrics.Record(TEXT("ronni"), ETWChatMetric::Messages, 1, 100.0);
+    Metrics.Record(TEXT("ronni"), ETWChatMetric::Messages, 1, 101.0);
+    Metrics.Record(TEXT("ronni"), ETWChatMetric::Bits, 500, 102.0);
+
+    TestEqual("Short Window Messages", Metrics.GetCount(TEXT("ronni"), ETWChatMetric::Messages, 0, 102.0), (int64)2);
+    TestEqual("Long Window Messages", Metrics.GetCount(TEXT("ronni"), ETWChatMetric::Messages, 1, 102.0), (int64)2);
+
+    FTWChatRates Rates;
+    TestTrue("Has Rates", Metrics.GetRates(TEXT("ronni"), 1, 102.0, Rates));
+    TestEqual("Bits Per Minute", Rates.BitsPerMinute, 500.f);
+    TestEqual("Messages Per Second", Rates.MessagesPerSecond, 2.f / 60.f);
+  });
+
+  It("should expire counts that left the window", [this]()
+  {
+    Metrics.Record(TEXT("ronni"), ETWChatMetric::Messages, 1, 100.0);
+    Metrics.Record(TEXT("ronni"), ETWChatMetric::Messages, 1, 105.0);
+
+    TestEqual("Both In Window", Metrics.GetCount(TEXT("ronni"), ETWChatMetric::Messages, 0, 109.0), (int64)2);
+    TestEqual("First Expired", Metrics.GetCount(TEXT("ronni"), ETWChatMetric::Messages, 0, 111.0), (int64)1);
+    TestEqual("Still In Long Window", Metrics.GetCount(TEXT("ronni"), ETWChatMetric::Messages, 1, 111.0), (int64)2);
+    TestEqual("All Expired", Metrics.GetCount(TEXT("ronni"), ETWChatMetric::Messages, 1, 1000.0), (int64)0);
+  });
+
+  It("should report nothing for unknown channels and windows", [this]()
+  {
+    FTWChatRates Rates;
+    TestFalse("Unknown Channel", Metrics.GetRates(TEXT("nobody"), 0, 0.0, Rates));
+    TestFalse("Unknown Window", Metrics.GetRates(TEXT("ronni"), 5, 0.0, Rates));
+  });
+}
@@ -1,18 +1,29 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "TMIChatter.h"
+#include "WebSocketsModule.h"
 
 #define LOCTEXT_NAMESPACE "FTMIChatterModule"
 
+FWebSocketsModule* FTMIChatterModule::WebSocketsModule = nullptr;
+
 void FTMIChatterModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
+	WebSocketsModule = &FModuleManager::LoadModuleChecked<FWebSocketsModule>(TEXT("WebSockets"));
 }
 
 void FTMIChatterModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+	WebSocketsModule = nullptr;
+}
+
+FWebSocketsModule& FTMIChatterModule::GetWebSockets()
+{
+	check(WebSocketsModule != nullptr);
+	return *WebSocketsModule;
 }
 
 #undef LOCTEXT_NAMESPACE
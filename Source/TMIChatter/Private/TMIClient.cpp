@@ -0,0 +1,592 @@
+#include "TMIClient.h"
+#include "TMIUserDirectory.h"
+
+FTMIClient::FTMIClient()
+{
+  // PINGs are answered straight from the receive path through the control lane, ahead of anything queued for sending
+  Ingress.SetPongSender([this](const FString& Line)
+  {
+    OutboundQueue.EnqueueControl(Line);
+    PumpControl();
+  });
+}
+
+void FTMIClient::SetHooks(FTMIClientHooks InHooks)
+{
+  Hooks = MoveTemp(InHooks);
+}
+
+void FTMIClient::SetEvents(FTMIClientEvents InEvents)
+{
+  Events = MoveTemp(InEvents);
+}
+
+void FTMIClient::Start(const FString& InUsername, const FString& InPassword, const TArray<FString>& InAutoJoinChannels, bool bAutoReconnect, bool bInFastMode)
+{
+  Username = InUsername.ToLower();
+  Password = InPassword;
+  AutoJoinChannels = InAutoJoinChannels;
+  bReconnect = bAutoReconnect;
+  bFastMode = bInFastMode;
+  bStayConnected = true;
+  RebuildIgnoredSources();
+
+  if (Hooks.Connect)
+    Hooks.Connect();
+}
+
+void FTMIClient::Stop()
+{
+  bStayConnected = false;
+  ReconnectPolicy.Cancel();
+  Health.Stop();
+  Ingress.Reset();
+
+  if (bConnected && Hooks.SendText)
+  {
+    for (const FString& Channel : Channels)
+      Hooks.SendText(TEXT("PART #") + Channel + TEXT("\r\n"));
+
+    Hooks.SendText(TEXT("QUIT :Goodbye\r\n"));
+  }
+
+  CloseTransport();
+
+  OutboundQueue.Reset();
+  JoinScheduler.Reset();
+  Channels.Empty();
+  RejoinChannels.Empty();
+  QuietJoins.Empty();
+  bAuthenticated = false;
+
+  Username.Reset();
+  Password.Reset();
+  RebuildIgnoredSources();
+  NotifyChannels();
+}
+
+void FTMIClient::Reconnect(double Now)
+{
+  // Credentials, channels and queued chat are kept, the channels are joined again once we're authenticated
+  if (bConnected)
+    CloseTransport();
+
+  JoinScheduler.Reset();
+  Ingress.Reset();
+  Health.Stop();
+  ReconnectPolicy.OnDisconnected(Now);
+
+  if (Hooks.Connect)
+    Hooks.Connect();
+}
+
+void FTMIClient::CloseTransport()
+{
+  bConnected = false;
+
+  if (Hooks.Close)
+    Hooks.Close();
+}
+
+void FTMIClient::OnConnected(double Now)
+{
+  // Channels we were in before losing the connection are joined again once we're authenticated
+  for (const FString& Channel : Channels)
+    RejoinChannels.AddUnique(Channel);
+
+  Channels.Empty();
+  QuietJoins.Empty();
+  JoinScheduler.Reset();
+  bConnected = true;
+  bAuthenticated = false;
+  NotifyChannels();
+
+  // PONGs and probes meant for the previous connection, queued chat waits for the login and goes out after it
+  OutboundQueue.ResetControl();
+
+  TArray<FString> Login;
+  GetLoginLines(Login);
+
+  for (const FString& Line : Login)
+    OutboundQueue.EnqueueControl(Line);
+
+  PumpOutbound(Now);
+}
+
+double FTMIClient::OnConnectionLost(double Now)
+{
+  bConnected = false;
+  Health.Stop();
+
+  if (!bReconnect || !bStayConnected)
+    return -1.0;
+
+  ReconnectPolicy.OnDisconnected(Now);
+  return ReconnectPolicy.Schedule(Now);
+}
+
+int32 FTMIClient::Drain(double Now)
+{
+  if (Ingress.TakeReceived())
+    Health.OnReceive(Now);
+
+  return Ingress.Drain([this, Now](const FString& Line)
+  {
+    Dispatch(Line, Now);
+  });
+}
+
+void FTMIClient::Dispatch(const FString& Line, double Now)
+{
+  TMIParser::MessageBundle Bundle = TMIParser::SplitRawMessage(Line);
+  Dispatch(Bundle, Line, Now);
+}
+
+void FTMIClient::Dispatch(TMIParser::MessageBundle& Bundle, const FString& Line, double Now)
+{
+  if (bDeduplicating && IsDuplicate(Bundle, Line))
+    return;
+
+  if (Events.Received)
+    Events.Received(Bundle, Line);
+
+  if (const FMessageHandler Handler = GetMessageHandlers()[static_cast<uint8>(Bundle.Command)])
+    (this->*Handler)(Bundle, Now);
+}
+
+const FTMIClient::FMessageHandler* FTMIClient::GetMessageHandlers()
+{
+  struct FHandlerTable
+  {
+    FMessageHandler Handlers[IRCCommandCount];
+  };
+
+  // Commands without an entry are ignored
+  static const FHandlerTable Table = []() -> FHandlerTable
+  {
+    FHandlerTable Out = {};
+
+    Out.Handlers[static_cast<uint8>(EIRCCommand::PRIVMSG)] = &FTMIClient::HandlePrivMsg;
+    Out.Handlers[static_cast<uint8>(EIRCCommand::CLEARCHAT)] = &FTMIClient::HandleClearChat;
+    Out.Handlers[static_cast<uint8>(EIRCCommand::CLEARMSG)] = &FTMIClient::HandleClearMsg;
+    Out.Handlers[static_cast<uint8>(EIRCCommand::WHISPER)] = &FTMIClient::HandleWhisper;
+    Out.Handlers[static_cast<uint8>(EIRCCommand::USERNOTICE)] = &FTMIClient::HandleUserNotice;
+    Out.Handlers[static_cast<uint8>(EIRCCommand::NOTICE)] = &FTMIClient::HandleNotice;
+    Out.Handlers[static_cast<uint8>(EIRCCommand::PING)] = &FTMIClient::HandlePing;
+    Out.Handlers[static_cast<uint8>(EIRCCommand::PONG)] = &FTMIClient::HandlePong;
+    Out.Handlers[static_cast<uint8>(EIRCCommand::RECONNECT)] = &FTMIClient::HandleReconnect;
+    Out.Handlers[static_cast<uint8>(EIRCCommand::JOIN)] = &FTMIClient::HandleJoin;
+    Out.Handlers[static_cast<uint8>(EIRCCommand::PART)] = &FTMIClient::HandlePart;
+    Out.Handlers[static_cast<uint8>(EIRCCommand::GLOBALUSERSTATE)] = &FTMIClient::HandleGlobalUserState;
+    Out.Handlers[static_cast<uint8>(EIRCCommand::ROOMSTATE)] = &FTMIClient::HandleRoomState;
+    Out.Handlers[static_cast<uint8>(EIRCCommand::USERSTATE)] = &FTMIClient::HandleUserState;
+
+    return Out;
+  }();
+
+  return Table.Handlers;
+}
+
+// Skips parsing when nobody listens
+template<typename MsgType>
+static void DeliverParsed(TMIParser::MessageBundle& Bundle, const TFunction<void(MsgType& Message)>& Event)
+{
+  if (!Event)
+    return;
+
+  MsgType Message = TMIParser::ParseMessage<MsgType>(Bundle);
+  Event(Message);
+}
+
+void FTMIClient::HandlePrivMsg(TMIParser::MessageBundle& Bundle, double Now)
+{
+  // Exact login match against our own echo and any ignored logins
+  if (!Events.ChatMessage || IgnoredSources.Contains(Bundle.Source))
+    return;
+
+  FPrivMsgMessage Message = TMIParser::ParseMessage<FPrivMsgMessage>(Bundle, UserDirectory != nullptr && UserDirectory->IsEnabled() ? UserDirectory : nullptr);
+  Events.ChatMessage(Message);
+}
+
+void FTMIClient::HandleClearChat(TMIParser::MessageBundle& Bundle, double Now)
+{
+  DeliverParsed(Bundle, Events.ClearChat);
+}
+
+void FTMIClient::HandleClearMsg(TMIParser::MessageBundle& Bundle, double Now)
+{
+  DeliverParsed(Bundle, Events.ClearMsg);
+}
+
+void FTMIClient::HandleWhisper(TMIParser::MessageBundle& Bundle, double Now)
+{
+  DeliverParsed(Bundle, Events.Whisper);
+}
+
+void FTMIClient::HandleUserNotice(TMIParser::MessageBundle& Bundle, double Now)
+{
+  DeliverParsed(Bundle, Events.UserNotice);
+}
+
+void FTMIClient::HandleNotice(TMIParser::MessageBundle& Bundle, double Now)
+{
+  FNoticeMessage Message = TMIParser::ParseMessage<FNoticeMessage>(Bundle);
+
+  // Before the login a NOTICE to * is the login being refused
+  if (!bAuthenticated)
+  {
+    if (Message.Channel == TEXT("*") && Events.AuthFailed)
+      Events.AuthFailed();
+  }
+  else if (Events.Notice)
+  {
+    Events.Notice(Message);
+  }
+}
+
+void FTMIClient::HandlePing(TMIParser::MessageBundle& Bundle, double Now)
+{
+  SendControl(TEXT("PONG :") + Bundle.Params, Now);
+}
+
+void FTMIClient::HandlePong(TMIParser::MessageBundle& Bundle, double Now)
+{
+  OnPong(Bundle.Params, Now);
+}
+
+void FTMIClient::HandleReconnect(TMIParser::MessageBundle& Bundle, double Now)
+{
+  if (Events.ReconnectRequested)
+    Events.ReconnectRequested();
+}
+
+void FTMIClient::HandleJoin(TMIParser::MessageBundle& Bundle, double Now)
+{
+  const double Latency = OnJoined(Bundle.Target, Now);
+
+  // We were in the channel all along, the join was reported when it first happened
+  if (QuietJoins.Remove(Bundle.Target) > 0)
+    return;
+
+  if (Events.Joined)
+    Events.Joined(Bundle.Target, Latency);
+}
+
+void FTMIClient::HandlePart(TMIParser::MessageBundle& Bundle, double Now)
+{
+  if (Events.Parted)
+    Events.Parted(Bundle.Target);
+}
+
+void FTMIClient::HandleGlobalUserState(TMIParser::MessageBundle& Bundle, double Now)
+{
+  OnAuthenticated(Now);
+  DeliverParsed(Bundle, Events.Authenticated);
+}
+
+void FTMIClient::HandleRoomState(TMIParser::MessageBundle& Bundle, double Now)
+{
+  if (!Events.RoomState)
+    return;
+
+  FRoomStateMessage Message = TMIParser::ParseMessage<FRoomStateMessage>(Bundle);
+
+  if (Message.bTagsValid)
+    Events.RoomState(Message);
+}
+
+void FTMIClient::HandleUserState(TMIParser::MessageBundle& Bundle, double Now)
+{
+  if (!Events.UserState)
+    return;
+
+  FUserStateMessage Message = TMIParser::ParseMessage<FUserStateMessage>(Bundle);
+
+  if (Message.bTagsValid)
+    Events.UserState(Message);
+}
+
+void FTMIClient::SetDeduplicating(bool bDeduplicate)
+{
+  bDeduplicating = bDeduplicate;
+  DeliveredIDs.Reset();
+}
+
+bool FTMIClient::IsDuplicate(const TMIParser::MessageBundle& Bundle, const FString& Line)
+{
+  switch (Bundle.Command)
+  {
+  case EIRCCommand::PRIVMSG:
+  case EIRCCommand::CLEARCHAT:
+  case EIRCCommand::CLEARMSG:
+  case EIRCCommand::USERNOTICE:
+  case EIRCCommand::NOTICE:
+  case EIRCCommand::WHISPER:
+  case EIRCCommand::ROOMSTATE:
+  case EIRCCommand::USERSTATE:
+    break;
+
+  default:
+    return false;
+  }
+
+  // Both connections see the same message ID, lines without one are identical on both
+  const FString* Key = &Line;
+
+  for (const FString& Tag : Bundle.Tags)
+  {
+    if (Tag.StartsWith(TEXT("id=")))
+    {
+      Key = &Tag;
+      break;
+    }
+  }
+
+  bool bSeen = false;
+  DeliveredIDs.Add(*Key, &bSeen);
+  return bSeen;
+}
+
+void FTMIClient::SetIgnoredLogins(const TSet<FString>& Logins)
+{
+  IgnoredLogins = Logins;
+  RebuildIgnoredSources();
+}
+
+void FTMIClient::RebuildIgnoredSources()
+{
+  IgnoredSources.Reset();
+  IgnoredSources.Append(IgnoredLogins);
+
+  if (!Username.IsEmpty())
+    IgnoredSources.Add(Username);
+}
+
+void FTMIClient::OnAuthenticated(double Now)
+{
+  // A server that accepts the socket and drops us again keeps backing off, only a login ends it
+  bAuthenticated = true;
+  ReconnectPolicy.OnAuthenticated(Now);
+  StartHealthMonitor(Now);
+
+  // One call so auto-join and rejoined channels are batched together
+  TArray<FString> Joining = AutoJoinChannels;
+  Joining.Append(MoveTemp(RejoinChannels));
+  RejoinChannels.Reset();
+  JoinChannels(Joining, Now);
+}
+
+bool FTMIClient::RequestJoin(const FString& Channel, double Now)
+{
+  FString Chan = Channel.ToLower();
+
+  if (!bConnected || Chan.IsEmpty() || Channels.Contains(Chan))
+    return false;
+
+  JoinScheduler.Request(Chan, Now);
+  Channels.Add(MoveTemp(Chan));
+  return true;
+}
+
+bool FTMIClient::JoinChannel(const FString& Channel, double Now)
+{
+  if (!RequestJoin(Channel, Now))
+    return false;
+
+  NotifyChannels();
+  PumpJoins(Now);
+  return true;
+}
+
+void FTMIClient::JoinChannels(const TArray<FString>& Joining, double Now)
+{
+  bool bRequested = false;
+
+  for (const FString& Channel : Joining)
+    bRequested |= RequestJoin(Channel, Now);
+
+  // Pump once so the channels are batched together
+  if (bRequested)
+  {
+    NotifyChannels();
+    PumpJoins(Now);
+  }
+}
+
+bool FTMIClient::PartChannel(const FString& Channel)
+{
+  const FString Chan = Channel.ToLower();
+
+  // Neither joined again after a reconnect, nor counted as joined until someone asks again
+  const bool bJoined = Channels.Remove(Chan) > 0;
+  const bool bRejoining = RejoinChannels.Remove(Chan) > 0;
+  AutoJoinChannels.Remove(Chan);
+  QuietJoins.Remove(Chan);
+
+  if (!bJoined && !bRejoining)
+    return false;
+
+  JoinScheduler.Cancel(Chan);
+
+  if (bJoined && bConnected && Hooks.SendText)
+    Hooks.SendText(TEXT("PART #") + Chan + TEXT("\r\n"));
+
+  NotifyChannels();
+  return true;
+}
+
+void FTMIClient::RequeueJoins(const TArray<FString>& Joining, const TArray<FString>& Unconfirmed, double Now)
+{
+  for (const FString& Channel : Joining)
+  {
+    if (Channels.Contains(Channel))
+      QuietJoins.Add(Channel);
+
+    JoinScheduler.Request(Channel, Now);
+  }
+
+  for (const FString& Channel : Unconfirmed)
+  {
+    if (Channels.Contains(Channel))
+      QuietJoins.Add(Channel);
+  }
+
+  PumpJoins(Now);
+}
+
+bool FTMIClient::Send(const FString& Channel, const FString& Message, double Now)
+{
+  if (Channel.IsEmpty() || Message.IsEmpty())
+    return true;
+
+  const bool bWhole = OutboundQueue.Enqueue(Channel, Message, Now);
+  PumpOutbound(Now);
+  return bWhole;
+}
+
+bool FTMIClient::Broadcast(const FString& Message, double Now)
+{
+  return BroadcastTo(Channels, Message, Now);
+}
+
+bool FTMIClient::BroadcastTo(const TArray<FString>& ToChannels, const FString& Message, double Now)
+{
+  if (Message.IsEmpty())
+    return true;
+
+  // Queue everything first so the lines that may go out right away share a frame
+  const bool bWhole = OutboundQueue.EnqueueBroadcast(ToChannels, Message, Now);
+  PumpOutbound(Now);
+  return bWhole;
+}
+
+void FTMIClient::SendControl(const FString& Line, double Now)
+{
+  OutboundQueue.EnqueueControl(Line);
+  PumpOutbound(Now);
+}
+
+void FTMIClient::PumpJoins(double Now)
+{
+  if (!bConnected || !Hooks.SendText)
+    return;
+
+  JoinScheduler.Pump(Now, [this](const FString& Line)
+  {
+    Hooks.SendText(Line + TEXT("\r\n"));
+  });
+}
+
+void FTMIClient::PumpOutbound(double Now)
+{
+  if (!bConnected || !Hooks.SendUtf8)
+    return;
+
+  OutboundQueue.Pump(Now, [this](const uint8* Data, int32 Size)
+  {
+    Hooks.SendUtf8(Data, Size);
+  });
+}
+
+void FTMIClient::PumpControl()
+{
+  if (!bConnected || !Hooks.SendUtf8)
+    return;
+
+  OutboundQueue.PumpControl([this](const uint8* Data, int32 Size)
+  {
+    Hooks.SendUtf8(Data, Size);
+  });
+}
+
+bool FTMIClient::Tick(double Now)
+{
+  const bool bHealthy = Health.Tick(Now, [this, Now](const FString& Nonce)
+  {
+    SendControl(TEXT("PING :") + Nonce, Now);
+  });
+
+  if (!bHealthy)
+    Reconnect(Now);
+
+  if (ReconnectPolicy.IsDue(Now))
+  {
+    ReconnectPolicy.OnAttempt();
+
+    if (!bConnected && Hooks.Connect)
+      Hooks.Connect();
+  }
+
+  Pump(Now);
+  return bHealthy;
+}
+
+void FTMIClient::Pump(double Now)
+{
+  PumpJoins(Now);
+  PumpOutbound(Now);
+}
+
+bool FTMIClient::NeedsTick() const
+{
+  return !OutboundQueue.IsEmpty() || JoinScheduler.HasPending() || ReconnectPolicy.IsScheduled() || Health.IsRunning()
+    || Ingress.HasQueued();
+}
+
+void FTMIClient::ShareRateLimits(const FTMIClient& Other)
+{
+  JoinScheduler.ShareBucket(Other.JoinScheduler.GetBucket());
+  OutboundQueue.ShareBuckets(Other.OutboundQueue.GetConnectionBucket(), Other.OutboundQueue.GetUserBucket());
+}
+
+void FTMIClient::SetHealthThresholds(float ProbeInterval, float ProbeTimeout, float StaleSeconds)
+{
+  HealthProbeInterval = ProbeInterval;
+  HealthProbeTimeout = ProbeTimeout;
+  StaleConnectionSeconds = StaleSeconds;
+}
+
+void FTMIClient::StartHealthMonitor(double Now)
+{
+  if (HealthProbeInterval <= 0.f && StaleConnectionSeconds <= 0.f)
+    return;
+
+  Health.SetThresholds(HealthProbeInterval, HealthProbeTimeout, StaleConnectionSeconds);
+  Health.Start(Now);
+}
+
+void FTMIClient::GetLoginLines(TArray<FString>& OutLines) const
+{
+  if (!bFastMode)
+    OutLines.Add(TEXT("CAP REQ :twitch.tv/tags"));
+
+  OutLines.Add(TEXT("CAP REQ :twitch.tv/commands"));
+  OutLines.Add(TEXT("PASS oauth:") + Password);
+  OutLines.Add(TEXT("NICK ") + Username);
+}
+
+void FTMIClient::NotifyChannels()
+{
+  if (Hooks.ChannelsChanged)
+    Hooks.ChannelsChanged(Channels);
+}
@@ -0,0 +1,199 @@
+#include "TMIClient.h"
+
+BEGIN_DEFINE_SPEC(TMIClientSpec, "TMIClient", EAutomationTestFlags::ProductFilter | EAutomationTestFlags::ApplicationContextMask)
+
+TUniquePtr<FTMIClient> Client;
+TArray<FString> Sent;
+int32 Connects = 0;
+int32 Closes = 0;
+
+void Record(const FString& Text)
+{
+  TArray<FString> Lines;
+  Text.ParseIntoArray(Lines, TEXT("\r\n"));
+  Sent.Append(Lines);
+}
+
+// Feeds a line through the same path a socket would
+void Receive(const FString& Line, double Now)
+{
+  Client->ReceiveFrame(Line + TEXT("\r\n"));
+  Client->Drain(Now);
+}
+
+END_DEFINE_SPEC(TMIClientSpec);
+
+void TMIClientSpec::Define()
+{
+  BeforeEach([this]()
+  {
+    Client = MakeUnique<FTMIClient>();
+    Sent.Reset();
+    Connects = 0;
+    Closes = 0;
+
+    FTMIClientHooks Hooks;
+    Hooks.SendText = [this](const FString& Text) { Record(Text); };
+    Hooks.SendUtf8 = [this](const uint8* Data, int32 Size)
+    {
+      const FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(Data), Size);
+      Record(FString(Converted.Length(), Converted.Get()));
+    };
+    Hooks.Connect = [this]() { ++Connects; };
+    Hooks.Close = [this]() { ++Closes; };
+    Client->SetHooks(MoveTemp(Hooks));
+
+    Client->SetHealthThresholds(0.f, 0.f, 0.f);
+    Client->Start(TEXT("Bot"), TEXT("secret"), { TEXT("Ronni") }, true, true);
+  });
+
+  It("should log in once connected and join after authenticating", [this]()
+  {
+    TestEqual("Connects", Connects, 1);
+    TestEqual("Nothing Before Connecting", Sent.Num(), 0);
+
+    Client->OnConnected(0.0);
+    TestEqual("Login", FString::Join(Sent, TEXT("|")), FString(TEXT("CAP REQ :twitch.tv/commands|PASS oauth:secret|NICK bot")));
+
+    Sent.Reset();
+    Receive(TEXT(":tmi.twitch.tv GLOBALUSERSTATE"), 0.0);
+
+    TestTrue("Authenticated", Client->IsAuthenticated());
+    TestEqual("Join", FString::Join(Sent, TEXT("|")), FString(TEXT("JOIN #ronni")));
+    TestEqual("Channels", Client->GetChannels().Num(), 1);
+  });
+
+  It("should answer PINGs without dispatching them", [this]()
+  {
+    Client->OnConnected(0.0);
+    Sent.Reset();
+
+    Client->ReceiveFrame(TEXT("PING :tmi.twitch.tv\r\n"));
+    TestEqual("Dispatched", Client->Drain(0.0), 0);
+
+    if (TestEqual("Sent", Sent.Num(), 1))
+      TestEqual("Pong", Sent[0], FString(TEXT("PONG :tmi.twitch.tv")));
+  });
+
+  It("should hand typed messages to its events without our own echo", [this]()
+  {
+    TArray<FString> Chat;
+    bool bAuthenticated = false;
+
+    FTMIClientEvents Events;
+    Events.Authenticated = [&bAuthenticated](FGlobalUserStateMessage& Message) { bAuthenticated = true; };
+    Events.ChatMessage = [&Chat](FPrivMsgMessage& Message) { Chat.Add(Message.Message); };
+    Client->SetEvents(MoveTemp(Events));
+    Client->SetIgnoredLogins({ TEXT("nightbot") });
+
+    Client->OnConnected(0.0);
+    Receive(TEXT(":tmi.twitch.tv GLOBALUSERSTATE"), 0.0);
+    Receive(TEXT(":bot!bot@bot.tmi.twitch.tv PRIVMSG #ronni :echo"), 0.0);
+    Receive(TEXT(":nightbot!nightbot@nightbot.tmi.twitch.tv PRIVMSG #ronni :!commands"), 0.0);
+    Receive(TEXT(":ronni!ronni@ronni.tmi.twitch.tv PRIVMSG #ronni :hi"), 0.0);
+
+    TestTrue("Authenticated", bAuthenticated);
+    TestEqual("Chat", Chat, TArray<FString>({ TEXT("hi") }));
+  });
+
+  It("should report a refused login", [this]()
+  {
+    bool bFailed = false;
+    int32 Notices = 0;
+
+    FTMIClientEvents Events;
+    Events.AuthFailed = [&bFailed]() { bFailed = true; };
+    Events.Notice = [&Notices](FNoticeMessage& Message) { ++Notices; };
+    Client->SetEvents(MoveTemp(Events));
+
+    Client->OnConnected(0.0);
+    Receive(TEXT(":tmi.twitch.tv NOTICE * :Login authentication failed"), 0.0);
+
+    TestTrue("Failed", bFailed);
+    TestEqual("Notices", Notices, 0);
+  });
+
+  It("should rejoin its channels after reconnecting", [this]()
+  {
+    Client->OnConnected(0.0);
+    Receive(TEXT(":tmi.twitch.tv GLOBALUSERSTATE"), 0.0);
+    Client->JoinChannel(TEXT("Foo"), 0.0);
+
+    const double Delay = Client->OnConnectionLost(1.0);
+    TestTrue("Scheduled", Delay >= 0.0);
+    TestTrue("Needs Tick", Client->NeedsTick());
+
+    Client->Tick(1.0 + Delay);
+    TestEqual("Reconnected", Connects, 2);
+
+    Sent.Reset();
+    Client->OnConnected(2.0 + Delay);
+    Receive(TEXT(":tmi.twitch.tv GLOBALUSERSTATE"), 2.0 + Delay);
+
+    TestEqual("Rejoined", Sent.Last(), FString(TEXT("JOIN #ronni,#foo")));
+  });
+
+  It("should not rejoin parted channels after reconnecting", [this]()
+  {
+    Client->OnConnected(0.0);
+    Receive(TEXT(":tmi.twitch.tv GLOBALUSERSTATE"), 0.0);
+    Client->JoinChannel(TEXT("Foo"), 0.0);
+
+    Sent.Reset();
+    TestTrue("Parted", Client->PartChannel(TEXT("foo")));
+    TestEqual("Part", FString::Join(Sent, TEXT("|")), FString(TEXT("PART #foo")));
+    TestEqual("Channels", Client->GetChannels(), TArray<FString>({ TEXT("ronni") }));
+
+    Client->OnConnectionLost(1.0);
+    Sent.Reset();
+    Client->OnConnected(100.0);
+    Receive(TEXT(":tmi.twitch.tv GLOBALUSERSTATE"), 100.0);
+    TestEqual("Rejoined", Sent.Last(), FString(TEXT("JOIN #ronni")));
+
+    TestTrue("Joined Again", Client->JoinChannel(TEXT("foo"), 100.0));
+    TestEqual("Join", Sent.Last(), FString(TEXT("JOIN #foo")));
+  });
+
+  It("should keep backing off while connections drop before the login", [this]()
+  {
+    double Now = 0.0;
+
+    for (int32 Attempt = 0; Attempt < 3; ++Attempt)
+    {
+      Client->OnConnected(Now);
+      Now += FMath::Max(Client->OnConnectionLost(Now), 0.0);
+      Client->Tick(Now);
+    }
+
+    TestEqual("Failures", Client->GetReconnectStats(Now).ConsecutiveFailures, 3);
+
+    Client->OnConnected(Now);
+    Receive(TEXT(":tmi.twitch.tv GLOBALUSERSTATE"), Now);
+    TestEqual("Reset", Client->GetReconnectStats(Now).ConsecutiveFailures, 0);
+  });
+
+  It("should keep queued chat across reconnects", [this]()
+  {
+    Client->Send(TEXT("ronni"), TEXT("hello"), 0.0);
+    Client->Reconnect(0.0);
+
+    Sent.Reset();
+    Client->OnConnected(1.0);
+    TestEqual("Login Then Chat", Sent.Last(), FString(TEXT("PRIVMSG #ronni :hello")));
+  });
+
+  It("should part, quit and close when stopped", [this]()
+  {
+    Client->OnConnected(0.0);
+    Receive(TEXT(":tmi.twitch.tv GLOBALUSERSTATE"), 0.0);
+    Sent.Reset();
+
+    Client->Stop();
+
+    TestEqual("Goodbye", FString::Join(Sent, TEXT("|")), FString(TEXT("PART #ronni|QUIT :Goodbye")));
+    TestEqual("Closes", Closes, 1);
+    TestFalse("Started", Client->IsStarted());
+    TestEqual("Channels", Client->GetChannels().Num(), 0);
+    TestFalse("Needs Tick", Client->NeedsTick());
+  });
+}
@@ -0,0 +1,206 @@
+#include "TMIDuplicateDetector.h"
+
+static uint64 MixHash(uint64 Value)
+{
+  // splitmix64 finalizer, spreads the rolling hash over all 64 bits
+  Value += 0x9E3779B97F4A7C15ull;
+  Value = (Value ^ (Value >> 30)) * 0xBF58476D1CE4E5B9ull;
+  Value = (Value ^ (Value >> 27)) * 0x94D049BB133111EBull;
+  return Value ^ (Value >> 31);
+}
+
+void FTMIDuplicateDetector::SetWindow(float InWindowSeconds)
+{
+  WindowSeconds = FMath::Max(InWindowSeconds, 0.1f);
+}
+
+uint64 FTMIDuplicateDetector::Fingerprint(const FString& Text, bool& bOutHasText)
+{
+  constexpr uint64 Base = 1099511628211ull;
+  uint64 BasePow = 1;
+
+  for (int32 Index = 1; Index < ShingleLength; ++Index)
+    BasePow *= Base;
+
+  // Normalized characters of the current shingle, a single space stands in for any whitespace run
+  TCHAR Window[ShingleLength];
+  int32 Length = 0;
+  uint64 Rolling = 0;
+  int32 Weights[64] = {};
+  int32 Shingles = 0;
+  bool bPendingSpace = false;
+
+  auto AddFeature = [&Weights, &Shingles](uint64 Feature)
+  {
+    const uint64 Hash = MixHash(Feature);
+
+    for (int32 Bit = 0; Bit < 64; ++Bit)
+      Weights[Bit] += (Hash >> Bit) & 1 ? 1 : -1;
+
+    ++Shingles;
+  };
+
+  auto Push = [&](TCHAR Char)
+  {
+    if (Length >= ShingleLength)
+      Rolling -= Window[Length % ShingleLength] * BasePow;
+
+    Rolling = Rolling * Base + Char;
+    Window[Length % ShingleLength] = Char;
+
+    if (++Length >= ShingleLength)
+      AddFeature(Rolling);
+
+    // Keep Length in [ShingleLength, 2 * ShingleLength) once full so the ring index keeps working
+    if (Length == 2 * ShingleLength)
+      Length = ShingleLength;
+  };
+
+  for (TCHAR Char : Text)
+  {
+    if (FChar::IsWhitespace(Char))
+    {
+      bPendingSpace = Length > 0;
+      continue;
+    }
+
+    if (Char < 128 && FChar::IsPunct(Char))
+      continue;
+
+    if (bPendingSpace)
+    {
+      Push(TCHAR(' '));
+      bPendingSpace = false;
+    }
+
+    Push(FChar::ToLower(Char));
+  }
+
+  bOutHasText = Length > 0;
+
+  // Too short for a single shingle, the whole text is the only feature
+  if (Shingles == 0)
+    return MixHash(Rolling);
+
+  uint64 Result = 0;
+
+  for (int32 Bit = 0; Bit < 64; ++Bit)
+  {
+    if (Weights[Bit] > 0)
+      Result |= 1ull << Bit;
+  }
+
+  return Result;
+}
+
+bool FTMIDuplicateDetector::Observe(const FString& Channel, const FString& Text, double Now, int32& OutClusterID, int32& OutCount)
+{
+  bool bHasText;
+  const uint64 Print = Fingerprint(Text, bHasText);
+
+  if (!bHasText)
+    return false;
+
+  FChannelClusters& State = Channels.FindOrAdd(Channel);
+
+  if (Now >= State.NextSweep)
+    Sweep(State, Now);
+
+  for (int32 Band = 0; Band < BandCount; ++Band)
+  {
+    for (TMultiMap<uint32, int32>::TConstKeyIterator It(State.Bands, GetBandKey(Print, Band)); It; ++It)
+    {
+      FCluster& Cluster = State.Clusters[It.Value()];
+
+      if (Cluster.LastSeen + WindowSeconds < Now || FMath::CountBits(Cluster.Fingerprint ^ Print) > MaxDistance)
+        continue;
+
+      Cluster.Count += 1;
+      Cluster.LastSeen = Now;
+
+      OutClusterID = It.Value();
+      OutCount = Cluster.Count;
+      return true;
+    }
+  }
+
+  if (State.Clusters.Num() >= MaxClustersPerChannel)
+  {
+    Sweep(State, Now);
+
+    // Still full of live clusters, make room by dropping the one seen longest ago
+    if (State.Clusters.Num() >= MaxClustersPerChannel)
+    {
+      int32 Oldest = INDEX_NONE;
+      double OldestSeen = Now;
+
+      for (const TPair<int32, FCluster>& Pair : State.Clusters)
+      {
+        if (Pair.Value.LastSeen <= OldestSeen)
+        {
+          Oldest = Pair.Key;
+          OldestSeen = Pair.Value.LastSeen;
+        }
+      }
+
+      RemoveCluster(State, Oldest);
+    }
+  }
+
+  const int32 ClusterID = NextClusterID++;
+  FCluster& Cluster = State.Clusters.Add(ClusterID);
+  Cluster.Fingerprint = Print;
+  Cluster.Count = 1;
+  Cluster.LastSeen = Now;
+
+  for (int32 Band = 0; Band < BandCount; ++Band)
+    State.Bands.Add(GetBandKey(Print, Band), ClusterID);
+
+  OutClusterID = ClusterID;
+  OutCount = 1;
+  return true;
+}
+
+uint32 FTMIDuplicateDetector::GetBandKey(uint64 Print, int32 Band)
+{
+  return (static_cast<uint32>(Band) << 16) | static_cast<uint32>((Print >> (Band * 16)) & 0xFFFF);
+}
+
+void FTMIDuplicateDetector::RemoveCluster(FChannelClusters& Channel, int32 ClusterID)
+{
+  const FCluster* Cluster = Channel.Clusters.Find(ClusterID);
+
+  if (!Cluster)
+    return;
+
+  for (int32 Band = 0; Band < BandCount; ++Band)
+    Channel.Bands.RemoveSingle(GetBandKey(Cluster->Fingerprint, Band), ClusterID);
+
+  Channel.Clusters.Remove(ClusterID);
+}
+
+void FTMIDuplicateDetector::Sweep(FChannelClusters& Channel, double Now) const
+{
+  TArray<int32, TInlineAllocator<64>> Expired;
+
+  for (const TPair<int32, FCluster>& Pair : Channel.Clusters)
+  {
+    if (Pair.Value.LastSeen + WindowSeconds < Now)
+      Expired.Add(Pair.Key);
+  }
+
+  for (int32 ClusterID : Expired)
+    RemoveCluster(Channel, ClusterID);
+
+  Channel.NextSweep = Now + WindowSeconds * 0.25;
+}
+
+void FTMIDuplicateDetector::Remove(const FString& Channel)
+{
+  Channels.Remove(Channel);
+}
+
+void FTMIDuplicateDetector::Reset()
+{
+  Channels.Reset();
+}
@@ -0,0 +1,55 @@
+#include "TMIDuplicateDetector.h"
+
+BEGIN_DEFINE_SPEC(TMIDuplicateDetectorSpec, "TMIDuplicateDetector", EAutomationTestFlags::ProductFilter | EAutomationTestFlags::ApplicationContextMask)
+
+FTMIDuplicateDetector Detector;
+int32 FirstCluster;
+int32 ClusterID;
+int32 Count;
+
+END_DEFINE_SPEC(TMIDuplicateDetectorSpec);
+
+void TMIDuplicateDetectorSpec::Define()
+{
+  BeforeEach([this]()
+  {
+    Detector.Reset();
+    Detector.SetWindow(30.f);
+  });
+
+  It("should cluster messages that only differ in case, spacing and punctuation", [this]()
+  {
+    TestTrue("First", Detector.Observe(TEXT("ronni"), TEXT("This is the best stream on twitch"), 0.0, FirstCluster, Count));
+    TestEqual("First Count", Count, 1);
+
+    TestTrue("Second", Detector.Observe(TEXT("ronni"), TEXT("THIS is the   best stream on twitch!!!"), 1.0, ClusterID, Count));
+    TestEqual("Same Cluster", ClusterID, FirstCluster);
+    TestEqual("Second Count", Count, 2);
+  });
+
+  It("should keep different messages and channels apart", [this]()
+  {
+    Detector.Observe(TEXT("ronni"), TEXT("This is the best stream on twitch"), 0.0, FirstCluster, Count);
+
+    Detector.Observe(TEXT("ronni"), TEXT("what game is this"), 1.0, ClusterID, Count);
+    TestNotEqual("Different Text", ClusterID, FirstCluster);
+
+    Detector.Observe(TEXT("other"), TEXT("This is the best stream on twitch"), 1.0, ClusterID, Count);
+    TestNotEqual("Different Channel", ClusterID, FirstCluster);
+    TestEqual("Count", Count, 1);
+  });
+
+  It("should start a new cluster once the window passed", [this]()
+  {
+    Detector.Observe(TEXT("ronni"), TEXT("copy pasta"), 0.0, FirstCluster, Count);
+    Detector.Observe(TEXT("ronni"), TEXT("copy pasta"), 31.0, ClusterID, Count);
+
+    TestNotEqual("New Cluster", ClusterID, FirstCluster);
+    TestEqual("Count", Count, 1);
+  });
+
+  It("should ignore messages without text", [this]()
+  {
+    TestFalse("Punctuation Only", Detector.Observe(TEXT("ronni"), TEXT(" ?!. "), 0.0, ClusterID, Count));
+  });
+}
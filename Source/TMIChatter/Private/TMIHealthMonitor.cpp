@@ -0,0 +1,103 @@
+#include "TMIHealthMonitor.h"
+
+void FTMIHealthMonitor::SetThresholds(double InProbeInterval, double InProbeTimeout, double InStaleAfter)
+{
+  ProbeInterval = InProbeInterval;
+  ProbeTimeout = InProbeTimeout;
+  StaleAfter = InStaleAfter;
+}
+
+void FTMIHealthMonitor::Start(double Now)
+{
+  bRunning = true;
+  LastReceive = Now;
+  NextProbeAt = Now + ProbeInterval;
+  ProbeNonce.Reset();
+}
+
+void FTMIHealthMonitor::Stop()
+{
+  bRunning = false;
+  ProbeNonce.Reset();
+}
+
+bool FTMIHealthMonitor::OnPong(const FString& Nonce, double Now)
+{
+  if (ProbeNonce.IsEmpty() || Nonce != ProbeNonce)
+    return false;
+
+  const double RoundTrip = Now - ProbeSentAt;
+  const double Milliseconds = FMath::Max(RoundTrip * 1000.0, 1.0);
+
+  ++Histogram[FMath::Clamp(FMath::CeilToInt(FMath::Log2(Milliseconds)), 0, NumBuckets - 1)];
+  ++ProbesAnswered;
+  LastRoundTrip = RoundTrip;
+  TotalRoundTrip += RoundTrip;
+  MaxRoundTrip = FMath::Max(MaxRoundTrip, RoundTrip);
+
+  ProbeNonce.Reset();
+  return true;
+}
+
+bool FTMIHealthMonitor::Tick(double Now, TFunctionRef<void(const FString& Nonce)> SendProbe)
+{
+  if (!bRunning)
+    return true;
+
+  if (!ProbeNonce.IsEmpty() && Now - ProbeSentAt > ProbeTimeout)
+  {
+    ++ProbesLost;
+    ProbeNonce.Reset();
+    return false;
+  }
+
+  if (StaleAfter > 0.0 && Now - LastReceive > StaleAfter)
+    return false;
+
+  if (ProbeInterval > 0.0 && ProbeNonce.IsEmpty() && Now >= NextProbeAt)
+  {
+    ProbeNonce = FString::Printf(TEXT("probe-%u"), ++NonceCounter);
+    ProbeSentAt = Now;
+    NextProbeAt = Now + ProbeInterval;
+    ++ProbesSent;
+    SendProbe(ProbeNonce);
+  }
+
+  return true;
+}
+
+double FTMIHealthMonitor::GetBucketUpperBound(int32 Bucket)
+{
+  return static_cast<double>(1 << Bucket) / 1000.0;
+}
+
+double FTMIHealthMonitor::GetPercentile(double Fraction) const
+{
+  const int32 Needed = FMath::CeilToInt(ProbesAnswered * Fraction);
+  int32 Count = 0;
+
+  for (int32 Bucket = 0; Bucket < NumBuckets; ++Bucket)
+  {
+    Count += Histogram[Bucket];
+
+    if (Count >= Needed && Count > 0)
+      return FMath::Min(GetBucketUpperBound(Bucket), MaxRoundTrip);
+  }
+
+  return 0.0;
+}
+
+FTWConnectionHealth FTMIHealthMonitor::GetHealth(double Now) const
+{
+  FTWConnectionHealth Health;
+  Health.LastRoundTripSeconds = static_cast<float>(LastRoundTrip);
+  Health.AverageRoundTripSeconds = ProbesAnswered > 0 ? static_cast<float>(TotalRoundTrip / ProbesAnswered) : 0.f;
+  Health.MedianRoundTripSeconds = static_cast<float>(GetPercentile(0.5));
+  Health.P95RoundTripSeconds = static_cast<float>(GetPercentile(0.95));
+  Health.MaxRoundTripSeconds = static_cast<float>(MaxRoundTrip);
+  Health.SecondsSinceLastReceive = bRunning ? static_cast<float>(Now - LastReceive) : 0.f;
+  Health.ProbesSent = ProbesSent;
+  Health.ProbesLost = ProbesLost;
+  Health.RoundTripHistogram.Append(Histogram, NumBuckets);
+  return Health;
+}
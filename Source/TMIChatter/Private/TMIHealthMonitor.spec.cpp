@@ -0,0 +1,73 @@
+#include "TMIHealthMonitor.h"
+
+BEGIN_DEFINE_SPEC(TMIHealthMonitorSpec, "TMIHealthMonitor", EAutomationTestFlags::ProductFilter | EAutomationTestFlags::ApplicationContextMask)
+
+TUniquePtr<FTMIHealthMonitor> Monitor;
+TArray<FString> Probes;
+
+bool Tick(double Now)
+{
+  return Monitor->Tick(Now, [this](const FString& Nonce) { Probes.Add(Nonce); });
+}
+
+END_DEFINE_SPEC(TMIHealthMonitorSpec);
+
+void TMIHealthMonitorSpec::Define()
+{
+  BeforeEach([this]()
+  {
+    Monitor = MakeUnique<FTMIHealthMonitor>();
+    Monitor->SetThresholds(30.0, 10.0, 90.0);
+    Monitor->Start(0.0);
+    Probes.Reset();
+  });
+
+  It("should send a probe every interval and time its PONG", [this]()
+  {
+    TestTrue("Healthy", Tick(10.0));
+    TestEqual("Too Early", Probes.Num(), 0);
+
+    TestTrue("Healthy", Tick(30.0));
+
+    if (!TestEqual("Probe", Probes.Num(), 1))
+      return;
+
+    TestFalse("Wrong Nonce", Monitor->OnPong(TEXT("someone-else"), 30.05));
+    TestTrue("Our Nonce", Monitor->OnPong(Probes[0], 30.05));
+
+    const FTWConnectionHealth Health = Monitor->GetHealth(30.05);
+    TestEqual("Round Trip", Health.LastRoundTripSeconds, 0.05f, 0.001f);
+    TestEqual("Histogram", Health.RoundTripHistogram[6], 1);	// 50ms falls in the up to 64ms bucket
+    TestEqual("Median", Health.MedianRoundTripSeconds, 0.05f, 0.001f);
+  });
+
+  It("should give up on a probe that isn't answered in time", [this]()
+  {
+    Tick(30.0);
+    Monitor->OnReceive(35.0);
+
+    TestTrue("Waiting", Tick(40.0));
+    TestFalse("Lost", Tick(40.5));
+    TestEqual("Lost Probes", Monitor->GetHealth(40.5).ProbesLost, 1);
+  });
+
+  It("should report a connection nothing arrives on as dead", [this]()
+  {
+    Monitor->SetThresholds(0.0, 10.0, 90.0);
+    Monitor->Start(0.0);
+
+    TestTrue("Quiet", Tick(60.0));
+    Monitor->OnReceive(60.0);
+    TestTrue("Received", Tick(140.0));
+    TestEqual("Since Receive", Monitor->GetHealth(140.0).SecondsSinceLastReceive, 80.f);
+    TestFalse("Stale", Tick(151.0));
+    TestEqual("No Probes", Probes.Num(), 0);
+  });
+
+  It("should not check anything while stopped", [this]()
+  {
+    Monitor->Stop();
+    TestTrue("Stopped", Tick(1000.0));
+    TestEqual("No Probes", Probes.Num(), 0);
+  });
+}
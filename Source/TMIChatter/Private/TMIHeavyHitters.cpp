@@ -0,0 +1,248 @@
+#include "TMIHeavyHitters.h"
+#include "TMIParser.h"
+
+FTMIHeavyHitters::FTMIHeavyHitters(int32 Capacity)
+  : Capacity(FMath::Max(Capacity, 1))
+{
+}
+
+void FTMIHeavyHitters::Add(const FString& Key)
+{
+  ++Total;
+
+  if (const int32* Found = Index.Find(Key))
+  {
+    Increment(*Found);
+    return;
+  }
+
+  if (Counters.Num() < Capacity)
+  {
+    const int32 CounterIndex = Counters.AddDefaulted();
+    Counters[CounterIndex].Key = Key;
+    Index.Add(Key, CounterIndex);
+
+    // New keys start at 1, the lowest possible count
+    if (MinBucket == INDEX_NONE || Buckets[MinBucket].Count != 1)
+    {
+      MinBucket = AllocBucket(1, INDEX_NONE, MinBucket);
+
+      if (MaxBucket == INDEX_NONE)
+        MaxBucket = MinBucket;
+    }
+
+    Link(CounterIndex, MinBucket);
+    return;
+  }
+
+  // Replace the key with the lowest count, it inherits that count as its error
+  const int32 CounterIndex = Buckets[MinBucket].Head;
+  FCounter& Counter = Counters[CounterIndex];
+
+  Index.Remove(Counter.Key);
+  Counter.Key = Key;
+  Counter.Error = Buckets[MinBucket].Count;
+  Index.Add(Key, CounterIndex);
+
+  Increment(CounterIndex);
+}
+
+void FTMIHeavyHitters::Increment(int32 CounterIndex)
+{
+  const int32 From = Counters[CounterIndex].Bucket;
+  const int64 NewCount = Buckets[From].Count + 1;
+  int32 To = Buckets[From].Next;
+
+  if (To == INDEX_NONE || Buckets[To].Count != NewCount)
+  {
+    To = AllocBucket(NewCount, From, To);
+
+    if (MaxBucket == From)
+      MaxBucket = To;
+  }
+
+  Unlink(CounterIndex);
+  Link(CounterIndex, To);
+}
+
+void FTMIHeavyHitters::Unlink(int32 CounterIndex)
+{
+  FCounter& Counter = Counters[CounterIndex];
+  FBucket& Bucket = Buckets[Counter.Bucket];
+
+  if (Counter.Prev != INDEX_NONE)
+    Counters[Counter.Prev].Next = Counter.Next;
+  else
+    Bucket.Head = Counter.Next;
+
+  if (Counter.Next != INDEX_NONE)
+    Counters[Counter.Next].Prev = Counter.Prev;
+
+  if (Bucket.Head == INDEX_NONE)
+    FreeBucket(Counter.Bucket);
+
+  Counter.Bucket = Counter.Prev = Counter.Next = INDEX_NONE;
+}
+
+void FTMIHeavyHitters::Link(int32 CounterIndex, int32 BucketIndex)
+{
+  FCounter& Counter = Counters[CounterIndex];
+  FBucket& Bucket = Buckets[BucketIndex];
+
+  Counter.Bucket = BucketIndex;
+  Counter.Prev = INDEX_NONE;
+  Counter.Next = Bucket.Head;
+
+  if (Bucket.Head != INDEX_NONE)
+    Counters[Bucket.Head].Prev = CounterIndex;
+
+  Bucket.Head = CounterIndex;
+}
+
+int32 FTMIHeavyHitters::AllocBucket(int64 Count, int32 Prev, int32 Next)
+{
+  const int32 BucketIndex = FreeBuckets.Num() > 0 ? FreeBuckets.Pop() : Buckets.AddDefaulted();
+  FBucket& Bucket = Buckets[BucketIndex];
+
+  Bucket.Count = Count;
+  Bucket.Head = INDEX_NONE;
+  Bucket.Prev = Prev;
+  Bucket.Next = Next;
+
+  if (Prev != INDEX_NONE)
+    Buckets[Prev].Next = BucketIndex;
+
+  if (Next != INDEX_NONE)
+    Buckets[Next].Prev = BucketIndex;
+
+  return BucketIndex;
+}
+
+void FTMIHeavyHitters::FreeBucket(int32 BucketIndex)
+{
+  const FBucket& Bucket = Buckets[BucketIndex];
+
+  if (Bucket.Prev != INDEX_NONE)
+    Buckets[Bucket.Prev].Next = Bucket.Next;
+  else
+    MinBucket = Bucket.Next;
+
+  if (Bucket.Next != INDEX_NONE)
+    Buckets[Bucket.Next].Prev = Bucket.Prev;
+  else
+    MaxBucket = Bucket.Prev;
+
+  FreeBuckets.Add(BucketIndex);
+}
+
+void FTMIHeavyHitters::GetTop(int32 Count, TArray<FTWHeavyHitter>& OutTop) const
+{
+  OutTop.Reset();
+
+  for (int32 BucketIndex = MaxBucket; BucketIndex != INDEX_NONE && OutTop.Num() < Count; BucketIndex = Buckets[BucketIndex].Prev)
+  {
+    for (int32 CounterIndex = Buckets[BucketIndex].Head; CounterIndex != INDEX_NONE && OutTop.Num() < Count; CounterIndex = Counters[CounterIndex].Next)
+    {
+      FTWHeavyHitter& Hitter = OutTop.AddDefaulted_GetRef();
+      Hitter.Key = Counters[CounterIndex].Key;
+      Hitter.Count = Buckets[BucketIndex].Count;
+      Hitter.Error = Counters[CounterIndex].Error;
+    }
+  }
+}
+
+void FTMIHeavyHitters::Reset()
+{
+  Total = 0;
+  Counters.Reset();
+  Buckets.Reset();
+  FreeBuckets.Reset();
+  Index.Reset();
+  MinBucket = MaxBucket = INDEX_NONE;
+}
+
+void FTMIChannelTrends::SetCapacity(int32 InCapacity)
+{
+  Capacity = FMath::Max(InCapacity, 0);
+  Channels.Reset();
+}
+
+void FTMIChannelTrends::Add(const FPrivMsgMessage& Message)
+{
+  if (Capacity == 0)
+    return;
+
+  FTrends* Trends = Channels.Find(Message.Channel);
+
+  if (!Trends)
+    Trends = &Channels.Add(Message.Channel, FTrends(Capacity));
+
+  for (const TPair<FString, FTWEmoteData>& Emote : Message.Tags.Emotes)
+  {
+    for (int32 Use = 0; Use < Emote.Value.EmotePositions.Num(); ++Use)
+      Trends->Emotes.Add(Emote.Key);
+  }
+
+  // Words are taken from the text runs only, so emotes, mentions and links don't show up as words
+  TArray<FTWMessageRun> LocalRuns;
+  const TArray<FTWMessageRun>* Runs = &Message.Runs;
+
+  if (Message.Runs.Num() == 0)
+  {
+    TMIParser::TokenizeMessage(Message.Message, Message.Tags.Emotes, Message.Tags.Bits > 0, LocalRuns);
+    Runs = &LocalRuns;
+  }
+
+  const TCHAR* Chars = *Message.Message;
+
+  for (const FTWMessageRun& Run : *Runs)
+  {
+    if (Run.Type != ETWMessageRunType::Text)
+      continue;
+
+    const int32 End = Run.Start + Run.Length;
+    int32 Start = Run.Start;
+
+    while (Start < End)
+    {
+      while (Start < End && !FChar::IsAlnum(Chars[Start]))
+        ++Start;
+
+      int32 WordEnd = Start;
+
+      while (WordEnd < End && (FChar::IsAlnum(Chars[WordEnd]) || Chars[WordEnd] == TCHAR('\'')))
+        ++WordEnd;
+
+      if (WordEnd > Start)
+        Trends->Words.Add(FString(WordEnd - Start, Chars + Start).ToLower());
+
+      Start = WordEnd;
+    }
+  }
+}
+
+void FTMIChannelTrends::GetTopEmotes(const FString& Channel, int32 Count, TArray<FTWHeavyHitter>& OutTop) const
+{
+  OutTop.Reset();
+
+  if (const FTrends* Trends = Channels.Find(Channel))
+    Trends->Emotes.GetTop(Count, OutTop);
+}
+
+void FTMIChannelTrends::GetTopWords(const FString& Channel, int32 Count, TArray<FTWHeavyHitter>& OutTop) const
+{
+  OutTop.Reset();
+
+  if (const FTrends* Trends = Channels.Find(Channel))
+    Trends->Words.GetTop(Count, OutTop);
+}
+
+void FTMIChannelTrends::Remove(const FString& Channel)
+{
+  Channels.Remove(Channel);
+}
+
+void FTMIChannelTrends::Reset()
+{
+  Channels.Reset();
+}
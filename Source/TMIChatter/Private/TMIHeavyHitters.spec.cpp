@@ -0,0 +1,71 @@
+#include "TMIHeavyHitters.h"
+#include "TMIParser.h"
+
+BEGIN_DEFINE_SPEC(TMIHeavyHittersSpec, "TMIHeavyHitters", EAutomationTestFlags::ProductFilter | EAutomationTestFlags::ApplicationContextMask)
+
+TArray<FTWHeavyHitter> Top;
+
+END_DEFINE_SPEC(TMIHeavyHittersSpec);
+
+void TMIHeavyHittersSpec::Define()
+{
+  It("should count exactly while under capacity", [this]()
+  {
+    FTMIHeavyHitters Hitters(4);
+
+    for (const TCHAR* Key : { TEXT("a"), TEXT("b"), TEXT("a"), TEXT("c"), TEXT("a"), TEXT("b") })
+      Hitters.Add(Key);
+
+    Hitters.GetTop(2, Top);
+
+    if (TestEqual("Top Count", Top.Num(), 2))
+    {
+      TestTrue("First", Top[0].Key == TEXT("a") && Top[0].Count == 3 && Top[0].Error == 0);
+      TestTrue("Second", Top[1].Key == TEXT("b") && Top[1].Count == 2 && Top[1].Error == 0);
+    }
+  });
+
+  It("should keep frequent keys through a stream of rare ones", [this]()
+  {
+    FTMIHeavyHitters Hitters(10);
+
+    for (int32 Index = 0; Index < 1000; ++Index)
+    {
+      Hitters.Add(TEXT("Kappa"));
+      Hitters.Add(FString::FromInt(Index));
+
+      if (Index % 2 == 0)
+        Hitters.Add(TEXT("PogChamp"));
+    }
+
+    Hitters.GetTop(2, Top);
+
+    if (TestEqual("Top Count", Top.Num(), 2))
+    {
+      TestEqual("First", Top[0].Key, FString(TEXT("Kappa")));
+      TestEqual("Second", Top[1].Key, FString(TEXT("PogChamp")));
+      TestTrue("Within Error", Top[0].Count - Top[0].Error <= 1000 && Top[0].Count >= 1000);
+    }
+
+    TestEqual("Total", Hitters.GetTotal(), (int64)2500);
+  });
+
+  It("should split a channel's messages into emotes and words", [this]()
+  {
+    FTMIChannelTrends Trends;
+    Trends.SetCapacity(10);
+
+    FPrivMsgMessage Message;
+    Message.Channel = TEXT("ronni");
+    Message.Message = TEXT("Kappa GG, gg @ronni Kappa");
+    Message.Tags.Emotes.Add(TEXT("25"), FTWEmoteData({ FTWEmotePositions(0, 4), FTWEmotePositions(20, 24) }));
+
+    Trends.Add(Message);
+
+    Trends.GetTopEmotes(TEXT("ronni"), 5, Top);
+    TestTrue("Emote", Top.Num() == 1 && Top[0].Key == TEXT("25") && Top[0].Count == 2);
+
+    Trends.GetTopWords(TEXT("ronni"), 5, Top);
+    TestTrue("Words", Top.Num() == 1 && Top[0].Key == TEXT("gg") && Top[0].Count == 2);
+  });
+}
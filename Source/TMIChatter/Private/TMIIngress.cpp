@@ -0,0 +1,47 @@
+#include "TMIIngress.h"
+
+void FTMIIngress::ReceiveFrame(const FString& Frame)
+{
+  TArray<FString> FrameLines;
+  Frame.ParseIntoArray(FrameLines, TEXT("\r\n"));
+
+  for (FString& Line : FrameLines)
+    ReceiveLine(MoveTemp(Line));
+}
+
+void FTMIIngress::ReceiveLine(FString&& Line)
+{
+  if (Line.IsEmpty())
+    return;
+
+  bReceived.store(true, std::memory_order_relaxed);
+
+  // Twitch's PING never has tags or a prefix, so this is the whole check
+  if (SendPong && Line.StartsWith(TEXT("PING "), ESearchCase::CaseSensitive))
+  {
+    SendPong(TEXT("PONG ") + Line.RightChop(5));
+    PingsAnswered.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  Lines.Enqueue(MoveTemp(Line));
+}
+
+int32 FTMIIngress::Drain(TFunctionRef<void(const FString& Line)> Dispatch)
+{
+  int32 Count = 0;
+  FString Line;
+
+  while (Lines.Dequeue(Line))
+  {
+    Dispatch(Line);
+    ++Count;
+  }
+
+  return Count;
+}
+
+void FTMIIngress::Reset()
+{
+  Lines.Empty();
+}
@@ -0,0 +1,76 @@
+#include "TMIIngress.h"
+#include "Async/ParallelFor.h"
+
+BEGIN_DEFINE_SPEC(TMIIngressSpec, "TMIIngress", EAutomationTestFlags::ProductFilter | EAutomationTestFlags::ApplicationContextMask)
+
+TUniquePtr<FTMIIngress> Ingress;
+TArray<FString> Pongs;
+TArray<FString> Dispatched;
+
+void Drain()
+{
+  Ingress->Drain([this](const FString& Line) { Dispatched.Add(Line); });
+}
+
+END_DEFINE_SPEC(TMIIngressSpec);
+
+void TMIIngressSpec::Define()
+{
+  BeforeEach([this]()
+  {
+    Ingress = MakeUnique<FTMIIngress>();
+    Pongs.Reset();
+    Dispatched.Reset();
+
+    Ingress->SetPongSender([this](const FString& Line) { Pongs.Add(Line); });
+  });
+
+  It("should answer PING right away instead of queueing it", [this]()
+  {
+    Ingress->ReceiveFrame(TEXT("PING :tmi.twitch.tv\r\n:ronni!ronni@ronni.tmi.twitch.tv PRIVMSG #ronni :hi\r\n"));
+
+    if (TestEqual("Pongs", Pongs.Num(), 1))
+      TestEqual("Pong", Pongs[0], FString(TEXT("PONG :tmi.twitch.tv")));
+
+    TestEqual("Not Dispatched Yet", Dispatched.Num(), 0);
+    TestTrue("Queued", Ingress->HasQueued());
+    TestTrue("Received", Ingress->TakeReceived());
+    TestFalse("Taken", Ingress->TakeReceived());
+
+    Drain();
+
+    if (TestEqual("Dispatched", Dispatched.Num(), 1))
+      TestTrue("Chat Line", Dispatched[0].EndsWith(TEXT("PRIVMSG #ronni :hi")));
+  });
+
+  It("should keep the order of queued lines", [this]()
+  {
+    Ingress->ReceiveFrame(TEXT("a\r\nb\r\n"));
+    Ingress->ReceiveLine(TEXT("c"));
+    Drain();
+
+    TestEqual("Order", FString::Join(Dispatched, TEXT(",")), FString(TEXT("a,b,c")));
+  });
+
+  It("should take lines from several threads at once", [this]()
+  {
+    FCriticalSection PongLock;
+    int32 PongCount = 0;
+
+    Ingress->SetPongSender([&PongLock, &PongCount](const FString& Line)
+    {
+      FScopeLock Lock(&PongLock);
+      ++PongCount;
+    });
+
+    ParallelFor(1000, [this](int32 Index)
+    {
+      Ingress->ReceiveLine(Index % 10 == 0 ? FString(TEXT("PING :tmi.twitch.tv")) : FString::Printf(TEXT("line %d"), Index));
+    });
+
+    Drain();
+    TestEqual("Dispatched", Dispatched.Num(), 900);
+    TestEqual("Pongs", PongCount, 100);
+    TestEqual("Pings Answered", Ingress->GetPingsAnswered(), (int64)100);
+  });
+}
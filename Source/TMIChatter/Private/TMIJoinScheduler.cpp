@@ -0,0 +1,99 @@
+#include "TMIJoinScheduler.h"
+
+FTMIJoinScheduler::FTMIJoinScheduler()
+  : JoinBucket(MakeShared<FTMITokenBucket>(JoinLimit, JoinPeriod))
+{
+}
+
+bool FTMIJoinScheduler::Request(const FString& Channel, double Now)
+{
+  if (Channel.IsEmpty() || RequestedAt.Contains(Channel))
+    return false;
+
+  RequestedAt.Add(Channel, Now);
+  Pending.Add(Channel);
+  ++Requested;
+  return true;
+}
+
+void FTMIJoinScheduler::Cancel(const FString& Channel)
+{
+  if (Pending.Remove(Channel) > 0)
+    --Requested;
+
+  RequestedAt.Remove(Channel);
+}
+
+void FTMIJoinScheduler::TakePending(TArray<FString>& OutChannels)
+{
+  for (const FString& Channel : Pending)
+    RequestedAt.Remove(Channel);
+
+  Requested -= Pending.Num();
+  OutChannels.Append(MoveTemp(Pending));
+  Pending.Reset();
+}
+
+void FTMIJoinScheduler::Pump(double Now, TFunctionRef<void(const FString& Line)> Emit)
+{
+  int32 Next = 0;
+
+  while (Next < Pending.Num() && JoinBucket->HasToken(Now))
+  {
+    FString Line = TEXT("JOIN #") + Pending[Next];
+    JoinBucket->Consume();
+    ++Next;
+
+    while (Next < Pending.Num() && Line.Len() + 2 + Pending[Next].Len() <= MaxLineLength && JoinBucket->HasToken(Now))
+    {
+      Line += TEXT(",#");
+      Line += Pending[Next];
+      JoinBucket->Consume();
+      ++Next;
+    }
+
+    Emit(Line);
+  }
+
+  Sent += Next;
+  Pending.RemoveAt(0, Next);
+}
+
+double FTMIJoinScheduler::OnJoined(const FString& Channel, double Now)
+{
+  double RequestTime;
+
+  if (!RequestedAt.RemoveAndCopyValue(Channel, RequestTime))
+    return -1.0;
+
+  // Twitch may confirm channels we still hold back, if someone else sent the JOIN
+  if (Pending.Remove(Channel) > 0)
+    ++Sent;
+
+  const double Latency = Now - RequestTime;
+
+  ++Joined;
+  TotalLatency += Latency;
+  MaxLatency = FMath::Max(MaxLatency, Latency);
+  return Latency;
+}
+
+FTWJoinProgress FTMIJoinScheduler::GetProgress() const
+{
+  FTWJoinProgress Progress;
+  Progress.Requested = Requested;
+  Progress.Sent = Sent;
+  Progress.Joined = Joined;
+  Progress.Pending = Pending.Num();
+  Progress.AverageLatencySeconds = Joined > 0 ? static_cast<float>(TotalLatency / Joined) : 0.f;
+  Progress.MaxLatencySeconds = static_cast<float>(MaxLatency);
+  return Progress;
+}
+
+void FTMIJoinScheduler::Reset()
+{
+  Pending.Reset();
+  RequestedAt.Reset();
+  Requested = Sent = Joined = 0;
+  TotalLatency = MaxLatency = 0.0;
+}
@@ -0,0 +1,92 @@
+#include "TMIJoinScheduler.h"
+
+BEGIN_DEFINE_SPEC(TMIJoinSchedulerSpec, "TMIJoinScheduler", EAutomationTestFlags::ProductFilter | EAutomationTestFlags::ApplicationContextMask)
+
+TUniquePtr<FTMIJoinScheduler> Scheduler;
+TArray<FString> Lines;
+
+void Pump(double Now)
+{
+  Scheduler->Pump(Now, [this](const FString& Line) { Lines.Add(Line); });
+}
+
+END_DEFINE_SPEC(TMIJoinSchedulerSpec);
+
+void TMIJoinSchedulerSpec::Define()
+{
+  BeforeEach([this]()
+  {
+    Scheduler = MakeUnique<FTMIJoinScheduler>();
+    Lines.Reset();
+  });
+
+  It("should batch channels into one JOIN line", [this]()
+  {
+    Scheduler->Request(TEXT("a"), 0.0);
+    Scheduler->Request(TEXT("b"), 0.0);
+    Scheduler->Request(TEXT("c"), 0.0);
+    TestFalse("Duplicate Request", Scheduler->Request(TEXT("a"), 0.0));
+
+    Pump(0.0);
+
+    if (TestEqual("Lines", Lines.Num(), 1))
+      TestEqual("Line", Lines[0], FString(TEXT("JOIN #a,#b,#c")));
+
+    TestEqual("Sent", Scheduler->GetProgress().Sent, 3);
+  });
+
+  It("should pace joins at 20 channels per 10 seconds", [this]()
+  {
+    for (int32 Index = 0; Index < 50; ++Index)
+      Scheduler->Request(FString::Printf(TEXT("channel%d"), Index), 0.0);
+
+    Pump(0.0);
+    TestEqual("Burst", Scheduler->GetProgress().Sent, 20);
+    TestEqual("Pending", Scheduler->GetProgress().Pending, 30);
+
+    Pump(5.0);
+    TestEqual("Half Refilled", Scheduler->GetProgress().Sent, 30);
+  });
+
+  It("should keep lines within the IRC length limit", [this]()
+  {
+    for (int32 Index = 0; Index < 20; ++Index)
+      Scheduler->Request(FString::Printf(TEXT("%s%02d"), *FString::ChrN(40, TCHAR('x')), Index), 0.0);
+
+    Pump(0.0);
+
+    TestTrue("Split", Lines.Num() > 1);
+
+    for (const FString& Line : Lines)
+      TestTrue("Line Length", Line.Len() <= FTMIJoinScheduler::MaxLineLength);
+
+    TestEqual("Sent", Scheduler->GetProgress().Sent, 20);
+  });
+
+  It("should report join latency", [this]()
+  {
+    Scheduler->Request(TEXT("a"), 1.0);
+    Pump(1.0);
+
+    TestEqual("Latency", Scheduler->OnJoined(TEXT("a"), 1.5), 0.5);
+    TestTrue("Unrequested", Scheduler->OnJoined(TEXT("b"), 1.5) < 0.0);
+    TestEqual("Joined", Scheduler->GetProgress().Joined, 1);
+  });
+
+  It("should share the join limit with another scheduler", [this]()
+  {
+    FTMIJoinScheduler Other;
+    Other.ShareBucket(Scheduler->GetBucket());
+
+    for (int32 Index = 0; Index < 15; ++Index)
+      Scheduler->Request(FString::Printf(TEXT("a%d"), Index), 0.0);
+
+    for (int32 Index = 0; Index < 15; ++Index)
+      Other.Request(FString::Printf(TEXT("b%d"), Index), 0.0);
+
+    Pump(0.0);
+    Other.Pump(0.0, [](const FString& Line) {});
+
+    TestEqual("Left For Both", Scheduler->GetProgress().Sent + Other.GetProgress().Sent, 20);
+  });
+}
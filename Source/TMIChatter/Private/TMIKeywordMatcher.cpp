@@ -0,0 +1,186 @@
+#include "TMIKeywordMatcher.h"
+
+int32 FTMIKeywordMatcher::FAutomaton::GetSymbol(TCHAR Char) const
+{
+  if (bCaseInsensitive)
+    Char = FChar::ToLower(Char);
+
+  if (static_cast<uint32>(Char) < 128)
+    return AsciiSymbols[Char];
+
+  const int32* Symbol = Symbols.Find(Char);
+  return Symbol ? *Symbol : 0;
+}
+
+void FTMIKeywordMatcher::SetPatterns(const TArray<FString>& Patterns, bool bCaseInsensitive)
+{
+  FAutomatonPtr Compiled = Compile(Patterns, bCaseInsensitive);
+
+  FScopeLock Lock(&AutomatonLock);
+  Automaton = MoveTemp(Compiled);
+}
+
+void FTMIKeywordMatcher::Reset()
+{
+  FScopeLock Lock(&AutomatonLock);
+  Automaton.Reset();
+}
+
+bool FTMIKeywordMatcher::IsEmpty() const
+{
+  return !GetAutomaton().IsValid();
+}
+
+FTMIKeywordMatcher::FAutomatonPtr FTMIKeywordMatcher::GetAutomaton() const
+{
+  FScopeLock Lock(&AutomatonLock);
+  return Automaton;
+}
+
+bool FTMIKeywordMatcher::Scan(const FString& Text, TArray<FTWKeywordMatch>& OutMatches) const
+{
+  // Hold our own reference so a concurrent SetPatterns can't free the automaton mid scan
+  const FAutomatonPtr Current = GetAutomaton();
+
+  if (!Current.IsValid())
+    return false;
+
+  const FAutomaton& DFA = *Current;
+  const int32 StartNum = OutMatches.Num();
+  const TCHAR* Chars = *Text;
+  int32 State = 0;
+
+  for (int32 Index = 0, Len = Text.Len(); Index < Len; ++Index)
+  {
+    State = DFA.Transitions[State * DFA.NumSymbols + DFA.GetSymbol(Chars[Index])];
+
+    for (int32 Output = DFA.OutputStart[State]; Output < DFA.OutputStart[State + 1]; ++Output)
+    {
+      const int32 PatternID = DFA.Outputs[Output];
+      const int32 Length = DFA.PatternLengths[PatternID];
+      OutMatches.Emplace(PatternID, Index - Length + 1, Length);
+    }
+  }
+
+  return OutMatches.Num() > StartNum;
+}
+
+FTMIKeywordMatcher::FAutomatonPtr FTMIKeywordMatcher::Compile(const TArray<FString>& Patterns, bool bCaseInsensitive)
+{
+  TSharedRef<FAutomaton, ESPMode::ThreadSafe> DFA = MakeShared<FAutomaton, ESPMode::ThreadSafe>();
+  DFA->bCaseInsensitive = bCaseInsensitive;
+  FMemory::Memzero(DFA->AsciiSymbols);
+
+  // Dense alphabet of only the characters the patterns use, keeps the transition table small
+  auto AddSymbol = [&DFA](TCHAR Char) -> int32
+  {
+    if (static_cast<uint32>(Char) < 128)
+    {
+      if (DFA->AsciiSymbols[Char] == 0)
+        DFA->AsciiSymbols[Char] = DFA->NumSymbols++;
+
+      return DFA->AsciiSymbols[Char];
+    }
+
+    if (const int32* Symbol = DFA->Symbols.Find(Char))
+      return *Symbol;
+
+    return DFA->Symbols.Add(Char, DFA->NumSymbols++);
+  };
+
+  // Build the trie
+  TArray<TMap<int32, int32>> Children;
+  TArray<TArray<int32>> StateOutputs;
+  Children.AddDefaulted();
+  StateOutputs.AddDefaulted();
+
+  bool bAnyPattern = false;
+
+  for (int32 PatternID = 0; PatternID < Patterns.Num(); ++PatternID)
+  {
+    const FString& Pattern = Patterns[PatternID];
+    DFA->PatternLengths.Add(Pattern.Len());
+
+    if (Pattern.IsEmpty())
+      continue;
+
+    int32 State = 0;
+
+    for (TCHAR Char : Pattern)
+    {
+      const int32 Symbol = AddSymbol(bCaseInsensitive ? FChar::ToLower(Char) : Char);
+
+      if (const int32* Child = Children[State].Find(Symbol))
+      {
+        State = *Child;
+      }
+      else
+      {
+        const int32 NewState = Children.Num();
+        Children[State].Add(Symbol, NewState);
+        Children.AddDefaulted();
+        StateOutputs.AddDefaulted();
+        State = NewState;
+      }
+    }
+
+    StateOutputs[State].Add(PatternID);
+    bAnyPattern = true;
+  }
+
+  if (!bAnyPattern)
+    return nullptr;
+
+  // Breadth first so every failure link points at an already finished state
+  const int32 NumStates = Children.Num();
+  const int32 NumSymbols = DFA->NumSymbols;
+  TArray<int32> Fail;
+  TArray<int32> Queue;
+
+  DFA->Transitions.SetNumZeroed(NumStates * NumSymbols);
+  Fail.SetNumZeroed(NumStates);
+  Queue.Reserve(NumStates);
+
+  for (const TPair<int32, int32>& Child : Children[0])
+  {
+    DFA->Transitions[Child.Key] = Child.Value;
+    Queue.Add(Child.Value);
+  }
+
+  for (int32 Head = 0; Head < Queue.Num(); ++Head)
+  {
+    const int32 State = Queue[Head];
+    const int32 FailRow = Fail[State] * NumSymbols;
+    const int32 Row = State * NumSymbols;
+
+    for (int32 Symbol = 0; Symbol < NumSymbols; ++Symbol)
+    {
+      const int32* Child = Children[State].Find(Symbol);
+
+      if (Child)
+      {
+        Fail[*Child] = DFA->Transitions[FailRow + Symbol];
+        StateOutputs[*Child].Append(StateOutputs[Fail[*Child]]);
+        DFA->Transitions[Row + Symbol] = *Child;
+        Queue.Add(*Child);
+      }
+      else
+      {
+        DFA->Transitions[Row + Symbol] = DFA->Transitions[FailRow + Symbol];
+      }
+    }
+  }
+
+  // Flatten outputs
+  DFA->OutputStart.Reserve(NumStates + 1);
+
+  for (const TArray<int32>& Outputs : StateOutputs)
+  {
+    DFA->OutputStart.Add(DFA->Outputs.Num());
+    DFA->Outputs.Append(Outputs);
+  }
+
+  DFA->OutputStart.Add(DFA->Outputs.Num());
+
+  return DFA;
+}
@@ -0,0 +1,66 @@
+#include "TMIKeywordMatcher.h"
+
+BEGIN_DEFINE_SPEC(TMIKeywordMatcherSpec, "TMIKeywordMatcher", EAutomationTestFlags::ProductFilter | EAutomationTestFlags::ApplicationContextMask)
+
+FTMIKeywordMatcher Matcher;
+TArray<FTWKeywordMatch> Matches;
+
+bool HasMatch(int32 PatternID, int32 Start, int32 Length) const
+{
+  return Matches.ContainsByPredicate([&](const FTWKeywordMatch& Match)
+  {
+    return Match.PatternID == PatternID && Match.Start == Start && Match.Length == Length;
+  });
+}
+
+END_DEFINE_SPEC(TMIKeywordMatcherSpec);
+
+void TMIKeywordMatcherSpec::Define()
+{
+  BeforeEach([this]()
+  {
+    Matcher.Reset();
+    Matches.Reset();
+  });
+
+  It("should not match anything without patterns", [this]()
+  {
+    TestTrue("Empty", Matcher.IsEmpty());
+    TestFalse("Scan", Matcher.Scan(TEXT("anything"), Matches));
+
+    Matcher.SetPatterns({ TEXT("") }, false);
+    TestTrue("Only Empty Patterns", Matcher.IsEmpty());
+  });
+
+  It("should find overlapping and nested patterns in one pass", [this]()
+  {
+    Matcher.SetPatterns({ TEXT("he"), TEXT("she"), TEXT("his"), TEXT("hers") }, false);
+
+    TestTrue("Scan", Matcher.Scan(TEXT("ushers"), Matches));
+    TestEqual("Match Count", Matches.Num(), 3);
+    TestTrue("she", HasMatch(1, 1, 3));
+    TestTrue("he", HasMatch(0, 2, 2));
+    TestTrue("hers", HasMatch(3, 2, 4));
+  });
+
+  It("should fold case only when asked to", [this]()
+  {
+    Matcher.SetPatterns({ TEXT("Kappa") }, false);
+    TestFalse("Case Sensitive", Matcher.Scan(TEXT("KAPPA kappa"), Matches));
+
+    Matcher.SetPatterns({ TEXT("Kappa") }, true);
+    TestTrue("Case Insensitive", Matcher.Scan(TEXT("KAPPA kappa"), Matches));
+    TestTrue("First", HasMatch(0, 0, 5));
+    TestTrue("Second", HasMatch(0, 6, 5));
+  });
+
+  It("should keep pattern IDs stable around empty patterns and characters outside the alphabet", [this]()
+  {
+    Matcher.SetPatterns({ TEXT(""), TEXT("gg"), TEXT("\u00e9t\u00e9") }, true);
+
+    TestTrue("Scan", Matcher.Scan(TEXT("\u00e9t\u00e9 GGG"), Matches));
+    TestTrue("Non ASCII", HasMatch(2, 0, 3));
+    TestTrue("gg", HasMatch(1, 4, 2));
+    TestTrue("gg Overlap", HasMatch(1, 5, 2));
+  });
+}
@@ -0,0 +1,66 @@
+#include "TMILineSplitter.h"
+
+FTMILineSplitter::FTMILineSplitter(int32 InMaxLineBytes, int32 InInitialBytes)
+  : MaxLineBytes(InMaxLineBytes)
+  , InitialBytes(FMath::Min(InInitialBytes, InMaxLineBytes))
+{
+  Buffer.SetNumUninitialized(InitialBytes);
+}
+
+uint8* FTMILineSplitter::GetWritable(int32& OutSize)
+{
+  // Only a single line can fill the buffer, it's compacted after every commit
+  if (Used == Buffer.Num())
+  {
+    if (Buffer.Num() >= MaxLineBytes)
+    {
+      OutSize = 0;
+      return nullptr;
+    }
+
+    Buffer.SetNumUninitialized(FMath::Min(Buffer.Num() * 2, MaxLineBytes));
+  }
+
+  OutSize = Buffer.Num() - Used;
+  return Buffer.GetData() + Used;
+}
+
+void FTMILineSplitter::Commit(int32 Size, TFunctionRef<void(FString&& Line)> OnLine)
+{
+  Used += Size;
+
+  const uint8* Data = Buffer.GetData();
+  int32 Start = 0;
+
+  for (int32 Index = Scanned; Index < Used; ++Index)
+  {
+    if (Data[Index] != '\n')
+      continue;
+
+    const int32 End = (Index > Start && Data[Index - 1] == '\r') ? Index - 1 : Index;
+
+    if (End > Start)
+    {
+      const FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(Data + Start), End - Start);
+      OnLine(FString(Converted.Length(), Converted.Get()));
+    }
+
+    Start = Index + 1;
+  }
+
+  // Only the partial line is moved to the front
+  if (Start > 0)
+  {
+    Used -= Start;
+    FMemory::Memmove(Buffer.GetData(), Buffer.GetData() + Start, Used);
+  }
+
+  Scanned = Used;
+}
+
+void FTMILineSplitter::Reset()
+{
+  Buffer.SetNumUninitialized(InitialBytes);
+  Used = 0;
+  Scanned = 0;
+}
@@ -0,0 +1,98 @@
+#include "TMILineSplitter.h"
+
+BEGIN_DEFINE_SPEC(TMILineSplitterSpec, "TMILineSplitter", EAutomationTestFlags::ProductFilter | EAutomationTestFlags::ApplicationContextMask)
+
+TUniquePtr<FTMILineSplitter> Splitter;
+TArray<FString> Lines;
+
+// Copies Text into the splitter the way a socket read would, in as many reads as it takes
+bool Read(const FString& Text)
+{
+  const FTCHARToUTF8 Converted(*Text, Text.Len());
+  const uint8* Data = reinterpret_cast<const uint8*>(Converted.Get());
+  int32 Left = Converted.Length();
+
+  while (Left > 0)
+  {
+    int32 Size = 0;
+    uint8* Into = Splitter->GetWritable(Size);
+
+    if (Into == nullptr)
+      return false;
+
+    Size = FMath::Min(Size, Left);
+    FMemory::Memcpy(Into, Data, Size);
+    Data += Size;
+    Left -= Size;
+
+    Splitter->Commit(Size, [this](FString&& Line) { Lines.Add(MoveTemp(Line)); });
+  }
+
+  return true;
+}
+
+END_DEFINE_SPEC(TMILineSplitterSpec);
+
+void TMILineSplitterSpec::Define()
+{
+  BeforeEach([this]()
+  {
+    Splitter = MakeUnique<FTMILineSplitter>(64, 16);
+    Lines.Reset();
+  });
+
+  It("should strip CRLF and bare LF line ends", [this]()
+  {
+    Read(TEXT("a\r\nb\nc\r\n"));
+    TestEqual("Lines", Lines, TArray<FString>({ TEXT("a"), TEXT("b"), TEXT("c") }));
+  });
+
+  It("should keep a partial line until the rest is read", [this]()
+  {
+    Read(TEXT("PING :tmi"));
+    TestEqual("Nothing Yet", Lines.Num(), 0);
+    TestEqual("Pending", Splitter->GetPending(), 9);
+
+    Read(TEXT(".twitch.tv\r"));
+    TestEqual("Still Nothing", Lines.Num(), 0);
+
+    Read(TEXT("\nnext"));
+    TestEqual("Lines", Lines, TArray<FString>({ TEXT("PING :tmi.twitch.tv") }));
+    TestEqual("Partial Moved To The Front", Splitter->GetPending(), 4);
+  });
+
+  It("should skip empty lines", [this]()
+  {
+    Read(TEXT("\r\n\na\r\n\r\n"));
+    TestEqual("Lines", Lines, TArray<FString>({ TEXT("a") }));
+  });
+
+  It("should grow for a line longer than the first buffer", [this]()
+  {
+    const FString Long = FString::ChrN(40, TEXT('x'));
+
+    TestTrue("Read", Read(Long + TEXT("\r\n")));
+    TestEqual("Lines", Lines, TArray<FString>({ Long }));
+  });
+
+  It("should refuse a line longer than the maximum", [this]()
+  {
+    TestFalse("Read", Read(FString::ChrN(100, TEXT('x'))));
+    TestEqual("Lines", Lines.Num(), 0);
+  });
+
+  It("should decode UTF-8 split across reads", [this]()
+  {
+    const uint8 Bytes[] = { 'h', 'i', ' ', 0xC3 };
+    const uint8 Rest[] = { 0xA9, '\r', '\n' };
+
+    int32 Size = 0;
+    FMemory::Memcpy(Splitter->GetWritable(Size), Bytes, sizeof(Bytes));
+    Splitter->Commit(sizeof(Bytes), [this](FString&& Line) { Lines.Add(MoveTemp(Line)); });
+    FMemory::Memcpy(Splitter->GetWritable(Size), Rest, sizeof(Rest));
+    Splitter->Commit(sizeof(Rest), [this](FString&& Line) { Lines.Add(MoveTemp(Line)); });
+
+    if (TestEqual("Lines", Lines.Num(), 1))
+      TestEqual("Line", Lines[0], FString(TEXT("hi \u00E9")));
+  });
+}
@@ -0,0 +1,70 @@
+#include "TMILoopbackTransport.h"
+
+void FTMILoopbackTransport::Connect()
+{
+  ++Connects;
+
+  if (!bHoldConnect)
+    Accept();
+}
+
+void FTMILoopbackTransport::Close()
+{
+  if (!bConnected)
+    return;
+
+  Drop(TEXT("Closed"));
+}
+
+void FTMILoopbackTransport::Send(const FString& Text)
+{
+  if (!bConnected)
+    return;
+
+  TArray<FString> Lines;
+  Text.ParseIntoArray(Lines, TEXT("\r\n"));
+
+  for (const FString& Line : Lines)
+  {
+    Sent.Add(Line);
+
+    if (OnSent)
+      OnSent(Line);
+  }
+}
+
+void FTMILoopbackTransport::Send(const uint8* Data, int32 Size)
+{
+  const FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(Data), Size);
+  Send(FString(Converted.Length(), Converted.Get()));
+}
+
+void FTMILoopbackTransport::Accept()
+{
+  bConnected = true;
+
+  if (Events.Connected)
+    Events.Connected();
+}
+
+void FTMILoopbackTransport::Receive(const FString& Line)
+{
+  if (bConnected && Events.Line)
+    Events.Line(CopyTemp(Line));
+}
+
+void FTMILoopbackTransport::Fail(const FString& Error)
+{
+  bConnected = false;
+
+  if (Events.Error)
+    Events.Error(Error);
+}
+
+void FTMILoopbackTransport::Drop(const FString& Reason)
+{
+  bConnected = false;
+
+  if (Events.Closed)
+    Events.Closed(Reason);
+}
@@ -0,0 +1,252 @@
+#include "TMIMessageHistory.h"
+
+void FTMIMessageHistory::SetDefaultCapacity(int32 Capacity)
+{
+  DefaultCapacity = FMath::Max(Capacity, 0);
+
+  for (TPair<FString, FChannelHistory>& Pair : Channels)
+  {
+    if (!ChannelCapacities.Contains(Pair.Key))
+      Resize(Pair.Value, DefaultCapacity);
+  }
+}
+
+void FTMIMessageHistory::SetChannelCapacity(const FString& Channel, int32 Capacity)
+{
+  const FString Chan = Channel.ToLower();
+  Capacity = FMath::Max(Capacity, 0);
+
+  ChannelCapacities.Add(Chan, Capacity);
+
+  if (FChannelHistory* History = Channels.Find(Chan))
+    Resize(*History, Capacity);
+}
+
+int32 FTMIMessageHistory::GetChannelCapacity(const FString& Channel) const
+{
+  const int32* Capacity = ChannelCapacities.Find(Channel);
+  return Capacity != nullptr ? *Capacity : DefaultCapacity;
+}
+
+FTMIMessageHistory::FChannelHistory* FTMIMessageHistory::FindOrAddHistory(const FString& Channel)
+{
+  if (FChannelHistory* History = Channels.Find(Channel))
+    return History->Slots.Num() > 0 ? History : nullptr;
+
+  const int32 Capacity = GetChannelCapacity(Channel);
+
+  if (Capacity <= 0)
+    return nullptr;
+
+  FChannelHistory& History = Channels.Add(Channel);
+  History.Slots.SetNum(Capacity);
+  return &History;
+}
+
+void FTMIMessageHistory::Add(const FPrivMsgMessage& Message)
+{
+  if (FChannelHistory* History = FindOrAddHistory(Message.Channel))
+    Insert(*History, Message);
+}
+
+void FTMIMessageHistory::Insert(FChannelHistory& History, const FPrivMsgMessage& Message)
+{
+  const int32 SlotIndex = History.Next;
+  History.Next = (History.Next + 1) % History.Slots.Num();
+
+  // The slot we overwrite holds the oldest message, which is also the tail of its user's chain
+  if (History.Slots[SlotIndex].bLive)
+    Unlink(History, SlotIndex);
+
+  FSlot& Slot = History.Slots[SlotIndex];
+  Slot.Message = Message;
+  Slot.bLive = true;
+  Slot.OlderByUser = INDEX_NONE;
+  Slot.NewerByUser = INDEX_NONE;
+
+  if (Message.Tags.ID.IsValid())
+    History.ByID.Add(Message.Tags.ID, SlotIndex);
+
+  if (!Message.Tags.UserID.IsEmpty())
+  {
+    int32& Newest = History.NewestByUser.FindOrAdd(Message.Tags.UserID, INDEX_NONE);
+
+    if (Newest != INDEX_NONE)
+    {
+      Slot.OlderByUser = Newest;
+      History.Slots[Newest].NewerByUser = SlotIndex;
+    }
+
+    Newest = SlotIndex;
+  }
+}
+
+void FTMIMessageHistory::Unlink(FChannelHistory& History, int32 SlotIndex)
+{
+  FSlot& Slot = History.Slots[SlotIndex];
+
+  if (Slot.Message.Tags.ID.IsValid())
+    History.ByID.Remove(Slot.Message.Tags.ID);
+
+  if (!Slot.Message.Tags.UserID.IsEmpty())
+  {
+    if (Slot.OlderByUser != INDEX_NONE)
+      History.Slots[Slot.OlderByUser].NewerByUser = Slot.NewerByUser;
+
+    if (Slot.NewerByUser != INDEX_NONE)
+    {
+      History.Slots[Slot.NewerByUser].OlderByUser = Slot.OlderByUser;
+    }
+    else if (Slot.OlderByUser != INDEX_NONE)
+    {
+      History.NewestByUser.Add(Slot.Message.Tags.UserID, Slot.OlderByUser);
+    }
+    else
+    {
+      History.NewestByUser.Remove(Slot.Message.Tags.UserID);
+    }
+  }
+
+  Slot.bLive = false;
+  Slot.OlderByUser = INDEX_NONE;
+  Slot.NewerByUser = INDEX_NONE;
+}
+
+bool FTMIMessageHistory::RemoveMessage(const FString& Channel, const FGuid& MessageID, TArray<FGuid>& OutRemovedIDs)
+{
+  FChannelHistory* History = Channels.Find(Channel);
+  const int32* SlotIndex = History != nullptr ? History->ByID.Find(MessageID) : nullptr;
+
+  if (SlotIndex == nullptr)
+    return false;
+
+  Unlink(*History, *SlotIndex);
+  OutRemovedIDs.Add(MessageID);
+  return true;
+}
+
+bool FTMIMessageHistory::RemoveUser(const FString& Channel, const FString& UserID, TArray<FGuid>& OutRemovedIDs)
+{
+  FChannelHistory* History = Channels.Find(Channel);
+  const int32* Newest = History != nullptr ? History->NewestByUser.Find(UserID) : nullptr;
+
+  if (Newest == nullptr)
+    return false;
+
+  int32 SlotIndex = *Newest;
+
+  while (SlotIndex != INDEX_NONE)
+  {
+    FSlot& Slot = History->Slots[SlotIndex];
+    const int32 Older = Slot.OlderByUser;
+
+    if (Slot.Message.Tags.ID.IsValid())
+    {
+      OutRemovedIDs.Add(Slot.Message.Tags.ID);
+      History->ByID.Remove(Slot.Message.Tags.ID);
+    }
+
+    Slot.bLive = false;
+    Slot.OlderByUser = INDEX_NONE;
+    Slot.NewerByUser = INDEX_NONE;
+    SlotIndex = Older;
+  }
+
+  History->NewestByUser.Remove(UserID);
+  return true;
+}
+
+bool FTMIMessageHistory::ClearChannel(const FString& Channel, TArray<FGuid>& OutRemovedIDs)
+{
+  FChannelHistory* History = Channels.Find(Channel);
+
+  if (History == nullptr)
+    return false;
+
+  bool bRemoved = false;
+
+  for (FSlot& Slot : History->Slots)
+  {
+    if (Slot.bLive)
+    {
+      if (Slot.Message.Tags.ID.IsValid())
+        OutRemovedIDs.Add(Slot.Message.Tags.ID);
+
+      Slot.bLive = false;
+      Slot.OlderByUser = INDEX_NONE;
+      Slot.NewerByUser = INDEX_NONE;
+      bRemoved = true;
+    }
+  }
+
+  History->ByID.Reset();
+  History->NewestByUser.Reset();
+  return bRemoved;
+}
+
+const FPrivMsgMessage* FTMIMessageHistory::Find(const FString& Channel, const FGuid& MessageID) const
+{
+  const FChannelHistory* History = Channels.Find(Channel);
+  const int32* SlotIndex = History != nullptr ? History->ByID.Find(MessageID) : nullptr;
+
+  return SlotIndex != nullptr ? &History->Slots[*SlotIndex].Message : nullptr;
+}
+
+void FTMIMessageHistory::GetMessages(const FString& Channel, TArray<FPrivMsgMessage>& OutMessages) const
+{
+  const FChannelHistory* History = Channels.Find(Channel);
+
+  if (History == nullptr)
+    return;
+
+  const int32 Capacity = History->Slots.Num();
+
+  for (int32 i = 0; i < Capacity; ++i)
+  {
+    const FSlot& Slot = History->Slots[(History->Next + i) % Capacity];
+
+    if (Slot.bLive)
+      OutMessages.Add(Slot.Message);
+  }
+}
+
+void FTMIMessageHistory::Resize(FChannelHistory& History, int32 Capacity)
+{
+  if (Capacity == History.Slots.Num())
+    return;
+
+  TArray<FSlot> OldSlots = MoveTemp(History.Slots);
+  const int32 OldNext = History.Next;
+
+  History.Slots.Reset();
+  History.Slots.SetNum(Capacity);
+  History.Next = 0;
+  History.ByID.Reset();
+  History.NewestByUser.Reset();
+
+  if (Capacity <= 0 || OldSlots.Num() == 0)
+    return;
+
+  // Gather the live messages oldest first and replay the newest ones that fit
+  TArray<int32> Live;
+
+  for (int32 i = 0; i < OldSlots.Num(); ++i)
+  {
+    const int32 SlotIndex = (OldNext + i) % OldSlots.Num();
+
+    if (OldSlots[SlotIndex].bLive)
+      Live.Add(SlotIndex);
+  }
+
+  for (int32 i = FMath::Max(Live.Num() - Capacity, 0); i < Live.Num(); ++i)
+  {
+    Insert(History, OldSlots[Live[i]].Message);
+  }
+}
+
+void FTMIMessageHistory::Reset()
+{
+  Channels.Reset();
+  ChannelCapacities.Reset();
+  DefaultCapacity = 0;
+}
@@ -0,0 +1,116 @@
+#include "TMIMessageHistory.h"
+
+BEGIN_DEFINE_SPEC(TMIMessageHistorySpec, "TMIMessageHistory", EAutomationTestFlags::ProductFilter | EAutomationTestFlags::ApplicationContextMask)
+
+FTMIMessageHistory History;
+TArray<FGuid> RemovedIDs;
+
+FPrivMsgMessage MakeMessage(const FString& UserID, const FString& Text)
+{
+  FPrivMsgMessage Message;
+  Message.Channel = TEXT("ronni");
+  Message.Message = Text;
+  Message.Tags.UserID = UserID;
+  Message.Tags.ID = FGuid::NewGuid();
+  return Message;
+}
+
+TArray<FString> GetTexts()
+{
+  TArray<FPrivMsgMessage> Messages;
+  TArray<FString> Texts;
+
+  History.GetMessages(TEXT("ronni"), Messages);
+
+  for (const FPrivMsgMessage& Message : Messages)
+    Texts.Add(Message.Message);
+
+  return Texts;
+}
+
+END_DEFINE_SPEC(TMIMessageHistorySpec);
+
+void TMIMessageHistorySpec::Define()
+{
+  BeforeEach([this]()
+  {
+    History.Reset();
+    History.SetDefaultCapacity(3);
+    RemovedIDs.Reset();
+  });
+
+  It("should keep only the newest messages up to its capacity", [this]()
+  {
+    for (const TCHAR* Text : { TEXT("a"), TEXT("b"), TEXT("c"), TEXT("d") })
+      History.Add(MakeMessage(TEXT("1"), Text));
+
+    TestEqual("Messages", GetTexts(), TArray<FString>({ TEXT("b"), TEXT("c"), TEXT("d") }));
+  });
+
+  It("should remove a single message by ID", [this]()
+  {
+    FPrivMsgMessage Target = MakeMessage(TEXT("1"), TEXT("b"));
+
+    History.Add(MakeMessage(TEXT("1"), TEXT("a")));
+    History.Add(Target);
+    History.Add(MakeMessage(TEXT("1"), TEXT("c")));
+
+    TestTrue("Removed", History.RemoveMessage(TEXT("ronni"), Target.Tags.ID, RemovedIDs));
+    TestEqual("Removed IDs", RemovedIDs, TArray<FGuid>({ Target.Tags.ID }));
+    TestTrue("Not Found", History.Find(TEXT("ronni"), Target.Tags.ID) == nullptr);
+    TestEqual("Messages", GetTexts(), TArray<FString>({ TEXT("a"), TEXT("c") }));
+  });
+
+  It("should purge every message of a user", [this]()
+  {
+    History.Add(MakeMessage(TEXT("1"), TEXT("a")));
+    History.Add(MakeMessage(TEXT("2"), TEXT("b")));
+    History.Add(MakeMessage(TEXT("1"), TEXT("c")));
+
+    TestTrue("Removed", History.RemoveUser(TEXT("ronni"), TEXT("1"), RemovedIDs));
+    TestEqual("Removed Count", RemovedIDs.Num(), 2);
+    TestEqual("Messages", GetTexts(), TArray<FString>({ TEXT("b") }));
+  });
+
+  It("should keep user chains intact when old messages are overwritten", [this]()
+  {
+    History.Add(MakeMessage(TEXT("1"), TEXT("a")));
+    History.Add(MakeMessage(TEXT("2"), TEXT("b")));
+    History.Add(MakeMessage(TEXT("1"), TEXT("c")));
+    History.Add(MakeMessage(TEXT("1"), TEXT("d")));
+
+    TestTrue("Removed", History.RemoveUser(TEXT("ronni"), TEXT("1"), RemovedIDs));
+    TestEqual("Removed Count", RemovedIDs.Num(), 2);
+    TestEqual("Messages", GetTexts(), TArray<FString>({ TEXT("b") }));
+  });
+
+  It("should keep the newest messages when its capacity shrinks", [this]()
+  {
+    History.Add(MakeMessage(TEXT("1"), TEXT("a")));
+    History.Add(MakeMessage(TEXT("2"), TEXT("b")));
+    History.Add(MakeMessage(TEXT("1"), TEXT("c")));
+
+    History.SetChannelCapacity(TEXT("ronni"), 2);
+
+    TestEqual("Messages", GetTexts(), TArray<FString>({ TEXT("b"), TEXT("c") }));
+    TestTrue("Chain Rebuilt", History.RemoveUser(TEXT("ronni"), TEXT("1"), RemovedIDs));
+    TestEqual("Removed Count", RemovedIDs.Num(), 1);
+  });
+
+  It("should not record channels with no capacity", [this]()
+  {
+    History.SetChannelCapacity(TEXT("ronni"), 0);
+    History.Add(MakeMessage(TEXT("1"), TEXT("a")));
+
+    TestEqual("Messages", GetTexts().Num(), 0);
+  });
+
+  It("should forget channel capacities when reset", [this]()
+  {
+    History.SetChannelCapacity(TEXT("ronni"), 1);
+    History.Reset();
+
+    TestEqual("Default Capacity", History.GetDefaultCapacity(), 0);
+    TestEqual("Channel Capacity", History.GetChannelCapacity(TEXT("ronni")), 0);
+  });
+}
@@ -0,0 +1,405 @@
+#include "TMIOutboundQueue.h"
+
+#include "Internationalization/BreakIterator.h"
+#include "Misc/ScopeLock.h"
+
+bool FTMITokenBucket::HasToken(double Now, double Count)
+{
+  Tokens = FMath::Min(Capacity, Tokens + (Now - LastRefill) * RefillPerSecond);
+  LastRefill = Now;
+  return Tokens >= Count;
+}
+
+FTMIOutboundQueue::FQueuedLine FTMIOutboundQueue::FLaneQueue::PopFront()
+{
+  FQueuedLine Line = MoveTemp(Lines[Head++]);
+
+  if (IsEmpty())
+  {
+    Lines.Reset();
+    Head = 0;
+  }
+
+  return Line;
+}
+
+FTMIOutboundQueue::FTMIOutboundQueue()
+  : ConnectionBucket(MakeShared<FTMITokenBucket>(ModeratorLimit, LimitPeriod)), UserBucket(MakeShared<FTMITokenBucket>(UserLimit, LimitPeriod))
+{
+}
+
+void FTMIOutboundQueue::Encode(const FString& Text, FEncodedText& Out)
+{
+  const int32 Length = FPlatformString::ConvertedLength<UTF8CHAR>(*Text, Text.Len());
+  const int32 Start = Out.AddUninitialized(Length);
+
+  FPlatformString::Convert(Out.GetData() + Start, Length, *Text, Text.Len());
+}
+
+FTMIOutboundQueue::FChannelQueue& FTMIOutboundQueue::FindOrAddChannel(const FString& Channel)
+{
+  // FString keys compare case insensitively, so no lowercase copy is needed to find a channel
+  if (FChannelQueue* Queue = Channels.Find(Channel))
+    return *Queue;
+
+  const FString Chan = Channel.ToLower();
+  FChannelQueue& Queue = Channels.Add(Chan);
+  Encode(TEXT("PRIVMSG #") + Chan + TEXT(" :"), Queue.Prefix);
+  return Queue;
+}
+
+bool FTMIOutboundQueue::Split(const FString& Message, TArray<FString>& OutParts)
+{
+  if (Message.Len() <= MaxMessageLength)
+  {
+    OutParts.Add(Message);
+    return true;
+  }
+
+  // Line break candidates sit after whitespace, character boundaries keep graphemes and surrogate pairs whole
+  TSharedRef<IBreakIterator> LineBreaks = FBreakIterator::CreateLineBreakIterator();
+  TSharedRef<IBreakIterator> Graphemes = FBreakIterator::CreateCharacterBoundaryIterator();
+  LineBreaks->SetString(*Message, Message.Len());
+  Graphemes->SetString(*Message, Message.Len());
+
+  int32 Start = 0;
+  const int32 FirstPart = OutParts.Num();
+
+  while (true)
+  {
+    while (Start < Message.Len() && FChar::IsWhitespace(Message[Start]))
+      ++Start;
+
+    if (Start >= Message.Len())
+      return true;
+
+    if (OutParts.Num() - FirstPart >= MaxMessageParts)
+      return false;
+
+    int32 End = Message.Len();
+
+    if (End - Start > MaxMessageLength)
+    {
+      const int32 Limit = Start + MaxMessageLength;
+      End = LineBreaks->MoveToCandidateBefore(Limit + 1);
+
+      // Rather cut a long word than leave a short part
+      if (End <= Start + MaxMessageLength / 2)
+        End = Graphemes->MoveToCandidateBefore(Limit + 1);
+
+      // A single grapheme over the limit, at least don't break a surrogate pair
+      if (End <= Start)
+        End = (Message[Limit - 1] & 0xFC00) == 0xD800 ? Limit - 1 : Limit;
+    }
+
+    int32 Last = End;
+
+    while (Last > Start && FChar::IsWhitespace(Message[Last - 1]))
+      --Last;
+
+    OutParts.Add(Message.Mid(Start, Last - Start));
+    Start = End;
+  }
+}
+
+bool FTMIOutboundQueue::EncodeParts(const FString& Message, TArray<TSharedRef<const FEncodedText>>& OutPayloads)
+{
+  TArray<FString> Parts;
+  const bool bWhole = Split(Message, Parts);
+
+  for (const FString& Part : Parts)
+  {
+    TSharedRef<FEncodedText> Payload = MakeShared<FEncodedText>();
+    Encode(Part, *Payload);
+    OutPayloads.Add(Payload);
+  }
+
+  return bWhole;
+}
+
+void FTMIOutboundQueue::Push(const FString& Channel, ETWOutboundLane Lane, const TSharedRef<const FEncodedText>& Payload, double Now, int32 GroupSize)
+{
+  FChannelQueue& Queue = FindOrAddChannel(Channel);
+
+  if (Queue.IsEmpty())
+    ActiveChannels.Add(Channel);
+
+  Queue.GetLane(Lane).Lines.Add({ Payload, Now, GroupSize });
+  ++QueuedLines;
+}
+
+void FTMIOutboundQueue::PushGroup(const FString& Channel, ETWOutboundLane Lane, const TArray<TSharedRef<const FEncodedText>>& Payloads, double Now)
+{
+  for (int32 i = 0; i < Payloads.Num(); ++i)
+    Push(Channel, Lane, Payloads[i], Now, i == 0 ? Payloads.Num() : 0);
+}
+
+bool FTMIOutboundQueue::IsModerationCommand(const FString& Message)
+{
+  static const TCHAR* Commands[] =
+  {
+    TEXT("ban"), TEXT("unban"), TEXT("timeout"), TEXT("untimeout"), TEXT("delete"), TEXT("clear"),
+    TEXT("slow"), TEXT("slowoff"), TEXT("followers"), TEXT("followersoff"), TEXT("subscribers"), TEXT("subscribersoff"),
+    TEXT("emoteonly"), TEXT("emoteonlyoff"), TEXT("uniquechat"), TEXT("uniquechatoff"),
+  };
+
+  if (Message.Len() < 2 || (Message[0] != '/' && Message[0] != '.'))
+    return false;
+
+  int32 End = 1;
+
+  while (End < Message.Len() && !FChar::IsWhitespace(Message[End]))
+    ++End;
+
+  const FStringView Command = FStringView(Message).Mid(1, End - 1);
+
+  for (const TCHAR* Candidate : Commands)
+  {
+    if (Command.Equals(Candidate, ESearchCase::IgnoreCase))
+      return true;
+  }
+
+  return false;
+}
+
+bool FTMIOutboundQueue::Enqueue(const FString& Channel, const FString& Message, double Now)
+{
+  const ETWOutboundLane Lane = IsModerationCommand(Message) ? ETWOutboundLane::Moderation : ETWOutboundLane::Chat;
+
+  if (Message.Len() <= MaxMessageLength)
+  {
+    TSharedRef<FEncodedText> Payload = MakeShared<FEncodedText>();
+    Encode(Message, *Payload);
+    Push(Channel, Lane, Payload, Now);
+    return true;
+  }
+
+  TArray<TSharedRef<const FEncodedText>> Payloads;
+  const bool bWhole = EncodeParts(Message, Payloads);
+  PushGroup(Channel, Lane, Payloads, Now);
+  return bWhole;
+}
+
+bool FTMIOutboundQueue::EnqueueBroadcast(const TArray<FString>& ToChannels, const FString& Message, double Now)
+{
+  const ETWOutboundLane Lane = IsModerationCommand(Message) ? ETWOutboundLane::Moderation : ETWOutboundLane::Chat;
+
+  if (Message.Len() <= MaxMessageLength)
+  {
+    TSharedRef<FEncodedText> Payload = MakeShared<FEncodedText>();
+    Encode(Message, *Payload);
+
+    for (const FString& Channel : ToChannels)
+      Push(Channel, Lane, Payload, Now);
+
+    return true;
+  }
+
+  TArray<TSharedRef<const FEncodedText>> Payloads;
+  const bool bWhole = EncodeParts(Message, Payloads);
+
+  for (const FString& Channel : ToChannels)
+    PushGroup(Channel, Lane, Payloads, Now);
+
+  return bWhole;
+}
+
+void FTMIOutboundQueue::EnqueueControl(const FString& Line)
+{
+  FEncodedText Encoded;
+  Encode(Line, Encoded);
+
+  FScopeLock Lock(&ControlLock);
+  ControlBuffer.Append(reinterpret_cast<const uint8*>(Encoded.GetData()), Encoded.Num());
+  ControlBuffer.Add('\r');
+  ControlBuffer.Add('\n');
+}
+
+void FTMIOutboundQueue::PumpControl(TFunctionRef<void(const uint8* Data, int32 Size)> Emit)
+{
+  // Pump emits under the same lock, frames from both threads go out one at a time and in order
+  FScopeLock Lock(&ControlLock);
+
+  if (ControlBuffer.Num() == 0)
+    return;
+
+  Emit(ControlBuffer.GetData(), ControlBuffer.Num());
+  ++FramesSent;
+  ControlBuffer.Reset();
+}
+
+void FTMIOutboundQueue::ResetControl()
+{
+  FScopeLock Lock(&ControlLock);
+  ControlBuffer.Reset();
+}
+
+bool FTMIOutboundQueue::IsEmpty() const
+{
+  FScopeLock Lock(&ControlLock);
+  return QueuedLines == 0 && ControlBuffer.Num() == 0;
+}
+
+void FTMIOutboundQueue::SetChannelLimits(const FString& Channel, bool bModerator, int32 SlowModeSeconds)
+{
+  FChannelQueue& Queue = FindOrAddChannel(Channel);
+  Queue.bModerator = bModerator;
+  Queue.SlowModeSeconds = SlowModeSeconds;
+}
+
+void FTMIOutboundQueue::MakeRoom(int32 LineSize, TFunctionRef<void(const uint8* Data, int32 Size)> Emit)
+{
+  if (SendBuffer.Num() > 0 && SendBuffer.Num() + LineSize > MaxFrameLength)
+  {
+    Emit(SendBuffer.GetData(), SendBuffer.Num());
+    ++FramesSent;
+    SendBuffer.Reset();
+  }
+}
+
+void FTMIOutboundQueue::Pump(double Now, TFunctionRef<void(const uint8* Data, int32 Size)> Emit)
+{
+  if (IsEmpty())
+    return;
+
+  // Held until the last frame is out, a PONG flushed by the receive thread meanwhile can't overtake the control lines
+  // taken here or reach the transport while we're emitting
+  FScopeLock Lock(&ControlLock);
+
+  // Control lines lead the first frame, whatever the buckets say
+  SendBuffer.Reset();
+  SendBuffer.Append(ControlBuffer);
+  ControlBuffer.Reset();
+
+  PumpLane(ETWOutboundLane::Moderation, Now, Emit);
+  PumpLane(ETWOutboundLane::Chat, Now, Emit);
+
+  ActiveChannels.RemoveAll([this](const FString& Channel) { return Channels[Channel].IsEmpty(); });
+
+  if (SendBuffer.Num() > 0)
+  {
+    Emit(SendBuffer.GetData(), SendBuffer.Num());
+    ++FramesSent;
+    SendBuffer.Reset();
+  }
+}
+
+void FTMIOutboundQueue::PumpLane(ETWOutboundLane Lane, double Now, TFunctionRef<void(const uint8* Data, int32 Size)> Emit)
+{
+  bool bProgress = true;
+
+  // One line per channel per round until nothing else may go out
+  while (bProgress && QueuedLines > 0)
+  {
+    bProgress = false;
+
+    for (int32 Step = 0, Num = ActiveChannels.Num(); Step < Num; ++Step)
+    {
+      const FString& Channel = ActiveChannels[(RoundRobin + Step) % Num];
+      FChannelQueue& Queue = Channels[Channel];
+      FLaneQueue& Pending = Queue.GetLane(Lane);
+
+      if (Pending.IsEmpty())
+        continue;
+
+      // The rest of a started group is neither paced nor interrupted by the channel's other lane
+      if (Pending.Reserved == 0 && (Queue.IsInGroup() || Now < Queue.NextAllowed))
+        continue;
+
+      // A group takes the tokens of all its lines up front, so once it started nothing can hold it up
+      if (Pending.Reserved == 0)
+      {
+        const double Cost = FMath::Max(Pending.Lines[Pending.Head].GroupSize, 1);
+        const bool bHolder = !HeldFor.IsEmpty() && HeldLane == Lane && HeldFor == Channel;
+        const double KeepConnection = bHolder ? 0.0 : HeldConnection;
+        const double KeepUser = bHolder ? 0.0 : HeldUser;
+
+        if (!ConnectionBucket->HasToken(Now, Cost + KeepConnection) || (!Queue.bModerator && !UserBucket->HasToken(Now, Cost + KeepUser)))
+        {
+          // The first group left waiting keeps what it needs, cheaper lines only get the rest
+          if (Cost > 1.0 && HeldFor.IsEmpty())
+          {
+            HeldFor = Channel;
+            HeldLane = Lane;
+            HeldConnection = Cost;
+            HeldUser = Queue.bModerator ? 0.0 : Cost;
+          }
+
+          continue;
+        }
+
+        ConnectionBucket->Consume(Cost);
+
+        if (!Queue.bModerator)
+          UserBucket->Consume(Cost);
+
+        if (bHolder)
+        {
+          HeldFor.Reset();
+          HeldConnection = 0.0;
+          HeldUser = 0.0;
+        }
+
+        Pending.Reserved = static_cast<int32>(Cost);
+      }
+
+      --Pending.Reserved;
+
+      if (!Queue.bModerator)
+        Queue.NextAllowed = Now + FMath::Max<double>(ChannelInterval, Queue.SlowModeSeconds);
+
+      const FQueuedLine Line = Pending.PopFront();
+      const double Wait = Now - Line.EnqueuedAt;
+
+      TotalWait += Wait;
+      MaxWait = FMath::Max(MaxWait, Wait);
+      ++LinesSent;
+      --QueuedLines;
+
+      MakeRoom(Queue.Prefix.Num() + Line.Payload->Num() + 2, Emit);
+
+      SendBuffer.Append(reinterpret_cast<const uint8*>(Queue.Prefix.GetData()), Queue.Prefix.Num());
+      SendBuffer.Append(reinterpret_cast<const uint8*>(Line.Payload->GetData()), Line.Payload->Num());
+      SendBuffer.Add('\r');
+      SendBuffer.Add('\n');
+      bProgress = true;
+    }
+
+    RoundRobin = ActiveChannels.Num() > 0 ? (RoundRobin + 1) % ActiveChannels.Num() : 0;
+  }
+}
+
+FTWOutboundStats FTMIOutboundQueue::GetStats(double Now) const
+{
+  FTWOutboundStats Stats;
+  Stats.QueueDepth = QueuedLines;
+  Stats.LinesSent = LinesSent;
+  Stats.FramesSent = FramesSent.load();
+  Stats.AverageWaitSeconds = LinesSent > 0 ? static_cast<float>(TotalWait / LinesSent) : 0.f;
+  Stats.MaxWaitSeconds = static_cast<float>(MaxWait);
+
+  for (const FString& Channel : ActiveChannels)
+  {
+    const FChannelQueue& Queue = Channels[Channel];
+
+    for (const FLaneQueue& Pending : Queue.Lanes)
+    {
+      if (!Pending.IsEmpty())
+        Stats.OldestWaitSeconds = FMath::Max<float>(Stats.OldestWaitSeconds, Now - Pending.Lines[Pending.Head].EnqueuedAt);
+    }
+  }
+
+  return Stats;
+}
+
+void FTMIOutboundQueue::Reset()
+{
+  Channels.Reset();
+  ActiveChannels.Reset();
+  HeldFor.Reset();
+  HeldConnection = 0.0;
+  HeldUser = 0.0;
+  ResetControl();
+  RoundRobin = 0;
+  QueuedLines = 0;
+}
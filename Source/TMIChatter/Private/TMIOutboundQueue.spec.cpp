@@ -0,0 +1,356 @@
+#include "TMIOutboundQueue.h"
+
+BEGIN_DEFINE_SPEC(TMIOutboundQueueSpec, "TMIOutboundQueue", EAutomationTestFlags::ProductFilter | EAutomationTestFlags::ApplicationContextMask)
+
+TUniquePtr<FTMIOutboundQueue> Queue;
+TArray<FString> Frames;
+
+int32 Pump(double Now)
+{
+  const int32 Before = Frames.Num();
+  Queue->Pump(Now, [this](const uint8* Data, int32 Size)
+  {
+    const FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(Data), Size);
+    Frames.Add(FString(Converted.Length(), Converted.Get()));
+  });
+  return Frames.Num() - Before;
+}
+
+int32 CountLines() const
+{
+  int32 Lines = 0;
+
+  for (const FString& Frame : Frames)
+  {
+    TArray<FString> Parts;
+    Lines += Frame.ParseIntoArray(Parts, TEXT("\r\n"));
+  }
+
+  return Lines;
+}
+
+END_DEFINE_SPEC(TMIOutboundQueueSpec);
+
+void TMIOutboundQueueSpec::Define()
+{
+  BeforeEach([this]()
+  {
+    Queue = MakeUnique<FTMIOutboundQueue>();
+    Frames.Reset();
+  });
+
+  It("should pack lines that may go out together into one CRLF terminated frame", [this]()
+  {
+    Queue->Enqueue(TEXT("a"), TEXT("hi"), 0.0);
+    Queue->Enqueue(TEXT("b"), TEXT("hi"), 0.0);
+
+    TestEqual("Frames", Pump(0.0), 1);
+    TestTrue("Both Lines", Frames[0] == TEXT("PRIVMSG #a :hi\r\nPRIVMSG #b :hi\r\n") || Frames[0] == TEXT("PRIVMSG #b :hi\r\nPRIVMSG #a :hi\r\n"));
+    TestTrue("Empty", Queue->IsEmpty());
+  });
+
+  It("should share the rate limits with queues of the same account", [this]()
+  {
+    FTMIOutboundQueue Other;
+    Other.ShareBuckets(Queue->GetConnectionBucket(), Queue->GetUserBucket());
+
+    for (int32 Index = 0; Index < 30; ++Index)
+    {
+      Queue->Enqueue(FString::Printf(TEXT("a%d"), Index), TEXT("hi"), 0.0);
+      Other.Enqueue(FString::Printf(TEXT("b%d"), Index), TEXT("hi"), 0.0);
+    }
+
+    Pump(0.0);
+    const int32 First = CountLines();
+
+    int32 OtherLines = 0;
+    Other.Pump(0.0, [&OtherLines](const uint8* Data, int32 Size)
+    {
+      for (int32 Index = 0; Index < Size; ++Index)
+        OtherLines += Data[Index] == '\n';
+    });
+
+    TestEqual("Shared User Limit", First + OtherLines, static_cast<int32>(FTMIOutboundQueue::UserLimit));
+  });
+
+  It("should pace a channel to one message a second unless we moderate it", [this]()
+  {
+    Queue->Enqueue(TEXT("a"), TEXT("1"), 0.0);
+    Queue->Enqueue(TEXT("a"), TEXT("2"), 0.0);
+
+    Pump(0.0);
+    TestEqual("First Second", CountLines(), 1);
+    Pump(0.5);
+    TestEqual("Still Waiting", CountLines(), 1);
+    Pump(1.0);
+    TestEqual("Next Second", CountLines(), 2);
+
+    Queue->SetChannelLimits(TEXT("m"), true, 0);
+    Queue->Enqueue(TEXT("m"), TEXT("1"), 1.0);
+    Queue->Enqueue(TEXT("m"), TEXT("2"), 1.0);
+    Pump(1.0);
+    TestEqual("Moderator", CountLines(), 4);
+  });
+
+  It("should respect slow mode", [this]()
+  {
+    Queue->SetChannelLimits(TEXT("a"), false, 5);
+    Queue->Enqueue(TEXT("a"), TEXT("1"), 0.0);
+    Queue->Enqueue(TEXT("a"), TEXT("2"), 0.0);
+
+    Pump(0.0);
+    Pump(4.0);
+    TestEqual("Slowed", CountLines(), 1);
+    Pump(5.0);
+    TestEqual("After Delay", CountLines(), 2);
+  });
+
+  It("should encode the channel prefix once and keep the payload's UTF-8", [this]()
+  {
+    Queue->Enqueue(TEXT("Ronni"), TEXT("caf\u00e9 \u2764"), 0.0);
+    Pump(0.0);
+
+    if (TestEqual("Frames", Frames.Num(), 1))
+      TestEqual("Line", Frames[0], FString(TEXT("PRIVMSG #ronni :caf\u00e9 \u2764\r\n")));
+  });
+
+  It("should stop at 20 messages per 30 seconds as a regular user", [this]()
+  {
+    for (int32 Index = 0; Index < 30; ++Index)
+      Queue->Enqueue(FString::Printf(TEXT("c%d"), Index), TEXT("x"), 0.0);
+
+    Pump(0.0);
+    TestEqual("Burst", CountLines(), 20);
+    TestEqual("Queue Depth", Queue->GetStats(0.0).QueueDepth, 10);
+
+    Pump(15.0);
+    TestEqual("Refilled Half", CountLines(), 30);
+    TestEqual("Max Wait", Queue->GetStats(15.0).MaxWaitSeconds, 15.f);
+  });
+
+  It("should allow 100 messages per 30 seconds in moderated channels", [this]()
+  {
+    Queue->SetChannelLimits(TEXT("m"), true, 0);
+
+    for (int32 Index = 0; Index < 120; ++Index)
+      Queue->Enqueue(TEXT("m"), TEXT("x"), 0.0);
+
+    Pump(0.0);
+    TestEqual("Burst", CountLines(), 100);
+  });
+
+  Describe("Lanes", [this]()
+  {
+    It("should send control lines first even with the buckets drained", [this]()
+    {
+      for (int32 Index = 0; Index < 25; ++Index)
+        Queue->Enqueue(FString::Printf(TEXT("c%d"), Index), TEXT("x"), 0.0);
+
+      Pump(0.0);
+      Frames.Reset();
+
+      Queue->EnqueueControl(TEXT("PONG :tmi.twitch.tv"));
+      TestFalse("Not Empty", Queue->IsEmpty());
+
+      Pump(1.0);
+
+      if (TestEqual("Frames", Frames.Num(), 1))
+        TestEqual("Only Control", Frames[0], FString(TEXT("PONG :tmi.twitch.tv\r\n")));
+
+      TestEqual("Chat Still Queued", Queue->GetStats(1.0).QueueDepth, 5);
+    });
+
+    It("should lead the frame with control lines", [this]()
+    {
+      Queue->Enqueue(TEXT("a"), TEXT("hi"), 0.0);
+      Queue->EnqueueControl(TEXT("PONG :tmi.twitch.tv"));
+
+      Pump(0.0);
+
+      if (TestEqual("Frames", Frames.Num(), 1))
+        TestEqual("Order", Frames[0], FString(TEXT("PONG :tmi.twitch.tv\r\nPRIVMSG #a :hi\r\n")));
+    });
+
+    It("should flush only control lines on their own", [this]()
+    {
+      Queue->Enqueue(TEXT("a"), TEXT("hi"), 0.0);
+      Queue->EnqueueControl(TEXT("PONG :tmi.twitch.tv"));
+
+      Queue->PumpControl([this](const uint8* Data, int32 Size)
+      {
+        const FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(Data), Size);
+        Frames.Add(FString(Converted.Length(), Converted.Get()));
+      });
+
+      if (TestEqual("Frames", Frames.Num(), 1))
+        TestEqual("Only Control", Frames[0], FString(TEXT("PONG :tmi.twitch.tv\r\n")));
+
+      TestEqual("Chat Still Queued", Queue->GetStats(0.0).QueueDepth, 1);
+    });
+
+    It("should recognize moderation commands", [this]()
+    {
+      TestTrue("Ban", FTMIOutboundQueue::IsModerationCommand(TEXT("/ban spammer")));
+      TestTrue("Timeout", FTMIOutboundQueue::IsModerationCommand(TEXT(".TIMEOUT spammer 600")));
+      TestTrue("Clear", FTMIOutboundQueue::IsModerationCommand(TEXT("/clear")));
+      TestFalse("Me", FTMIOutboundQueue::IsModerationCommand(TEXT("/me waves")));
+      TestFalse("Banana", FTMIOutboundQueue::IsModerationCommand(TEXT("/banana")));
+      TestFalse("Chat", FTMIOutboundQueue::IsModerationCommand(TEXT("ban him")));
+    });
+
+    It("should send moderation commands ahead of queued chat", [this]()
+    {
+      Queue->Enqueue(TEXT("a"), TEXT("1"), 0.0);
+      Queue->Enqueue(TEXT("a"), TEXT("2"), 0.0);
+      Pump(0.0);
+      Frames.Reset();
+
+      Queue->Enqueue(TEXT("a"), TEXT("/timeout spammer 60"), 0.5);
+      Pump(1.0);
+
+      if (TestEqual("Frames", Frames.Num(), 1))
+        TestEqual("Moderation First", Frames[0], FString(TEXT("PRIVMSG #a :/timeout spammer 60\r\n")));
+
+      Pump(2.0);
+      TestEqual("Chat After", Frames.Last(), FString(TEXT("PRIVMSG #a :2\r\n")));
+    });
+  });
+
+  Describe("Splitting", [this]()
+  {
+    It("should leave messages that fit alone", [this]()
+    {
+      TArray<FString> Parts;
+      FTMIOutboundQueue::Split(TEXT("hello world"), Parts);
+
+      if (TestEqual("Parts", Parts.Num(), 1))
+        TestEqual("Part", Parts[0], FString(TEXT("hello world")));
+    });
+
+    It("should cut at whitespace", [this]()
+    {
+      FString Message;
+
+      for (int32 Index = 0; Index < 120; ++Index)
+        Message += TEXT("word ");
+
+      Message.TrimEndInline();
+
+      TArray<FString> Parts;
+      FTMIOutboundQueue::Split(Message, Parts);
+
+      if (!TestEqual("Parts", Parts.Num(), 2))
+        return;
+
+      for (const FString& Part : Parts)
+      {
+        TestTrue("Fits", Part.Len() <= FTMIOutboundQueue::MaxMessageLength);
+        TestTrue("Whole Words", Part.StartsWith(TEXT("word")) && Part.EndsWith(TEXT("word")));
+      }
+
+      TestEqual("Nothing Lost", FString::Join(Parts, TEXT(" ")), Message);
+    });
+
+    It("should not cut through a surrogate pair", [this]()
+    {
+      FString Message = TEXT("x");
+
+      for (int32 Index = 0; Index < 300; ++Index)
+        Message += TEXT("\U0001F600");
+
+      TArray<FString> Parts;
+      FTMIOutboundQueue::Split(Message, Parts);
+
+      TestEqual("Parts", Parts.Num(), 2);
+
+      for (const FString& Part : Parts)
+      {
+        TestTrue("Fits", Part.Len() <= FTMIOutboundQueue::MaxMessageLength);
+        TestFalse("Whole Pairs", (Part[Part.Len() - 1] & 0xFC00) == 0xD800);
+      }
+
+      TestEqual("Nothing Lost", FString::Join(Parts, TEXT("")), Message);
+    });
+
+    It("should report messages cut short at the part limit", [this]()
+    {
+      const int32 Length = FTMIOutboundQueue::MaxMessageLength * (FTMIOutboundQueue::MaxMessageParts + 1);
+
+      TArray<FString> Parts;
+      TestFalse("Whole", FTMIOutboundQueue::Split(FString::ChrN(Length, TEXT('x')), Parts));
+      TestEqual("Parts", Parts.Num(), FTMIOutboundQueue::MaxMessageParts);
+
+      TestFalse("Queued Whole", Queue->Enqueue(TEXT("c"), FString::ChrN(Length, TEXT('x')), 0.0));
+      TestTrue("Fits", Queue->Enqueue(TEXT("c"), FString::ChrN(1200, TEXT('x')), 0.0));
+    });
+
+    It("should send a moderator's parts in one pump", [this]()
+    {
+      Queue->SetChannelLimits(TEXT("m"), true, 0);
+      Queue->Enqueue(TEXT("m"), FString::ChrN(1200, TEXT('x')), 0.0);
+
+      Pump(0.0);
+      TestEqual("Lines", CountLines(), 3);
+      TestTrue("Empty", Queue->IsEmpty());
+    });
+
+    It("should only start a group once the tokens for all its parts are there", [this]()
+    {
+      for (int32 Index = 0; Index < 19; ++Index)
+        Queue->Enqueue(FString::Printf(TEXT("c%d"), Index), TEXT("x"), 0.0);
+
+      Queue->Enqueue(TEXT("g"), FString::ChrN(800, TEXT('x')), 0.0);
+
+      Pump(0.0);
+      TestEqual("Group Held Back", CountLines(), 19);
+
+      Pump(1.5);
+      TestEqual("Both Parts", CountLines(), 21);
+      TestTrue("Empty", Queue->IsEmpty());
+    });
+
+    It("should keep the tokens for a waiting group while single lines keep coming", [this]()
+    {
+      for (int32 Index = 0; Index < 20; ++Index)
+        Queue->Enqueue(FString::Printf(TEXT("c%d"), Index), TEXT("x"), 0.0);
+
+      Pump(0.0);
+      Queue->Enqueue(TEXT("g"), FString::ChrN(1200, TEXT('x')), 0.0);
+
+      // A token every 1.5 seconds, each one wanted by a new single line
+      for (int32 Index = 1; Index <= 8; ++Index)
+      {
+        const double Now = Index * 1.5;
+        Queue->Enqueue(FString::Printf(TEXT("s%d"), Index), TEXT("x"), Now);
+        Pump(Now);
+      }
+
+      int32 GroupLines = 0;
+
+      for (const FString& Frame : Frames)
+      {
+        TArray<FString> Lines;
+        Frame.ParseIntoArray(Lines, TEXT("\r\n"));
+        GroupLines += Lines.FilterByPredicate([](const FString& Line) { return Line.StartsWith(TEXT("PRIVMSG #g ")); }).Num();
+      }
+
+      TestEqual("Group Sent", GroupLines, 3);
+      TestTrue("Singles Waited", Queue->GetStats(12.0).QueueDepth > 0);
+    });
+
+    It("should send a regular user's parts back to back, paced as one message", [this]()
+    {
+      Queue->Enqueue(TEXT("a"), FString::ChrN(1200, TEXT('x')), 0.0);
+      Queue->Enqueue(TEXT("a"), TEXT("after"), 0.0);
+
+      Pump(0.0);
+      TestEqual("Parts Together", CountLines(), 3);
+
+      Pump(0.5);
+      TestEqual("Paced After The Group", CountLines(), 3);
+
+      Pump(1.0);
+      TestEqual("Next Message", CountLines(), 4);
+    });
+  });
+}
@@ -1,4 +1,5 @@
 #include "TMIParser.h"
+#include "TMIUserDirectory.h"
 
 #include "Misc/DefaultValueHelper.h"
 
@@ -12,6 +13,7 @@ FString GetIRCCommandString(EIRCCommand Command)
   case EIRCCommand::JOIN: return TEXT("JOIN");
   case EIRCCommand::PART:	return TEXT("PART");
   case EIRCCommand::PING:	return TEXT("PING");
+  case EIRCCommand::PONG:	return TEXT("PONG");
   case EIRCCommand::PRIVMSG:	return TEXT("PRIVMSG");
   case EIRCCommand::CLEARCHAT:	return TEXT("CLEARCHAT");
   case EIRCCommand::GLOBALUSERSTATE:	return TEXT("GLOBALUSERSTATE");
@@ -32,6 +34,7 @@ const TMap<FString, EIRCCommand> TwitchStringToIRCCommand = {
   {TEXT("JOIN"), EIRCCommand::JOIN},
   {TEXT("PART"), EIRCCommand::PART},
   {TEXT("PING"), EIRCCommand::PING},
+  {TEXT("PONG"), EIRCCommand::PONG},
   {TEXT("GLOBALUSERSTATE"), EIRCCommand::GLOBALUSERSTATE},
   {TEXT("USERSTATE"), EIRCCommand::USERSTATE},
   {TEXT("NOTICE"), EIRCCommand::NOTICE},
@@ -356,7 +359,7 @@ TwitchSubscriptionPlan TMIParser::ParseSubPlan(const FString& PlanID)
   return *id;
 }
 
-bool TMIParser::ParseTags(EIRCCommand ParsingCommand, const TArray<FString>& InTags, TwitchTagsMaster& OutTags)
+bool TMIParser::ParseTags(EIRCCommand ParsingCommand, const TArray<FString>& InTags, TwitchTagsMaster& OutTags, bool bDeferChatterTags)
 {
   bool bValid = InTags.Num() > 0;
 
@@ -590,18 +593,28 @@ bool TMIParser::ParseTags(EIRCCommand ParsingCommand, const TArray<FString>& InT
       // END USERNOTICE Parameter Tags
       case ETwitchTagType::EmoteOnly:
         OutTags.EmoteOnly = Value.ToBool();
+        OutTags.RoomStateFields |= ETWRoomStateField::EmoteOnly;
         break;
 
       case ETwitchTagType::BadgeInfo:
-        ParseBadges(Value, OutTags.BadgesInfo);
+        if (bDeferChatterTags)
+          OutTags.RawChatter.BadgeInfo = MoveTemp(Value);
+        else
+          ParseBadges(Value, OutTags.BadgesInfo);
         break;
 
       case ETwitchTagType::Badges:
-        ParseBadges(Value, OutTags.Badges);
+        if (bDeferChatterTags)
+          OutTags.RawChatter.Badges = MoveTemp(Value);
+        else
+          ParseBadges(Value, OutTags.Badges);
         break;
 
       case ETwitchTagType::DisplayName:
-        OutTags.DisplayName = Value;
+        if (bDeferChatterTags)
+          OutTags.RawChatter.DisplayName = MoveTemp(Value);
+        else
+          OutTags.DisplayName = Value;
         break;
 
       case ETwitchTagType::Emotes:
@@ -613,14 +626,11 @@ bool TMIParser::ParseTags(EIRCCommand ParsingCommand, const TArray<FString>& InT
         break;
 
       case ETwitchTagType::NameColor:
-      {
-        int32 R = FParse::HexNumber(*Value.Mid(1, 2));
-        int32 G = FParse::HexNumber(*Value.Mid(3, 2));
-        int32 B = FParse::HexNumber(*Value.Mid(5, 2));
-
-        OutTags.NameColor = FLinearColor(R / 255.0f, G / 255.0f, B / 255.0f);
+        if (bDeferChatterTags)
+          OutTags.RawChatter.Color = MoveTemp(Value);
+        else
+          OutTags.NameColor = ParseColor(Value);
         break;
-      }
 
       case ETwitchTagType::MessageID:
         OutTags.MessageID = Value;
@@ -632,14 +642,23 @@ bool TMIParser::ParseTags(EIRCCommand ParsingCommand, const TArray<FString>& InT
 
       case ETwitchTagType::FollowersOnly:
         FDefaultValueHelper::ParseInt(Value, OutTags.FollowersOnlyMinMinutes);
+        OutTags.RoomStateFields |= ETWRoomStateField::FollowersOnly;
         break;
 
       case ETwitchTagType::SubsOnly:
         OutTags.SubscribersOnly = Value.ToBool();
+        OutTags.RoomStateFields |= ETWRoomStateField::SubsOnly;
         break;
 
       case ETwitchTagType::Slow:
-        OutTags.SlowMode = Value.ToBool();
+        FDefaultValueHelper::ParseInt(Value, OutTags.SlowModeSeconds);
+        OutTags.SlowMode = OutTags.SlowModeSeconds > 0;
+        OutTags.RoomStateFields |= ETWRoomStateField::Slow;
+        break;
+
+      case ETwitchTagType::Rituals:
+        OutTags.Rituals = Value.ToBool();
+        OutTags.RoomStateFields |= ETWRoomStateField::Rituals;
         break;
 
       case ETwitchTagType::ThreadID:
@@ -648,6 +667,7 @@ bool TMIParser::ParseTags(EIRCCommand ParsingCommand, const TArray<FString>& InT
 
       case ETwitchTagType::R9K:
         OutTags.R9K = Value.ToBool();
+        OutTags.RoomStateFields |= ETWRoomStateField::R9K;
         break;
 
       case ETwitchTagType::Mod:
@@ -685,6 +705,220 @@ bool TMIParser::ParseTags(EIRCCommand ParsingCommand, const TArray<FString>& InT
   return bValid;
 }
 
+FLinearColor TMIParser::ParseColor(const FString& ColorStr)
+{
+  int32 R = FParse::HexNumber(*ColorStr.Mid(1, 2));
+  int32 G = FParse::HexNumber(*ColorStr.Mid(3, 2));
+  int32 B = FParse::HexNumber(*ColorStr.Mid(5, 2));
+
+  return FLinearColor(R / 255.0f, G / 255.0f, B / 255.0f);
+}
+
+void TMIParser::ParseChatterInfo(const FString& UserID, const FString& Login, const FTWRawChatterTags& Raw, FTWChatterInfo& OutInfo)
+{
+  OutInfo.UserID = UserID;
+  OutInfo.Login = Login;
+  OutInfo.DisplayName = Raw.DisplayName;
+  OutInfo.NameColor = ParseColor(Raw.Color);
+
+  FString Badges = Raw.Badges;
+  FString BadgeInfo = Raw.BadgeInfo;
+
+  OutInfo.Badges.Reset();
+  OutInfo.BadgesInfo.Reset();
+  ParseBadges(Badges, OutInfo.Badges);
+  ParseBadges(BadgeInfo, OutInfo.BadgesInfo);
+}
+
+static bool IsHighSurrogate(TCHAR Char)
+{
+  return sizeof(TCHAR) == 2 && (Char & 0xFC00) == 0xD800;
+}
+
+void TMIParser::TokenizeMessage(const FString& Message, const TMap<FString, FTWEmoteData>& Emotes, bool bHasBits, TArray<FTWMessageRun>& OutRuns)
+{
+  OutRuns.Reset();
+
+  const int32 Len = Message.Len();
+  const TCHAR* Chars = *Message;
+
+  if (Len == 0)
+    return;
+
+  // Twitch counts emote positions in code points, only surrogate pairs make that differ from our indices
+  TArray<int32, TInlineAllocator<256>> CodePointToIndex;
+  bool bHasSurrogates = false;
+
+  for (int32 i = 0; i < Len && !bHasSurrogates; ++i)
+  {
+    bHasSurrogates = IsHighSurrogate(Chars[i]);
+  }
+
+  if (bHasSurrogates)
+  {
+    for (int32 i = 0; i < Len; ++i)
+    {
+      CodePointToIndex.Add(i);
+
+      if (IsHighSurrogate(Chars[i]) && i + 1 < Len)
+        ++i;
+    }
+
+    CodePointToIndex.Add(Len);
+  }
+
+  auto ToIndex = [&](int32 CodePoint) -> int32
+  {
+    if (!bHasSurrogates)
+      return CodePoint >= 0 && CodePoint <= Len ? CodePoint : INDEX_NONE;
+
+    return CodePointToIndex.IsValidIndex(CodePoint) ? CodePointToIndex[CodePoint] : INDEX_NONE;
+  };
+
+  struct FEmoteSpan
+  {
+    int32 Start;
+    int32 End;
+    const FString* EmoteID;
+  };
+
+  TArray<FEmoteSpan, TInlineAllocator<16>> Spans;
+
+  for (const TPair<FString, FTWEmoteData>& Emote : Emotes)
+  {
+    for (const FTWEmotePositions& Position : Emote.Value.EmotePositions)
+    {
+      const int32 Start = ToIndex(Position.Start);
+      const int32 End = ToIndex(Position.End + 1);
+
+      if (Start != INDEX_NONE && End != INDEX_NONE && Start < End)
+        Spans.Add({ Start, End, &Emote.Key });
+    }
+  }
+
+  Spans.Sort([](const FEmoteSpan& A, const FEmoteSpan& B) { return A.Start < B.Start; });
+
+  int32 Cursor = 0;
+
+  for (const FEmoteSpan& Span : Spans)
+  {
+    // Overlapping positions are malformed, keep the first one
+    if (Span.Start < Cursor)
+      continue;
+
+    TokenizeText(Message, Cursor, Span.Start, bHasBits, OutRuns);
+
+    FTWMessageRun& Run = OutRuns.Emplace_GetRef(ETWMessageRunType::Emote, Span.Start, Span.End - Span.Start);
+    Run.ID = *Span.EmoteID;
+    Cursor = Span.End;
+  }
+
+  TokenizeText(Message, Cursor, Len, bHasBits, OutRuns);
+}
+
+void TMIParser::TokenizeText(const FString& Message, int32 Start, int32 End, bool bHasBits, TArray<FTWMessageRun>& OutRuns)
+{
+  const TCHAR* Chars = *Message;
+  int32 TextStart = Start;
+  int32 Index = Start;
+
+  while (Index < End)
+  {
+    if (FChar::IsWhitespace(Chars[Index]))
+    {
+      ++Index;
+      continue;
+    }
+
+    int32 WordEnd = Index;
+
+    while (WordEnd < End && !FChar::IsWhitespace(Chars[WordEnd]))
+      ++WordEnd;
+
+    FTWMessageRun Run;
+
+    if (ClassifyWord(Chars + Index, WordEnd - Index, bHasBits, Run))
+    {
+      // Plain text, whitespace included, is merged into a single run
+      if (TextStart < Index)
+        OutRuns.Emplace(ETWMessageRunType::Text, TextStart, Index - TextStart);
+
+      Run.Start = Index;
+      OutRuns.Add(Run);
+      TextStart = Index + Run.Length;
+    }
+
+    Index = WordEnd;
+  }
+
+  if (TextStart < End)
+    OutRuns.Emplace(ETWMessageRunType::Text, TextStart, End - TextStart);
+}
+
+bool TMIParser::ClassifyWord(const TCHAR* Word, int32 WordLen, bool bHasBits, FTWMessageRun& OutRun)
+{
+  // @login, trailing punctuation is not part of the mention
+  if (Word[0] == TCHAR('@'))
+  {
+    int32 Length = 1;
+
+    while (Length < WordLen && (FChar::IsAlnum(Word[Length]) || Word[Length] == TCHAR('_')))
+      ++Length;
+
+    if (Length == 1)
+      return false;
+
+    OutRun.Type = ETWMessageRunType::Mention;
+    OutRun.Length = Length;
+    return true;
+  }
+
+  if (FCString::Strnicmp(Word, TEXT("http://"), 7) == 0 || FCString::Strnicmp(Word, TEXT("https://"), 8) == 0 || FCString::Strnicmp(Word, TEXT("www."), 4) == 0)
+  {
+    int32 Length = WordLen;
+
+    while (Length > 0 && FCString::Strchr(TEXT(".,!?:;)\"'"), Word[Length - 1]) != nullptr)
+      --Length;
+
+    OutRun.Type = ETWMessageRunType::URL;
+    OutRun.Length = Length;
+    return true;
+  }
+
+  // Cheermotes are a prefix followed by the amount, e.g. cheer100 or Kappa50
+  if (bHasBits && FChar::IsAlpha(Word[0]))
+  {
+    int32 PrefixLen = 0;
+
+    while (PrefixLen < WordLen && FChar::IsAlpha(Word[PrefixLen]))
+      ++PrefixLen;
+
+    if (PrefixLen == WordLen)
+      return false;
+
+    int32 Bits = 0;
+
+    for (int32 i = PrefixLen; i < WordLen; ++i)
+    {
+      if (!FChar::IsDigit(Word[i]) || Bits > (MAX_int32 - 9) / 10)
+        return false;
+
+      Bits = Bits * 10 + (Word[i] - TCHAR('0'));
+    }
+
+    if (Bits <= 0)
+      return false;
+
+    OutRun.Type = ETWMessageRunType::Cheermote;
+    OutRun.Length = WordLen;
+    OutRun.ID = FString(PrefixLen, Word);
+    OutRun.Bits = Bits;
+    return true;
+  }
+
+  return false;
+}
+
 ETWUserType TMIParser::ParseUserType(const FString& UserType)
 {
   ETWUserType* Type = UserTypeStringToUserType.Find(UserType);
@@ -713,11 +947,32 @@ ETWGoalContributionType TMIParser::ParseUserNoticeGoalType(const FString& Goal)
 
 
 template<typename MsgType>
-MsgType TMIParser::ParseMessage(MessageBundle& InMessage)
+MsgType TMIParser::ParseMessage(MessageBundle& InMessage, FTMIUserDirectory* UserDirectory)
 {
   TwitchTagsMaster Tags;
 
-  bool bTagsValid = ParseTags(InMessage.Command, InMessage.Tags, Tags);
+  const bool bResolveChatter = UserDirectory != nullptr && InMessage.Command == EIRCCommand::PRIVMSG;
+
+  bool bTagsValid = ParseTags(InMessage.Command, InMessage.Tags, Tags, bResolveChatter);
+
+  if (bResolveChatter && bTagsValid)
+  {
+    if (!Tags.UserID.IsEmpty())
+    {
+      Tags.Chatter = UserDirectory->Resolve(Tags.UserID, InMessage.Source, Tags.RawChatter);
+    }
+    else
+    {
+      // Nothing to key the directory on, fall back to parsing into the message itself
+      FTWChatterInfo Info;
+      ParseChatterInfo(Tags.UserID, InMessage.Source, Tags.RawChatter, Info);
+
+      Tags.DisplayName = MoveTemp(Info.DisplayName);
+      Tags.NameColor = Info.NameColor;
+      Tags.Badges = MoveTemp(Info.Badges);
+      Tags.BadgesInfo = MoveTemp(Info.BadgesInfo);
+    }
+  }
 
   return MsgType(InMessage, bTagsValid, Tags);
 }
\ No newline at end of file
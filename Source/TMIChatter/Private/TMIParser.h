@@ -15,6 +15,7 @@ enum class EIRCCommand : uint8 {
 	JOIN,
 	PART,
 	PING,
+	PONG,							// Reply to a PING we sent, see FTMIHealthMonitor
 	PRIVMSG,
 
 	/* TMI Messages*/
@@ -34,6 +35,9 @@ enum class EIRCCommand : uint8 {
 	UNKNOWN
 };
 
+// Number of EIRCCommand values, used to size tables indexed by command
+constexpr int32 IRCCommandCount = static_cast<int32>(EIRCCommand::UNKNOWN) + 1;
+
 FString GetIRCCommandString(EIRCCommand Command);
 
 /* TMI Tags https://dev.twitch.tv/docs/irc/tags */
@@ -131,6 +135,21 @@ enum class ETWUserNoticeMsgId : uint8
 	StandardPayForward
 };
 
+// ROOMSTATE messages sent after a settings change only carry the tags that changed, these flags record which ones were present
+UENUM(BlueprintType, meta = (Bitflags, UseEnumValuesAsMaskValuesInEditor = "true"))
+enum class ETWRoomStateField : uint8
+{
+	None = 0 UMETA(Hidden),
+	EmoteOnly = 1 << 0,
+	FollowersOnly = 1 << 1,
+	R9K = 1 << 2,
+	Rituals = 1 << 3,
+	Slow = 1 << 4,
+	SubsOnly = 1 << 5,
+	All = 0x3F UMETA(Hidden)
+};
+ENUM_CLASS_FLAGS(ETWRoomStateField);
+
 UENUM(BlueprintType)
 enum class ETWUserType : uint8
 {
@@ -212,6 +231,43 @@ struct FTWEmoteData
 		TArray<FTWEmotePositions> EmotePositions;
 };
 
+UENUM(BlueprintType)
+enum class ETWMessageRunType : uint8
+{
+	Text,
+	Emote,
+	Cheermote,
+	Mention,
+	URL
+};
+
+// A contiguous piece of a chat message, Start and Length are UTF-16 indices into the message string
+USTRUCT(BlueprintType)
+struct FTWMessageRun
+{
+	GENERATED_USTRUCT_BODY();
+
+	FTWMessageRun() {}
+	FTWMessageRun(ETWMessageRunType Type, int32 Start, int32 Length)
+		: Type(Type), Start(Start), Length(Length)
+	{}
+
+	UPROPERTY(BlueprintReadOnly)
+		ETWMessageRunType Type = ETWMessageRunType::Text;
+
+	UPROPERTY(BlueprintReadOnly)
+		int32 Start = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+		int32 Length = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+		FString ID;				// The emote ID for emotes, the cheer prefix for cheermotes
+
+	UPROPERTY(BlueprintReadOnly)
+		int32 Bits = 0;		// Cheermotes only
+};
+
 UENUM(BlueprintType)
 enum class TwitchSubscriptionPlan : uint8 {
 	None,
@@ -627,6 +683,57 @@ struct FBitsBadgeTierNoticeTags
 		int32 Threshold;
 };
 
+// One chatter's identity as shared by every message they send, see FTMIUserDirectory
+USTRUCT(BlueprintType)
+struct FTWChatterInfo
+{
+	GENERATED_USTRUCT_BODY();
+
+	FTWChatterInfo() {}
+
+	UPROPERTY(BlueprintReadOnly)
+		FString UserID;
+
+	UPROPERTY(BlueprintReadOnly)
+		FString Login;
+
+	UPROPERTY(BlueprintReadOnly)
+		FString DisplayName;
+
+	UPROPERTY(BlueprintReadOnly)
+		FLinearColor NameColor;
+
+	UPROPERTY(BlueprintReadOnly)
+		TMap<FString, int32> Badges;
+
+	UPROPERTY(BlueprintReadOnly)
+		TMap<FString, int32> BadgesInfo;
+};
+
+// Unparsed values of the tags that make up an FTWChatterInfo, compared as is to detect changes
+struct FTWRawChatterTags
+{
+	bool operator==(const FTWRawChatterTags& RHS) const
+	{
+		return DisplayName.Equals(RHS.DisplayName, ESearchCase::CaseSensitive)
+			&& Color.Equals(RHS.Color, ESearchCase::CaseSensitive)
+			&& Badges.Equals(RHS.Badges, ESearchCase::CaseSensitive)
+			&& BadgeInfo.Equals(RHS.BadgeInfo, ESearchCase::CaseSensitive);
+	}
+
+	bool operator!=(const FTWRawChatterTags& RHS) const
+	{
+		return !(*this == RHS);
+	}
+
+	FString DisplayName;
+	FString Color;
+	FString Badges;
+	FString BadgeInfo;
+};
+
+class FTMIUserDirectory;
+
 // This master struct is here to create 1 parser for every possible tag used by twitch
 // Each specific message tag type has a constructor that takes this struct as a parameter
 struct TwitchTagsMaster
@@ -641,9 +748,11 @@ struct TwitchTagsMaster
 		EmoteSets(RHS.EmoteSets), Login(RHS.Login), SystemMessage(RHS.SystemMessage), ReturningChatter(RHS.ReturningChatter),
 		TMISentTS(RHS.TMISentTS), UserNoticeMsgID(RHS.UserNoticeMsgID), NoticeMsgID(RHS.NoticeMsgID), MsgID(RHS.MsgID), FirstMsg(RHS.FirstMsg),
 		EmoteOnly(RHS.EmoteOnly), FollowersOnlyMinMinutes(RHS.FollowersOnlyMinMinutes),
-		R9K(RHS.R9K), Rituals(RHS.Rituals), SlowMode(RHS.SlowMode), SubscribersOnly(RHS.SubscribersOnly), VIP(RHS.VIP),
+		R9K(RHS.R9K), Rituals(RHS.Rituals), SlowMode(RHS.SlowMode), SlowModeSeconds(RHS.SlowModeSeconds), SubscribersOnly(RHS.SubscribersOnly),
+		RoomStateFields(RHS.RoomStateFields), VIP(RHS.VIP),
 		MessageParams(RHS.MessageParams), CustomRewardID(RHS.CustomRewardID), ReplyParentMsgID(RHS.ReplyParentMsgID), ReplyParentUserID(RHS.ReplyParentUserID),
-		ReplyParentUserLogin(RHS.ReplyParentUserLogin), ReplyParentDisplayName(RHS.ReplyParentDisplayName), ReplyParentMsgBody(RHS.ReplyParentMsgBody)
+		ReplyParentUserLogin(RHS.ReplyParentUserLogin), ReplyParentDisplayName(RHS.ReplyParentDisplayName), ReplyParentMsgBody(RHS.ReplyParentMsgBody),
+		RawChatter(RHS.RawChatter), Chatter(RHS.Chatter)
 	{
 	}
 
@@ -676,7 +785,11 @@ struct TwitchTagsMaster
 		R9K = RHS.R9K;
 		Rituals = RHS.Rituals;
 		SlowMode = RHS.SlowMode;
+		SlowModeSeconds = RHS.SlowModeSeconds;
 		SubscribersOnly = RHS.SubscribersOnly;
+		RoomStateFields = RHS.RoomStateFields;
+		RawChatter = RHS.RawChatter;
+		Chatter = RHS.Chatter;
 		FirstMsg = RHS.FirstMsg;
 		ReturningChatter = RHS.ReturningChatter;
 		VIP = RHS.VIP;
@@ -713,8 +826,10 @@ struct TwitchTagsMaster
 	int32 FollowersOnlyMinMinutes = -1;	// if == -1 It is not in followers only mode
 	bool R9K = false;
 	bool SlowMode = false;
+	int32 SlowModeSeconds = 0;
 	bool SubscribersOnly = false;
 	bool Rituals = false;
+	ETWRoomStateField RoomStateFields = ETWRoomStateField::None;
 	bool VIP = false;
 	FString ThreadID;
 	FUserNoticeMessageParams MessageParams;
@@ -725,6 +840,8 @@ struct TwitchTagsMaster
 	FString ReplyParentUserLogin;
 	FString ReplyParentDisplayName;
 	FString ReplyParentMsgBody;
+	FTWRawChatterTags RawChatter;						// Only filled when parsing through a user directory
+	TSharedPtr<const FTWChatterInfo> Chatter;
 };
 
 class TMIParser {
@@ -763,11 +880,22 @@ public:
 
 	static MessageBundle SplitRawMessage(const FString& RawMessage);
 
+	// With a user directory, PRIVMSG chatter tags (display name, color, badges) are resolved to a shared FTWChatterInfo
+	// in Tags.Chatter instead of being parsed into every message
 	template<typename MsgType>
-	static MsgType ParseMessage(MessageBundle& InMessage);
+	static MsgType ParseMessage(MessageBundle& InMessage, FTMIUserDirectory* UserDirectory = nullptr);
+
+	static void ParseChatterInfo(const FString& UserID, const FString& Login, const FTWRawChatterTags& Raw, FTWChatterInfo& OutInfo);
+
+	// Splits a chat message into ordered text, emote, cheermote, mention and URL runs
+	// Emote positions are in code points as sent by Twitch and are converted to UTF-16 indices
+	static void TokenizeMessage(const FString& Message, const TMap<FString, FTWEmoteData>& Emotes, bool bHasBits, TArray<FTWMessageRun>& OutRuns);
 
 private:
-	static bool ParseTags(EIRCCommand ParsingCommand, const TArray<FString>& InTags, TwitchTagsMaster& OutTags);
+	static bool ParseTags(EIRCCommand ParsingCommand, const TArray<FString>& InTags, TwitchTagsMaster& OutTags, bool bDeferChatterTags = false);
+	static FLinearColor ParseColor(const FString& ColorStr);
+	static void TokenizeText(const FString& Message, int32 Start, int32 End, bool bHasBits, TArray<FTWMessageRun>& OutRuns);
+	static bool ClassifyWord(const TCHAR* Word, int32 WordLen, bool bHasBits, FTWMessageRun& OutRun);
 	static ETWUserNoticeMsgId ParseUserNoticeMsgID(const FString& MsgID);
 	static void ParseBadges(FString& BadgeStr, TMap<FString, int32>& OutBadges);
 	static void ParseEmotes(FString& Emotestr, TMap<FString, FTWEmoteData>& OutEmotes);
@@ -982,7 +1110,8 @@ struct FTWPrivMsgTags
 		FirstMsg(RHS.FirstMsg),
 		ReturningChatter(RHS.ReturningChatter),
 		CustomRewardID(RHS.CustomRewardID), ReplyParentMsgID(RHS.ReplyParentMsgID), ReplyParentUserID(RHS.ReplyParentUserID),
-		ReplyParentUserLogin(RHS.ReplyParentUserLogin), ReplyParentDisplayName(RHS.ReplyParentDisplayName), ReplyParentMsgBody(RHS.ReplyParentMsgBody)
+		ReplyParentUserLogin(RHS.ReplyParentUserLogin), ReplyParentDisplayName(RHS.ReplyParentDisplayName), ReplyParentMsgBody(RHS.ReplyParentMsgBody),
+		Chatter(RHS.Chatter)
 	{}
 
 	explicit FTWPrivMsgTags(const TwitchTagsMaster& RHS)
@@ -1003,7 +1132,8 @@ struct FTWPrivMsgTags
 		FirstMsg(RHS.FirstMsg),
 		ReturningChatter(RHS.ReturningChatter),
 		CustomRewardID(RHS.CustomRewardID), ReplyParentMsgID(RHS.ReplyParentMsgID), ReplyParentUserID(RHS.ReplyParentUserID),
-		ReplyParentUserLogin(RHS.ReplyParentUserLogin), ReplyParentDisplayName(RHS.ReplyParentDisplayName), ReplyParentMsgBody(RHS.ReplyParentMsgBody)
+		ReplyParentUserLogin(RHS.ReplyParentUserLogin), ReplyParentDisplayName(RHS.ReplyParentDisplayName), ReplyParentMsgBody(RHS.ReplyParentMsgBody),
+		Chatter(RHS.Chatter)
 	{}
 
 	FTWPrivMsgTags& operator=(const FTWPrivMsgTags& RHS)
@@ -1030,6 +1160,7 @@ struct FTWPrivMsgTags
 		ReplyParentUserLogin = RHS.ReplyParentUserLogin;
 		ReplyParentDisplayName = RHS.ReplyParentDisplayName;
 		ReplyParentMsgBody = RHS.ReplyParentMsgBody;
+		Chatter = RHS.Chatter;
 		return *this;
 	}
 
@@ -1057,6 +1188,7 @@ struct FTWPrivMsgTags
 		ReplyParentUserLogin = RHS.ReplyParentUserLogin;
 		ReplyParentDisplayName = RHS.ReplyParentDisplayName;
 		ReplyParentMsgBody = RHS.ReplyParentMsgBody;
+		Chatter = RHS.Chatter;
 		return *this;
 	}
 
@@ -1125,6 +1257,9 @@ struct FTWPrivMsgTags
 
 	UPROPERTY(BlueprintReadOnly)
 		FString ReplyParentMsgBody;
+
+	// Set when parsed through a user directory, in which case Badges, BadgesInfo, NameColor and DisplayName are left empty
+	TSharedPtr<const FTWChatterInfo> Chatter;
 };
 
 USTRUCT(Blueprintable)
@@ -1135,13 +1270,16 @@ struct FTWRoomStateTags
 	FTWRoomStateTags() {}
 	~FTWRoomStateTags() {}
 
-	FTWRoomStateTags(bool EmoteOnly, int32 FollowersOnlyMinMinutes, bool R9K, bool Rituals, bool SlowMode, bool SubscribersOnly)
+	FTWRoomStateTags(bool EmoteOnly, int32 FollowersOnlyMinMinutes, bool R9K, bool Rituals, bool SlowMode, bool SubscribersOnly,
+		int32 SlowModeSeconds = 0, ETWRoomStateField PresentFields = ETWRoomStateField::All)
 		: EmoteOnly(EmoteOnly),
 		FollowersOnlyMinMinutes(FollowersOnlyMinMinutes),
 		R9K(R9K),
 		Rituals(Rituals),
 		SlowMode(SlowMode),
-		SubscribersOnly(SubscribersOnly)
+		SlowModeSeconds(SlowModeSeconds),
+		SubscribersOnly(SubscribersOnly),
+		PresentFields(static_cast<int32>(PresentFields))
 	{}
 
 	explicit FTWRoomStateTags(const FTWRoomStateTags& RHS)
@@ -1150,7 +1288,9 @@ struct FTWRoomStateTags
 		R9K(RHS.R9K),
 		Rituals(RHS.Rituals),
 		SlowMode(RHS.SlowMode),
-		SubscribersOnly(RHS.SubscribersOnly)
+		SlowModeSeconds(RHS.SlowModeSeconds),
+		SubscribersOnly(RHS.SubscribersOnly),
+		PresentFields(RHS.PresentFields)
 	{}
 
 	explicit FTWRoomStateTags(const TwitchTagsMaster& RHS)
@@ -1159,7 +1299,9 @@ struct FTWRoomStateTags
 		R9K(RHS.R9K),
 		Rituals(RHS.Rituals),
 		SlowMode(RHS.SlowMode),
-		SubscribersOnly(RHS.SubscribersOnly)
+		SlowModeSeconds(RHS.SlowModeSeconds),
+		SubscribersOnly(RHS.SubscribersOnly),
+		PresentFields(static_cast<int32>(RHS.RoomStateFields))
 	{}
 
 	FTWRoomStateTags& operator=(const FTWRoomStateTags& RHS)
@@ -1169,7 +1311,9 @@ struct FTWRoomStateTags
 		R9K = RHS.R9K;
 		Rituals = RHS.Rituals;
 		SlowMode = RHS.SlowMode;
+		SlowModeSeconds = RHS.SlowModeSeconds;
 		SubscribersOnly = RHS.SubscribersOnly;
+		PresentFields = RHS.PresentFields;
 		return *this;
 	}
 
@@ -1180,10 +1324,17 @@ struct FTWRoomStateTags
 		R9K = RHS.R9K;
 		Rituals = RHS.Rituals;
 		SlowMode = RHS.SlowMode;
+		SlowModeSeconds = RHS.SlowModeSeconds;
 		SubscribersOnly = RHS.SubscribersOnly;
+		PresentFields = static_cast<int32>(RHS.RoomStateFields);
 		return *this;
 	}
 
+	bool HasField(ETWRoomStateField Field) const
+	{
+		return EnumHasAnyFlags(static_cast<ETWRoomStateField>(PresentFields), Field);
+	}
+
 	UPROPERTY(BlueprintReadOnly)
 		bool EmoteOnly;
 
@@ -1199,8 +1350,14 @@ struct FTWRoomStateTags
 	UPROPERTY(BlueprintReadOnly)
 		bool SlowMode;
 
+	UPROPERTY(BlueprintReadOnly)
+		int32 SlowModeSeconds = 0;	// Seconds a user must wait between messages, 0 when slow mode is off
+
 	UPROPERTY(BlueprintReadOnly)
 		bool SubscribersOnly;
+
+	UPROPERTY(BlueprintReadOnly, meta = (Bitmask, BitmaskEnum = "ETWRoomStateField"))
+		int32 PresentFields = static_cast<int32>(ETWRoomStateField::All);	// Which of the above were actually sent
 };
 
 USTRUCT(blueprintable)
@@ -1572,7 +1729,8 @@ struct FPrivMsgMessage
 	{}
 
 	FPrivMsgMessage(const FPrivMsgMessage& RHS)
-		: Channel(RHS.Channel), FromUser(RHS.FromUser), Message(RHS.Message), bTagsValid(RHS.bTagsValid), Tags(RHS.Tags)
+		: Channel(RHS.Channel), FromUser(RHS.FromUser), Message(RHS.Message), bTagsValid(RHS.bTagsValid), Tags(RHS.Tags), Runs(RHS.Runs),
+		DuplicateClusterID(RHS.DuplicateClusterID), DuplicateCount(RHS.DuplicateCount)
 	{}
 
 	FPrivMsgMessage& operator=(const FPrivMsgMessage& RHS)
@@ -1582,6 +1740,9 @@ struct FPrivMsgMessage
 		Message = RHS.Message;
 		bTagsValid = RHS.bTagsValid;
 		Tags = RHS.Tags;
+		Runs = RHS.Runs;
+		DuplicateClusterID = RHS.DuplicateClusterID;
+		DuplicateCount = RHS.DuplicateCount;
 		return *this;
 	}
 
@@ -1599,6 +1760,16 @@ struct FPrivMsgMessage
 
 	UPROPERTY(BlueprintReadOnly)
 		FTWPrivMsgTags Tags;
+
+	UPROPERTY(BlueprintReadOnly)
+		TArray<FTWMessageRun> Runs;		// Only filled when message tokenizing is enabled, see TMIParser::TokenizeMessage
+
+	// Only set when duplicate detection is enabled, near identical messages within the window share a cluster
+	UPROPERTY(BlueprintReadOnly)
+		int32 DuplicateClusterID = INDEX_NONE;
+
+	UPROPERTY(BlueprintReadOnly)
+		int32 DuplicateCount = 0;			// Messages in the cluster so far, this one included
 };
 
 USTRUCT(blueprintable)
@@ -746,6 +746,18 @@ void TMIParserSpec::Define()
           });
         });
       }
+
+      It("should only flag the settings present in a partial update", [this]()
+      {
+        TMIParser::MessageBundle Bundle = TMIParser::SplitRawMessage(TEXT("@room-id=12345678;slow=30 :tmi.twitch.tv ROOMSTATE #bar"));
+        FRoomStateMessage Message = TMIParser::ParseMessage<FRoomStateMessage>(Bundle);
+
+        TestTrue("Has Slow", Message.Tags.HasField(ETWRoomStateField::Slow));
+        TestFalse("Has EmoteOnly", Message.Tags.HasField(ETWRoomStateField::EmoteOnly));
+        TestFalse("Has FollowersOnly", Message.Tags.HasField(ETWRoomStateField::FollowersOnly));
+        TestTrue("SlowMode", Message.Tags.SlowMode);
+        TestEqual("SlowModeSeconds", Message.Tags.SlowModeSeconds, 30);
+      });
     }); // End Describe ROOMSTATE
 
     Describe("HOSTTARGET", [this]()
@@ -790,6 +802,18 @@ void TMIParserSpec::Define()
       });
     }); // End Describe PING
 
+    Describe("PONG", [this]()
+    {
+      It("should carry the nonce of our PING in the params", [this]()
+      {
+        TMIParser::MessageBundle ParsedBundle = TMIParser::SplitRawMessage(":tmi.twitch.tv PONG tmi.twitch.tv :probe-7");
+
+        TestEqual("Command", ParsedBundle.Command, EIRCCommand::PONG);
+        TestEqual("Target", ParsedBundle.Target, "tmi.twitch.tv");
+        TestEqual("Params", ParsedBundle.Params, "probe-7");
+      });
+    }); // End Describe PONG
+
     Describe("PRIVMSG", [this]()
     {
       for (int32 Index = 0; Index < PrivMsgTestMessages.Num(); ++Index)
@@ -969,4 +993,65 @@ void TMIParserSpec::Define()
       } // End For Loop
     }); // End Describe Notice
   }); // End Describe Parsing
+
+  Describe("Tokenizing", [this]()
+  {
+    It("should split text around emotes", [this]()
+    {
+      TMap<FString, FTWEmoteData> Emotes;
+      Emotes.Add(TEXT("25"), FTWEmoteData({ FTWEmotePositions(0, 4), FTWEmotePositions(12, 16) }));
+
+      TArray<FTWMessageRun> Runs;
+      TMIParser::TokenizeMessage(TEXT("Kappa Keepo Kappa"), Emotes, false, Runs);
+
+      if (TestEqual("Run Count", Runs.Num(), 3))
+      {
+        TestTrue("Emote", Runs[0].Type == ETWMessageRunType::Emote && Runs[0].Start == 0 && Runs[0].Length == 5 && Runs[0].ID == TEXT("25"));
+        TestTrue("Text", Runs[1].Type == ETWMessageRunType::Text && Runs[1].Start == 5 && Runs[1].Length == 7);
+        TestTrue("Emote", Runs[2].Type == ETWMessageRunType::Emote && Runs[2].Start == 12 && Runs[2].Length == 5);
+      }
+    });
+
+    It("should convert code point emote positions past surrogate pairs", [this]()
+    {
+      // U+1F600 takes two UTF-16 code units but Twitch counts it as one position
+      const FString Message = FString(TEXT("\xD83D\xDE00 Kappa"));
+
+      TMap<FString, FTWEmoteData> Emotes;
+      Emotes.Add(TEXT("25"), FTWEmoteData({ FTWEmotePositions(2, 6) }));
+
+      TArray<FTWMessageRun> Runs;
+      TMIParser::TokenizeMessage(Message, Emotes, false, Runs);
+
+      if (TestEqual("Run Count", Runs.Num(), 2))
+      {
+        TestTrue("Text", Runs[0].Type == ETWMessageRunType::Text && Runs[0].Start == 0 && Runs[0].Length == 3);
+        TestTrue("Emote", Runs[1].Type == ETWMessageRunType::Emote && Runs[1].Start == 3 && Runs[1].Length == 5);
+      }
+    });
+
+    It("should find mentions, URLs and cheermotes", [this]()
+    {
+      TArray<FTWMessageRun> Runs;
+      TMIParser::TokenizeMessage(TEXT("hi @some_user, cheer100 https://twitch.tv."), {}, true, Runs);
+
+      if (TestEqual("Run Count", Runs.Num(), 7))
+      {
+        TestTrue("Text", Runs[0].Type == ETWMessageRunType::Text && Runs[0].Length == 3);
+        TestTrue("Mention", Runs[1].Type == ETWMessageRunType::Mention && Runs[1].Start == 3 && Runs[1].Length == 10);
+        TestTrue("Text", Runs[2].Type == ETWMessageRunType::Text && Runs[2].Length == 2);
+        TestTrue("Cheermote", Runs[3].Type == ETWMessageRunType::Cheermote && Runs[3].ID == TEXT("cheer") && Runs[3].Bits == 100);
+        TestTrue("URL", Runs[5].Type == ETWMessageRunType::URL && Runs[5].Start == 24 && Runs[5].Length == 17);
+        TestTrue("Trailing Text", Runs[6].Type == ETWMessageRunType::Text && Runs[6].Start == 41 && Runs[6].Length == 1);
+      }
+    });
+
+    It("should not treat words as cheermotes without bits", [this]()
+    {
+      TArray<FTWMessageRun> Runs;
+      TMIParser::TokenizeMessage(TEXT("cheer100"), {}, false, Runs);
+
+      TestTrue("Single Text Run", Runs.Num() == 1 && Runs[0].Type == ETWMessageRunType::Text);
+    });
+  }); // End Describe Tokenizing
 }
\ No newline at end of file
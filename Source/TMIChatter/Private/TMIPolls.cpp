@@ -0,0 +1,182 @@
+#include "TMIPolls.h"
+#include "TMIParser.h"
+#include "Hash/CityHash.h"
+
+int32 FTMIPollEngine::StartPoll(const FString& Channel, const FTWPollSettings& Settings, double Now)
+{
+  if (Settings.Options.Num() == 0 || Settings.Command.IsEmpty())
+    return INDEX_NONE;
+
+  if (TPair<int32, FPoll>* Running = FindPoll(Channel, Settings.Command))
+    Polls.Remove(Running->Key);
+
+  const int32 PollID = NextPollID++;
+  FPoll& Poll = Polls.Add(PollID);
+
+  Poll.Channel = Channel.ToLower();
+  Poll.Settings = Settings;
+  Poll.Voters.SetNumZeroed(Settings.Options.Num());
+  Poll.Weights.SetNumZeroed(Settings.Options.Num());
+  Poll.NextSnapshot = Now;
+
+  for (int32 Option = 0; Option < Settings.Options.Num(); ++Option)
+    Poll.OptionsByName.Add(Settings.Options[Option].ToLower(), Option);
+
+  return PollID;
+}
+
+bool FTMIPollEngine::EndPoll(int32 PollID, FTWPollSnapshot& OutSnapshot)
+{
+  const FPoll* Poll = Polls.Find(PollID);
+
+  if (!Poll)
+    return false;
+
+  Poll->FillSnapshot(PollID, OutSnapshot);
+  OutSnapshot.bClosed = true;
+
+  Polls.Remove(PollID);
+  return true;
+}
+
+bool FTMIPollEngine::HandleCommand(const FPrivMsgMessage& Message, const FString& Command, const FString& Params)
+{
+  if (Polls.Num() == 0)
+    return false;
+
+  TPair<int32, FPoll>* Found = FindPoll(Message.Channel, Command);
+
+  if (!Found)
+    return false;
+
+  FPoll& Poll = Found->Value;
+  const int32 Option = Poll.ParseOption(Params);
+
+  if (Option == INDEX_NONE || Message.Tags.UserID.IsEmpty())
+    return true;
+
+  FVote& Vote = Poll.Votes.FindOrAdd(GetUserKey(Message.Tags.UserID));
+
+  // Last vote wins, take the previous one off its option first
+  if (Vote.Option != INDEX_NONE)
+  {
+    Poll.Voters[Vote.Option] -= 1;
+    Poll.Weights[Vote.Option] -= Poll.GetWeight(Vote);
+  }
+
+  Vote.Option = Option;
+  Vote.Bits += Message.Tags.Bits;
+
+  Poll.Voters[Option] += 1;
+  Poll.Weights[Option] += Poll.GetWeight(Vote);
+  Poll.TotalVotesCast += 1;
+  Poll.bDirty = true;
+  return true;
+}
+
+void FTMIPollEngine::Tick(double Now, TFunctionRef<void(const FTWPollSnapshot&)> OnSnapshot)
+{
+  FTWPollSnapshot Snapshot;
+
+  for (TPair<int32, FPoll>& Pair : Polls)
+  {
+    FPoll& Poll = Pair.Value;
+
+    if (!Poll.bDirty || Now < Poll.NextSnapshot)
+      continue;
+
+    Poll.FillSnapshot(Pair.Key, Snapshot);
+    Poll.bDirty = false;
+    Poll.NextSnapshot = Now + Poll.Settings.SnapshotInterval;
+
+    OnSnapshot(Snapshot);
+  }
+}
+
+bool FTMIPollEngine::GetSnapshot(int32 PollID, FTWPollSnapshot& OutSnapshot) const
+{
+  const FPoll* Poll = Polls.Find(PollID);
+
+  if (!Poll)
+    return false;
+
+  Poll->FillSnapshot(PollID, OutSnapshot);
+  return true;
+}
+
+void FTMIPollEngine::Reset()
+{
+  Polls.Reset();
+}
+
+TPair<int32, FTMIPollEngine::FPoll>* FTMIPollEngine::FindPoll(const FString& Channel, const FString& Command)
+{
+  for (TPair<int32, FPoll>& Pair : Polls)
+  {
+    if (Pair.Value.Settings.Command.Equals(Command, ESearchCase::IgnoreCase) && Pair.Value.Channel.Equals(Channel, ESearchCase::IgnoreCase))
+      return &Pair;
+  }
+
+  return nullptr;
+}
+
+int32 FTMIPollEngine::FPoll::ParseOption(const FString& Params) const
+{
+  const TCHAR* Start = *Params;
+
+  while (FChar::IsWhitespace(*Start))
+    ++Start;
+
+  const TCHAR* End = Start;
+
+  while (*End && !FChar::IsWhitespace(*End))
+    ++End;
+
+  if (Start == End)
+    return INDEX_NONE;
+
+  // Numbers are the common case, don't allocate for them
+  int32 Number = 0;
+  const TCHAR* Digit = Start;
+
+  while (Digit < End && FChar::IsDigit(*Digit) && Number <= Voters.Num())
+    Number = Number * 10 + (*Digit++ - TCHAR('0'));
+
+  if (Digit == End)
+    return Number >= 1 && Number <= Voters.Num() ? Number - 1 : INDEX_NONE;
+
+  const int32* Option = OptionsByName.Find(FString(End - Start, Start).ToLower());
+  return Option ? *Option : INDEX_NONE;
+}
+
+int64 FTMIPollEngine::FPoll::GetWeight(const FVote& Vote) const
+{
+  return Settings.bWeightByBits ? 1 + Vote.Bits : 1;
+}
+
+void FTMIPollEngine::FPoll::FillSnapshot(int32 PollID, FTWPollSnapshot& OutSnapshot) const
+{
+  OutSnapshot.PollID = PollID;
+  OutSnapshot.Channel = Channel;
+  OutSnapshot.Voters = Voters;
+  OutSnapshot.Weights = Weights;
+  OutSnapshot.TotalVoters = Votes.Num();
+  OutSnapshot.TotalVotesCast = TotalVotesCast;
+  OutSnapshot.bClosed = false;
+}
+
+uint64 FTMIPollEngine::GetUserKey(const FString& UserID)
+{
+  // Twitch user-ids are numeric, keep them as integers so the dedupe set stays small
+  uint64 Key = 0;
+
+  for (TCHAR Char : UserID)
+  {
+    if (!FChar::IsDigit(Char) || Key > (MAX_uint64 - 9) / 10)
+      return CityHash64(reinterpret_cast<const char*>(*UserID), UserID.Len() * sizeof(TCHAR)) | (1ull << 63);
+
+    Key = Key * 10 + (Char - TCHAR('0'));
+  }
+
+  return Key;
+}
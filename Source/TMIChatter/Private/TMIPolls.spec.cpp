@@ -0,0 +1,158 @@
+#include "TMIPolls.h"
+#include "TMIParser.h"
+
+BEGIN_DEFINE_SPEC(TMIPollsSpec, "TMIPolls", EAutomationTestFlags::ProductFilter | EAutomationTestFlags::ApplicationContextMask)
+
+FTMIPollEngine Engine;
+FTWPollSnapshot Snapshot;
+int32 PollID;
+
+bool Vote(const FString& UserID, const FString& Params, int32 Bits = 0)
+{
+  FPrivMsgMessage Message;
+  Message.Channel = TEXT("ronni");
+  Message.Tags.UserID = UserID;
+  Message.Tags.Bits = Bits;
+  return Engine.HandleCommand(Message, TEXT("vote"), Params);
+}
+
+END_DEFINE_SPEC(TMIPollsSpec);
+
+void TMIPollsSpec::Define()
+{
+  BeforeEach([this]()
+  {
+    Engine.Reset();
+
+    FTWPollSettings Settings;
+    Settings.Options = { TEXT("Red"), TEXT("Blue"), TEXT("Green") };
+    PollID = Engine.StartPoll(TEXT("Ronni"), Settings, 0.0);
+  });
+
+  It("should tally votes by number and by name", [this]()
+  {
+    TestTrue("Number", Vote(TEXT("1"), TEXT(" 2")));
+    TestTrue("Name", Vote(TEXT("2"), TEXT(" blue")));
+    TestTrue("Other Option", Vote(TEXT("3"), TEXT(" 3")));
+
+    TestTrue("Snapshot", Engine.GetSnapshot(PollID, Snapshot));
+    TestEqual("Blue", Snapshot.Voters[1], 2);
+    TestEqual("Green", Snapshot.Voters[2], 1);
+    TestEqual("Total", Snapshot.TotalVoters, 3);
+  });
+
+  It("should swallow invalid votes but leave other commands alone", [this]()
+  {
+    TestTrue("Out Of Range", Vote(TEXT("1"), TEXT(" 4")));
+    TestTrue("Unknown Name", Vote(TEXT("1"), TEXT(" purple")));
+
+    FPrivMsgMessage Message;
+    Message.Channel = TEXT("ronni");
+    Message.Tags.UserID = TEXT("1");
+    TestFalse("Other Command", Engine.HandleCommand(Message, TEXT("dice"), TEXT("")));
+
+    Message.Channel = TEXT("other");
+    TestFalse("Other Channel", Engine.HandleCommand(Message, TEXT("vote"), TEXT(" 1")));
+
+    Engine.GetSnapshot(PollID, Snapshot);
+    TestEqual("No Voters", Snapshot.TotalVoters, 0);
+  });
+
+  It("should only count the last vote of a user", [this]()
+  {
+    Vote(TEXT("1"), TEXT(" 1"));
+    Vote(TEXT("1"), TEXT(" 3"));
+
+    Engine.GetSnapshot(PollID, Snapshot);
+    TestEqual("Red", Snapshot.Voters[0], 0);
+    TestEqual("Green", Snapshot.Voters[2], 1);
+    TestEqual("Voters", Snapshot.TotalVoters, 1);
+    TestEqual("Votes Cast", Snapshot.TotalVotesCast, (int64)2);
+  });
+
+  It("should weight votes by bits when asked to", [this]()
+  {
+    FTWPollSettings Settings;
+    Settings.Options = { TEXT("Red"), TEXT("Blue") };
+    Settings.bWeightByBits = true;
+    PollID = Engine.StartPoll(TEXT("ronni"), Settings, 0.0);
+
+    Vote(TEXT("1"), TEXT(" 1"), 100);
+    Vote(TEXT("2"), TEXT(" 2"));
+    Vote(TEXT("1"), TEXT(" 2"), 50);
+
+    Engine.GetSnapshot(PollID, Snapshot);
+    TestEqual("Red", Snapshot.Weights[0], (int64)0);
+    TestEqual("Blue", Snapshot.Weights[1], (int64)152);
+  });
+
+  It("should only snapshot changed polls once per interval", [this]()
+  {
+    int32 Snapshots = 0;
+    auto Count = [&Snapshots](const FTWPollSnapshot&) { ++Snapshots; };
+
+    Engine.Tick(0.0, Count);
+    TestEqual("Unchanged", Snapshots, 0);
+
+    Vote(TEXT("1"), TEXT(" 1"));
+    Engine.Tick(0.0, Count);
+    Vote(TEXT("2"), TEXT(" 1"));
+    Engine.Tick(0.5, Count);
+    TestEqual("Within Interval", Snapshots, 1);
+
+    Engine.Tick(1.0, Count);
+    TestEqual("Next Interval", Snapshots, 2);
+  });
+
+  It("should close with a final tally", [this]()
+  {
+    Vote(TEXT("1"), TEXT(" 1"));
+
+    TestTrue("Ended", Engine.EndPoll(PollID, Snapshot));
+    TestTrue("Closed", Snapshot.bClosed);
+    TestEqual("Red", Snapshot.Voters[0], 1);
+    TestFalse("No Longer Voting", Vote(TEXT("2"), TEXT(" 1")));
+  });
+}
+
+BEGIN_DEFINE_SPEC(TMIPollsBenchmarkSpec, "TMIPolls.Benchmark", EAutomationTestFlags::PerfFilter | EAutomationTestFlags::ApplicationContextMask)
+END_DEFINE_SPEC(TMIPollsBenchmarkSpec);
+
+void TMIPollsBenchmarkSpec::Define()
+{
+  It("should tally a million votes from 100k users", [this]()
+  {
+    const int32 VoteCount = 1000000;
+    const int32 UserCount = 100000;
+
+    FTMIPollEngine Engine;
+    FTWPollSettings Settings;
+    Settings.Options = { TEXT("1"), TEXT("2"), TEXT("3"), TEXT("4") };
+
+    const int32 PollID = Engine.StartPoll(TEXT("ronni"), Settings, 0.0);
+    const FString Command = TEXT("vote");
+    const FString Params[] = { TEXT(" 1"), TEXT(" 2"), TEXT(" 3"), TEXT(" 4") };
+
+    TArray<FPrivMsgMessage> Messages;
+    Messages.SetNum(UserCount);
+
+    for (int32 User = 0; User < UserCount; ++User)
+    {
+      Messages[User].Channel = TEXT("ronni");
+      Messages[User].Tags.UserID = FString::FromInt(10000000 + User);
+    }
+
+    const double Start = FPlatformTime::Seconds();
+
+    for (int32 Index = 0; Index < VoteCount; ++Index)
+      Engine.HandleCommand(Messages[Index % UserCount], Command, Params[Index & 3]);
+
+    const double Elapsed = FPlatformTime::Seconds() - Start;
+
+    FTWPollSnapshot Snapshot;
+    Engine.GetSnapshot(PollID, Snapshot);
+
+    TestEqual("Voters", Snapshot.TotalVoters, UserCount);
+    AddInfo(FString::Printf(TEXT("%d votes in %.3f ms, %.0f votes/s"), VoteCount, Elapsed * 1000.0, VoteCount / FMath::Max(Elapsed, 1e-9)));
+  });
+}
@@ -0,0 +1,75 @@
+#include "TMIReconnectPolicy.h"
+
+FTMIReconnectPolicy::FTMIReconnectPolicy()
+  : Random(static_cast<int32>(FPlatformTime::Cycles()))
+{
+}
+
+void FTMIReconnectPolicy::SetDelays(double InBaseDelay, double InMaxDelay)
+{
+  BaseDelay = FMath::Max(InBaseDelay, 0.0);
+  MaxDelay = FMath::Max(InMaxDelay, BaseDelay);
+}
+
+void FTMIReconnectPolicy::OnDisconnected(double Now)
+{
+  if (!bDown)
+  {
+    bDown = true;
+    DownSince = Now;
+  }
+}
+
+double FTMIReconnectPolicy::Schedule(double Now)
+{
+  // Capped before shifting so a long outage can't overflow the exponent
+  const double Ceiling = FMath::Min(MaxDelay, BaseDelay * static_cast<double>(1ull << FMath::Min(Failures, 30)));
+  const double Delay = Random.FRand() * Ceiling;
+
+  ++Failures;
+  bScheduled = true;
+  NextAttemptAt = Now + Delay;
+  return Delay;
+}
+
+void FTMIReconnectPolicy::OnAttempt()
+{
+  bScheduled = false;
+  ++Attempts;
+}
+
+void FTMIReconnectPolicy::OnAuthenticated(double Now)
+{
+  if (bDown)
+  {
+    LastDowntime = Now - DownSince;
+    LongestDowntime = FMath::Max(LongestDowntime, LastDowntime);
+    TotalDowntime += LastDowntime;
+    ++Reconnects;
+  }
+
+  bDown = false;
+  bScheduled = false;
+  Failures = 0;
+}
+
+void FTMIReconnectPolicy::Cancel()
+{
+  bScheduled = false;
+  bDown = false;
+  Failures = 0;
+}
+
+FTWReconnectStats FTMIReconnectPolicy::GetStats(double Now) const
+{
+  FTWReconnectStats Stats;
+  Stats.Reconnects = Reconnects;
+  Stats.Attempts = Attempts;
+  Stats.ConsecutiveFailures = Failures;
+  Stats.NextAttemptSeconds = bScheduled ? static_cast<float>(FMath::Max(NextAttemptAt - Now, 0.0)) : -1.f;
+  Stats.CurrentDowntimeSeconds = bDown ? static_cast<float>(Now - DownSince) : 0.f;
+  Stats.LastDowntimeSeconds = static_cast<float>(LastDowntime);
+  Stats.LongestDowntimeSeconds = static_cast<float>(LongestDowntime);
+  Stats.TotalDowntimeSeconds = static_cast<float>(TotalDowntime);
+  return Stats;
+}
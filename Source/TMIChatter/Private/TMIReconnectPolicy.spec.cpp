@@ -0,0 +1,79 @@
+#include "TMIReconnectPolicy.h"
+
+BEGIN_DEFINE_SPEC(TMIReconnectPolicySpec, "TMIReconnectPolicy", EAutomationTestFlags::ProductFilter | EAutomationTestFlags::ApplicationContextMask)
+
+TUniquePtr<FTMIReconnectPolicy> Policy;
+
+END_DEFINE_SPEC(TMIReconnectPolicySpec);
+
+void TMIReconnectPolicySpec::Define()
+{
+  BeforeEach([this]()
+  {
+    Policy = MakeUnique<FTMIReconnectPolicy>();
+    Policy->SetDelays(2.0, 60.0);
+    Policy->Seed(42);
+  });
+
+  It("should keep every delay under the doubling ceiling and the maximum", [this]()
+  {
+    double Ceiling = 2.0;
+
+    for (int32 Attempt = 0; Attempt < 12; ++Attempt)
+    {
+      const double Delay = Policy->Schedule(0.0);
+      TestTrue(FString::Printf(TEXT("Attempt %d"), Attempt), Delay >= 0.0 && Delay <= Ceiling);
+      Policy->OnAttempt();
+      Ceiling = FMath::Min(Ceiling * 2.0, 60.0);
+    }
+  });
+
+  It("should jitter the delays", [this]()
+  {
+    TSet<double> Delays;
+
+    for (int32 Index = 0; Index < 10; ++Index)
+    {
+      Policy->OnAuthenticated(0.0);
+      Delays.Add(Policy->Schedule(0.0));
+    }
+
+    TestTrue("Not All Equal", Delays.Num() > 1);
+  });
+
+  It("should only be due once the delay passed", [this]()
+  {
+    const double Delay = Policy->Schedule(10.0);
+
+    TestTrue("Scheduled", Policy->IsScheduled());
+    TestFalse("Early", Delay > 0.0 && Policy->IsDue(10.0 + Delay * 0.5));
+    TestTrue("Due", Policy->IsDue(10.0 + Delay));
+
+    Policy->OnAttempt();
+    TestFalse("Attempted", Policy->IsScheduled());
+  });
+
+  It("should measure downtime across failed attempts", [this]()
+  {
+    Policy->OnDisconnected(100.0);
+    Policy->Schedule(100.0);
+    Policy->OnAttempt();
+    Policy->OnDisconnected(103.0);
+    Policy->Schedule(103.0);
+
+    FTWReconnectStats Stats = Policy->GetStats(104.0);
+    TestEqual("Failures", Stats.ConsecutiveFailures, 2);
+    TestEqual("Current Downtime", Stats.CurrentDowntimeSeconds, 4.f);
+
+    Policy->OnAttempt();
+    Policy->OnAuthenticated(105.0);
+
+    Stats = Policy->GetStats(110.0);
+    TestEqual("Reconnects", Stats.Reconnects, 1);
+    TestEqual("Attempts", Stats.Attempts, 2);
+    TestEqual("Failures Reset", Stats.ConsecutiveFailures, 0);
+    TestEqual("Up Again", Stats.CurrentDowntimeSeconds, 0.f);
+    TestEqual("Last Downtime", Stats.LastDowntimeSeconds, 5.f);
+    TestEqual("Total Downtime", Stats.TotalDowntimeSeconds, 5.f);
+  });
+}
@@ -0,0 +1,157 @@
+#include "TMIShardPlanner.h"
+
+FTMIShardPlanner::FShard& FTMIShardPlanner::OpenShard()
+{
+  FShard& Shard = Shards.AddDefaulted_GetRef();
+  Shard.ID = NextShardID++;
+  return Shard;
+}
+
+FTMIShardPlanner::FShard* FTMIShardPlanner::FindLeastLoaded(int32 ExceptID)
+{
+  FShard* Best = nullptr;
+
+  for (FShard& Shard : Shards)
+  {
+    if (Shard.ID != ExceptID && Shard.Channels.Num() < ChannelsPerShard && (!Best || Shard.Channels.Num() < Best->Channels.Num()))
+      Best = &Shard;
+  }
+
+  return Best;
+}
+
+void FTMIShardPlanner::Place(const FString& Channel, FShard& Shard)
+{
+  Shard.Channels.Add(Channel);
+  ChannelShards.Add(Channel, Shard.ID);
+}
+
+int32 FTMIShardPlanner::Add(const FString& Channel)
+{
+  if (const int32* ShardID = ChannelShards.Find(Channel))
+    return *ShardID;
+
+  FShard* Shard = FindLeastLoaded();
+  FShard& Target = Shard ? *Shard : OpenShard();
+
+  Place(Channel, Target);
+  return Target.ID;
+}
+
+void FTMIShardPlanner::AddMany(const TArray<FString>& Channels)
+{
+  int32 Total = ChannelShards.Num();
+
+  for (const FString& Channel : Channels)
+  {
+    if (!ChannelShards.Contains(Channel))
+      ++Total;
+  }
+
+  const int32 Needed = FMath::DivideAndRoundUp(Total, ChannelsPerShard);
+
+  while (Shards.Num() < Needed)
+    OpenShard();
+
+  for (const FString& Channel : Channels)
+    Add(Channel);
+}
+
+int32 FTMIShardPlanner::Remove(const FString& Channel, TArray<FTMIShardMove>& OutMoves)
+{
+  int32 ShardID = INDEX_NONE;
+
+  if (!ChannelShards.RemoveAndCopyValue(Channel, ShardID))
+    return INDEX_NONE;
+
+  for (FShard& Shard : Shards)
+  {
+    if (Shard.ID == ShardID)
+    {
+      Shard.Channels.Remove(Channel);
+      break;
+    }
+  }
+
+  Compact(OutMoves);
+  return ShardID;
+}
+
+void FTMIShardPlanner::SetChannelsPerShard(int32 Limit, TArray<FTMIShardMove>& OutMoves)
+{
+  ChannelsPerShard = FMath::Max(Limit, 1);
+
+  // Overflow goes to the least loaded shard with room, so shards opened here fill up evenly too
+  for (int32 Index = 0; Index < Shards.Num(); ++Index)
+  {
+    while (Shards[Index].Channels.Num() > ChannelsPerShard)
+    {
+      const int32 FromID = Shards[Index].ID;
+      const FString Channel = Shards[Index].Channels.Pop();
+
+      FShard* Shard = FindLeastLoaded(FromID);
+      FShard& Target = Shard ? *Shard : OpenShard();
+
+      Place(Channel, Target);
+      OutMoves.Add({ Channel, FromID, Target.ID });
+    }
+  }
+
+  Compact(OutMoves);
+}
+
+void FTMIShardPlanner::Compact(TArray<FTMIShardMove>& OutMoves)
+{
+  while (Shards.Num() > FMath::DivideAndRoundUp(ChannelShards.Num(), ChannelsPerShard))
+  {
+    int32 Smallest = 0;
+
+    for (int32 Index = 1; Index < Shards.Num(); ++Index)
+    {
+      if (Shards[Index].Channels.Num() < Shards[Smallest].Channels.Num())
+        Smallest = Index;
+    }
+
+    const FShard Drained = Shards[Smallest];
+    Shards.RemoveAt(Smallest);
+
+    // The others have room for all of them, otherwise we wouldn't have one shard too many
+    for (const FString& Channel : Drained.Channels)
+    {
+      FShard& Target = *FindLeastLoaded();
+      Place(Channel, Target);
+      OutMoves.Add({ Channel, Drained.ID, Target.ID });
+    }
+  }
+}
+
+int32 FTMIShardPlanner::FindShard(const FString& Channel) const
+{
+  const int32* ShardID = ChannelShards.Find(Channel);
+  return ShardID ? *ShardID : INDEX_NONE;
+}
+
+const TArray<FString>& FTMIShardPlanner::GetChannels(int32 ShardID) const
+{
+  static const TArray<FString> None;
+
+  for (const FShard& Shard : Shards)
+  {
+    if (Shard.ID == ShardID)
+      return Shard.Channels;
+  }
+
+  return None;
+}
+
+void FTMIShardPlanner::GetShardIDs(TArray<int32>& OutShardIDs) const
+{
+  for (const FShard& Shard : Shards)
+    OutShardIDs.Add(Shard.ID);
+}
+
+void FTMIShardPlanner::Reset()
+{
+  Shards.Reset();
+  ChannelShards.Reset();
+}
@@ -0,0 +1,100 @@
+#include "TMIShardPlanner.h"
+
+BEGIN_DEFINE_SPEC(TMIShardPlannerSpec, "TMIShardPlanner", EAutomationTestFlags::ProductFilter | EAutomationTestFlags::ApplicationContextMask)
+
+TUniquePtr<FTMIShardPlanner> Planner;
+TArray<FTMIShardMove> Moves;
+
+TArray<FString> MakeChannels(int32 Count, int32 First = 0) const
+{
+  TArray<FString> Channels;
+
+  for (int32 Index = First; Index < First + Count; ++Index)
+    Channels.Add(FString::Printf(TEXT("c%d"), Index));
+
+  return Channels;
+}
+
+END_DEFINE_SPEC(TMIShardPlannerSpec);
+
+void TMIShardPlannerSpec::Define()
+{
+  BeforeEach([this]()
+  {
+    Planner = MakeUnique<FTMIShardPlanner>();
+    Planner->SetChannelsPerShard(10, Moves);
+    Moves.Reset();
+  });
+
+  It("should open a shard only once the others are full", [this]()
+  {
+    for (const FString& Channel : MakeChannels(10))
+      TestEqual("First Shard", Planner->Add(Channel), 0);
+
+    TestEqual("Second Shard", Planner->Add(TEXT("c10")), 1);
+    TestEqual("Known Channel", Planner->Add(TEXT("C3")), 0);
+    TestEqual("Shards", Planner->NumShards(), 2);
+  });
+
+  It("should spread channels added together evenly", [this]()
+  {
+    Planner->AddMany(MakeChannels(25));
+
+    TArray<int32> ShardIDs;
+    Planner->GetShardIDs(ShardIDs);
+
+    if (TestEqual("Shards", ShardIDs.Num(), 3))
+    {
+      for (int32 ShardID : ShardIDs)
+        TestTrue("Balanced", FMath::Abs(Planner->GetChannels(ShardID).Num() - 8) <= 1);
+    }
+  });
+
+  It("should drain the smallest shard once the rest can hold its channels", [this]()
+  {
+    Planner->AddMany(MakeChannels(20));
+
+    for (int32 Index = 0; Index < 5; ++Index)
+      Planner->Remove(FString::Printf(TEXT("c%d"), Index), Moves);
+
+    TestEqual("Still Two", Planner->NumShards(), 2);
+    TestEqual("Not Moved Yet", Moves.Num(), 0);
+
+    for (int32 Index = 5; Index < 10; ++Index)
+      Planner->Remove(FString::Printf(TEXT("c%d"), Index), Moves);
+
+    TestEqual("One Shard", Planner->NumShards(), 1);
+    TestEqual("Channels", Planner->NumChannels(), 10);
+
+    for (const FTMIShardMove& Move : Moves)
+    {
+      TestNotEqual("Moved Away", Move.FromShard, Move.ToShard);
+      TestEqual("Owner", Planner->FindShard(Move.Channel), Move.ToShard);
+    }
+  });
+
+  It("should move the overflow when the limit goes down", [this]()
+  {
+    Planner->AddMany(MakeChannels(10));
+    Planner->SetChannelsPerShard(4, Moves);
+
+    TestEqual("Shards", Planner->NumShards(), 3);
+    TestEqual("Moves", Moves.Num(), 6);
+
+    TArray<int32> ShardIDs;
+    Planner->GetShardIDs(ShardIDs);
+
+    for (int32 ShardID : ShardIDs)
+      TestTrue("Within Limit", Planner->GetChannels(ShardID).Num() <= 4);
+  });
+
+  It("should close shards a higher limit makes unnecessary", [this]()
+  {
+    Planner->AddMany(MakeChannels(30));
+    Planner->SetChannelsPerShard(100, Moves);
+
+    TestEqual("Shards", Planner->NumShards(), 1);
+    TestEqual("Moves", Moves.Num(), 20);
+    TestEqual("Channels", Planner->NumChannels(), 30);
+  });
+}
@@ -0,0 +1,552 @@
+#include "TMITcpTransport.h"
+#include "TMILineSplitter.h"
+#include "Async/Async.h"
+#include "Misc/ScopeLock.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+#if WITH_SSL
+#include "Ssl.h"
+#include "Interfaces/ISslManager.h"
+
+#define UI UI_ST
+THIRD_PARTY_INCLUDES_START
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+THIRD_PARTY_INCLUDES_END
+#undef UI
+#endif
+
+struct FTMITcpTransport::FTlsContext
+{
+#if WITH_SSL
+  ISslManager* Manager = nullptr;		// Looked up on the game thread, the last connection may let go of us on its own
+  SSL_CTX* Context = nullptr;
+
+  ~FTlsContext()
+  {
+    if (Manager == nullptr)
+      return;
+
+    if (Context != nullptr)
+      Manager->DestroySslContext(Context);
+
+    Manager->ShutdownSsl();
+  }
+#endif
+};
+
+struct FTMITcpTransport::FConnection
+{
+  FConnection(const FString& InHost, int32 InPort, const TSharedPtr<FTlsContext, ESPMode::ThreadSafe>& InTls)
+    : Host(InHost)
+    , Port(InPort)
+    , Tls(InTls)
+  {
+  }
+
+  const FString Host;
+  const int32 Port;
+  const TSharedPtr<FTlsContext, ESPMode::ThreadSafe> Tls;	// Null for plain TCP
+
+  std::atomic<bool> bStopping{ false };		// Closed, replaced, or the thread is done
+  std::atomic<bool> bConnected{ false };
+
+  // Senders on any thread share the socket and the TLS session with the receive thread
+  FCriticalSection Lock;
+  FSocket* Socket = nullptr;		// Set once connected, cleared by the thread on its way out
+
+#if WITH_SSL
+  SSL* Session = nullptr;
+  BIO* Incoming = nullptr;		// Owned by Session
+  BIO* Outgoing = nullptr;		// Owned by Session
+#endif
+
+  // Connection thread only
+  FTMILineSplitter Splitter{ MaxLineBytes };
+  TArray<uint8> Encrypted;		// One TLS record at most
+
+  bool Open(FString& OutError);
+  bool StartTls(FSocket& Connection, FString& OutError);
+  bool HasBufferedInput();
+  bool Receive(uint8* Into, int32 Size, int32& OutRead);
+  bool Send(const uint8* Data, int32 Size, FString& OutError);
+  bool FlushTls(FSocket& Connection);
+  void Shutdown();
+};
+
+FTMITcpTransport::FTMITcpTransport(const FString& InHost, int32 InPort, bool bInUseTls)
+  : Host(InHost)
+  , Port(InPort)
+  , bUseTls(bInUseTls)
+{
+  if (!bUseTls)
+    return;
+
+  Tls = MakeShared<FTlsContext, ESPMode::ThreadSafe>();
+
+#if WITH_SSL
+  // The SSL module is loaded here on the game thread, connection threads only create sessions
+  ISslManager& Manager = FSslModule::Get().GetSslManager();
+
+  if (Manager.InitializeSsl())
+  {
+    Tls->Manager = &Manager;
+    Tls->Context = Manager.CreateSslContext(FSslContextCreateOptions());
+  }
+#endif
+}
+
+FTMITcpTransport::~FTMITcpTransport()
+{
+  // The connection's thread tidies up by itself, our events are gone by the time it posts any
+  if (Current.IsValid())
+    Current->bStopping = true;
+}
+
+void FTMITcpTransport::SetEvents(FTMITransportEvents InEvents)
+{
+  FScopeLock Lock(&EventsLock);
+  Events = MoveTemp(InEvents);
+}
+
+void FTMITcpTransport::Connect()
+{
+  const FConnectionPtr Connection = MakeShared<FConnection, ESPMode::ThreadSafe>(Host, Port, Tls);
+
+  {
+    FScopeLock Lock(&CurrentLock);
+
+    if (Current.IsValid() && !Current->bStopping)
+      return;
+
+    Current = Connection;
+  }
+
+  // The thread holds the connection until it's done and deletes itself, nobody ever waits for it
+  Async(EAsyncExecution::Thread, [WeakTransport = TWeakPtr<FTMITcpTransport, ESPMode::ThreadSafe>(AsShared()), Connection]()
+  {
+    Run(WeakTransport, Connection);
+  });
+}
+
+void FTMITcpTransport::Close()
+{
+  FScopeLock Lock(&CurrentLock);
+
+  if (!Current.IsValid())
+    return;
+
+  Current->bStopping = true;
+  Current.Reset();
+}
+
+bool FTMITcpTransport::IsConnected() const
+{
+  const FConnectionPtr Connection = GetCurrent();
+  return Connection.IsValid() && Connection->bConnected;
+}
+
+FTMITcpTransport::FConnectionPtr FTMITcpTransport::GetCurrent() const
+{
+  FScopeLock Lock(&CurrentLock);
+  return Current;
+}
+
+void FTMITcpTransport::Send(const FString& Text)
+{
+  const FTCHARToUTF8 Converted(*Text, Text.Len());
+  Send(reinterpret_cast<const uint8*>(Converted.Get()), Converted.Length());
+}
+
+void FTMITcpTransport::Send(const uint8* Data, int32 Size)
+{
+  const FConnectionPtr Connection = GetCurrent();
+
+  if (!Connection.IsValid() || !Connection->bConnected || Size <= 0)
+    return;
+
+  FString Error;
+
+  if (Connection->Send(Data, Size, Error))
+    return;
+
+  // A frame that didn't make it leaves the stream broken, the thread closes the socket and Closed follows
+  Connection->bStopping = true;
+  Post(AsShared(), Connection, [Error](FTMITransportEvents& Posted) { if (Posted.Error) Posted.Error(Error); });
+}
+
+void FTMITcpTransport::Run(TWeakPtr<FTMITcpTransport, ESPMode::ThreadSafe> WeakTransport, FConnectionPtr Connection)
+{
+  FString Error;
+
+  if (!Connection->Open(Error))
+  {
+    Connection->bStopping = true;
+    Post(WeakTransport, Connection, [Error](FTMITransportEvents& Posted) { if (Posted.Error) Posted.Error(Error); });
+    return;
+  }
+
+  Post(WeakTransport, Connection, [](FTMITransportEvents& Posted) { if (Posted.Connected) Posted.Connected(); });
+
+  FSocket* Socket = Connection->Socket;
+  FString Reason = TEXT("Closed");
+
+  while (!Connection->bStopping)
+  {
+    // Decrypted bytes left over from the last record don't wake the socket
+    if (!Connection->HasBufferedInput() && !Socket->Wait(ESocketWaitConditions::WaitForRead, FTimespan::FromMilliseconds(100)))
+    {
+      if (Socket->GetConnectionState() == SCS_ConnectionError)
+      {
+        Reason = TEXT("Connection error");
+        break;
+      }
+
+      continue;
+    }
+
+    int32 Size = 0;
+    uint8* Into = Connection->Splitter.GetWritable(Size);
+
+    if (Into == nullptr)
+    {
+      Reason = TEXT("Line too long");
+      break;
+    }
+
+    int32 Read = 0;
+
+    if (!Connection->Receive(Into, Size, Read))
+    {
+      Reason = TEXT("Connection closed by the server");
+      break;
+    }
+
+    const TSharedPtr<FTMITcpTransport, ESPMode::ThreadSafe> Transport = WeakTransport.Pin();
+
+    if (!Transport.IsValid())
+      break;
+
+    FScopeLock Lock(&Transport->EventsLock);
+
+    Connection->Splitter.Commit(Read, [&Transport, &Connection](FString&& Line)
+    {
+      // Nothing more once we're closed, even from the middle of a read
+      if (!Connection->bStopping && Transport->Events.Line)
+        Transport->Events.Line(MoveTemp(Line));
+    });
+  }
+
+  Connection->bConnected = false;
+  Connection->Shutdown();
+  Connection->bStopping = true;
+
+  // Also for connections that were closed or replaced since, their owner is waiting for it
+  Post(WeakTransport, Connection, [Reason](FTMITransportEvents& Posted) { if (Posted.Closed) Posted.Closed(Reason); }, false);
+}
+
+void FTMITcpTransport::Post(const TWeakPtr<FTMITcpTransport, ESPMode::ThreadSafe>& WeakTransport, const FConnectionPtr& Connection,
+  TFunction<void(FTMITransportEvents& Events)> Post, bool bCurrentOnly)
+{
+  AsyncTask(ENamedThreads::GameThread, [WeakTransport, Connection, Post = MoveTemp(Post), bCurrentOnly]()
+  {
+    const TSharedPtr<FTMITcpTransport, ESPMode::ThreadSafe> Transport = WeakTransport.Pin();
+
+    if (!Transport.IsValid() || (bCurrentOnly && Transport->GetCurrent() != Connection))
+      return;
+
+    // Events are read when the task runs, after the owner may have replaced them
+    FTMITransportEvents Current;
+
+    {
+      FScopeLock Lock(&Transport->EventsLock);
+      Current = Transport->Events;
+    }
+
+    Post(Current);
+  });
+}
+
+// Blocks until everything is out or the socket fails
+static bool SendAll(FSocket& Connection, const uint8* Data, int32 Size)
+{
+  while (Size > 0)
+  {
+    int32 Sent = 0;
+
+    if (!Connection.Send(Data, Size, Sent))
+      return false;
+
+    Data += Sent;
+    Size -= Sent;
+  }
+
+  return true;
+}
+
+bool FTMITcpTransport::FConnection::Open(FString& OutError)
+{
+  ISocketSubsystem* Subsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+
+  // The lookup can't be interrupted, but nothing waits for this thread
+  const FAddressInfoResult Resolved = Subsystem->GetAddressInfo(*Host, *FString::FromInt(Port), EAddressInfoFlags::Default, NAME_None, ESocketType::SOCKTYPE_Streaming);
+
+  if (Resolved.ReturnCode != SE_NO_ERROR || Resolved.Results.Num() == 0)
+  {
+    OutError = FString::Printf(TEXT("Could not resolve %s"), *Host);
+    return false;
+  }
+
+  const TSharedRef<FInternetAddr> Address = Resolved.Results[0].Address;
+  FSocket* NewSocket = bStopping ? nullptr : Subsystem->CreateSocket(NAME_Stream, TEXT("TMITcpTransport"), Address->GetProtocolType());
+
+  if (NewSocket == nullptr)
+  {
+    OutError = FString::Printf(TEXT("Could not connect to %s:%d"), *Host, Port);
+    return false;
+  }
+
+  // Non-blocking, so Close and the timeout are noticed while the connect is in progress
+  NewSocket->SetNonBlocking(true);
+
+  const ESocketErrors Started = NewSocket->Connect(*Address) ? SE_NO_ERROR : Subsystem->GetLastErrorCode();
+  bool bConnecting = Started == SE_NO_ERROR || Started == SE_EWOULDBLOCK || Started == SE_EINPROGRESS;
+  const double Deadline = FPlatformTime::Seconds() + ConnectTimeout;
+
+  while (bConnecting && !bStopping && !NewSocket->Wait(ESocketWaitConditions::WaitForWrite, FTimespan::FromMilliseconds(100)))
+    bConnecting = NewSocket->GetConnectionState() != SCS_ConnectionError && FPlatformTime::Seconds() < Deadline;
+
+  if (!bConnecting || bStopping || NewSocket->GetConnectionState() != SCS_Connected)
+  {
+    Subsystem->DestroySocket(NewSocket);
+    OutError = FString::Printf(TEXT("Could not connect to %s:%d"), *Host, Port);
+    return false;
+  }
+
+  NewSocket->SetNonBlocking(false);
+  NewSocket->SetNoDelay(true);
+
+  if (Tls.IsValid() && !StartTls(*NewSocket, OutError))
+  {
+    Shutdown();
+    NewSocket->Close();
+    Subsystem->DestroySocket(NewSocket);
+    return false;
+  }
+
+  FScopeLock Guard(&Lock);
+
+  // Closed while the handshake finished, nobody is going to expect Closed from us
+  if (bStopping)
+  {
+    Shutdown();
+    NewSocket->Close();
+    Subsystem->DestroySocket(NewSocket);
+    return false;
+  }
+
+  Socket = NewSocket;
+  bConnected = true;
+  return true;
+}
+
+bool FTMITcpTransport::FConnection::StartTls(FSocket& Connection, FString& OutError)
+{
+#if WITH_SSL
+  if (Tls->Context == nullptr)
+  {
+    OutError = TEXT("Could not set up TLS");
+    return false;
+  }
+
+  Session = SSL_new(Tls->Context);
+  Incoming = BIO_new(BIO_s_mem());
+  Outgoing = BIO_new(BIO_s_mem());
+  SSL_set_bio(Session, Incoming, Outgoing);
+  SSL_set_connect_state(Session);
+
+  // The chain against the root certificates, the leaf against the host we asked for
+  const FTCHARToUTF8 HostName(*Host);
+  SSL_set_verify(Session, SSL_VERIFY_PEER, nullptr);
+  SSL_set_tlsext_host_name(Session, HostName.Get());
+  X509_VERIFY_PARAM_set1_host(SSL_get0_param(Session), HostName.Get(), 0);
+
+  Encrypted.SetNumUninitialized(16 * 1024);
+
+  // Nobody else has the socket yet, the handshake doesn't need the lock
+  while (!bStopping)
+  {
+    const int Result = SSL_do_handshake(Session);
+
+    if (!FlushTls(Connection))
+      break;
+
+    if (Result == 1)
+      return true;
+
+    if (SSL_get_error(Session, Result) != SSL_ERROR_WANT_READ)
+    {
+      const long Verified = SSL_get_verify_result(Session);
+      OutError = FString::Printf(TEXT("TLS handshake with %s failed: %s"), *Host,
+        Verified != X509_V_OK ? UTF8_TO_TCHAR(X509_verify_cert_error_string(Verified)) : TEXT("protocol error"));
+      return false;
+    }
+
+    if (!Connection.Wait(ESocketWaitConditions::WaitForRead, FTimespan::FromMilliseconds(100)))
+    {
+      if (Connection.GetConnectionState() == SCS_ConnectionError)
+        break;
+
+      continue;
+    }
+
+    int32 Read = 0;
+
+    if (!Connection.Recv(Encrypted.GetData(), Encrypted.Num(), Read) || Read == 0)
+      break;
+
+    BIO_write(Incoming, Encrypted.GetData(), Read);
+  }
+
+  OutError = FString::Printf(TEXT("Connection to %s:%d closed during the TLS handshake"), *Host, Port);
+  return false;
+#else
+  OutError = TEXT("TLS isn't available on this platform");
+  return false;
+#endif
+}
+
+bool FTMITcpTransport::FConnection::HasBufferedInput()
+{
+#if WITH_SSL
+  if (Tls.IsValid())
+  {
+    FScopeLock Guard(&Lock);
+    return SSL_pending(Session) > 0 || BIO_ctrl_pending(Incoming) > 0;
+  }
+#endif
+
+  return false;
+}
+
+bool FTMITcpTransport::FConnection::Receive(uint8* Into, int32 Size, int32& OutRead)
+{
+  OutRead = 0;
+
+  if (!Tls.IsValid())
+    return Socket->Recv(Into, Size, OutRead) && OutRead > 0;
+
+#if WITH_SSL
+  // The socket is read outside the lock, only the session is shared with senders
+  int32 Read = 0;
+
+  if (!HasBufferedInput() && (!Socket->Recv(Encrypted.GetData(), Encrypted.Num(), Read) || Read == 0))
+    return false;
+
+  FScopeLock Guard(&Lock);
+
+  if (Read > 0)
+    BIO_write(Incoming, Encrypted.GetData(), Read);
+
+  const int Result = SSL_read(Session, Into, Size);
+
+  // Key updates and the like are answered right away
+  if (!FlushTls(*Socket))
+    return false;
+
+  if (Result > 0)
+  {
+    OutRead = Result;
+    return true;
+  }
+
+  // Half a record, the rest is still on its way
+  return SSL_get_error(Session, Result) == SSL_ERROR_WANT_READ;
+#else
+  return false;
+#endif
+}
+
+bool FTMITcpTransport::FConnection::Send(const uint8* Data, int32 Size, FString& OutError)
+{
+  // The receive thread answers PINGs while the game thread sends, lines mustn't interleave
+  FScopeLock Guard(&Lock);
+
+  if (Socket == nullptr)
+    return true;
+
+  OutError = FString::Printf(TEXT("Could not send to %s:%d"), *Host, Port);
+
+  if (!Tls.IsValid())
+    return SendAll(*Socket, Data, Size);
+
+#if WITH_SSL
+  int Result = 0;
+
+  while ((Result = SSL_write(Session, Data, Size)) <= 0)
+  {
+    const int Reason = SSL_get_error(Session, Result);
+
+    if (Reason != SSL_ERROR_WANT_READ && Reason != SSL_ERROR_WANT_WRITE)
+    {
+      OutError = FString::Printf(TEXT("TLS write to %s failed (%d)"), *Host, Reason);
+      return false;
+    }
+
+    // The session wants the peer first, the receive thread feeds it once we let go of the lock
+    if (!FlushTls(*Socket))
+      return false;
+
+    {
+      FScopeUnlock Unlock(&Lock);
+      FPlatformProcess::Sleep(0.001f);
+    }
+
+    if (Socket == nullptr || bStopping)
+      return true;
+  }
+
+  return FlushTls(*Socket);
+#else
+  return false;
+#endif
+}
+
+bool FTMITcpTransport::FConnection::FlushTls(FSocket& Connection)
+{
+#if WITH_SSL
+  uint8 Chunk[4096];
+  int Pending = 0;
+
+  while ((Pending = BIO_read(Outgoing, Chunk, sizeof(Chunk))) > 0)
+  {
+    if (!SendAll(Connection, Chunk, Pending))
+      return false;
+  }
+#endif
+
+  return true;
+}
+
+void FTMITcpTransport::FConnection::Shutdown()
+{
+  FScopeLock Guard(&Lock);
+
+#if WITH_SSL
+  if (Session != nullptr)
+  {
+    SSL_free(Session);
+    Session = nullptr;
+    Incoming = nullptr;
+    Outgoing = nullptr;
+  }
+#endif
+
+  if (Socket != nullptr)
+  {
+    Socket->Close();
+    ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+    Socket = nullptr;
+  }
+}
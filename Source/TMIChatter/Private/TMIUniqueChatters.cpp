@@ -0,0 +1,109 @@
+#include "TMIUniqueChatters.h"
+#include "Hash/CityHash.h"
+
+void FTMIUniqueChatters::SetWindow(float InWindowSeconds)
+{
+  WindowSeconds = FMath::Max(InWindowSeconds, 1.f);
+  Channels.Reset();
+}
+
+int64 FTMIUniqueChatters::GetSlice(double Now) const
+{
+  return FMath::FloorToInt64(Now * SliceCount / WindowSeconds);
+}
+
+void FTMIUniqueChatters::FChannelSketches::Advance(int64 Slice)
+{
+  if (Slice <= HeadSlice)
+    return;
+
+  const int64 Steps = FMath::Min<int64>(Slice - HeadSlice, SliceCount);
+
+  for (int64 Step = 1; Step <= Steps; ++Step)
+  {
+    FMemory::Memzero(Registers[(HeadSlice + Step) % SliceCount]);
+  }
+
+  HeadSlice = Slice;
+}
+
+void FTMIUniqueChatters::Add(const FString& Channel, const FString& UserID, double Now)
+{
+  if (UserID.IsEmpty())
+    return;
+
+  const int64 Slice = GetSlice(Now);
+  TUniquePtr<FChannelSketches>& Sketches = Channels.FindOrAdd(Channel);
+
+  if (!Sketches.IsValid())
+  {
+    Sketches = MakeUnique<FChannelSketches>();
+    FMemory::Memzero(Sketches->Registers);
+    Sketches->HeadSlice = Slice;
+  }
+
+  Sketches->Advance(Slice);
+
+  // The top bits pick the register, the run of leading zeros in the rest is what it remembers
+  const uint64 Hash = CityHash64(reinterpret_cast<const char*>(*UserID), UserID.Len() * sizeof(TCHAR));
+  const uint32 Register = static_cast<uint32>(Hash >> (64 - Precision));
+  const uint64 Remainder = (Hash << Precision) | (1ull << (Precision - 1));	// Sentinel bit caps the rank
+  const uint8 Rank = static_cast<uint8>(FMath::CountLeadingZeros64(Remainder) + 1);
+
+  uint8& Value = Sketches->Registers[Sketches->HeadSlice % SliceCount][Register];
+  Value = FMath::Max(Value, Rank);
+}
+
+bool FTMIUniqueChatters::Estimate(const FString& Channel, double Now, FTWUniqueChatterEstimate& OutEstimate) const
+{
+  OutEstimate = FTWUniqueChatterEstimate();
+  OutEstimate.RelativeError = GetRelativeError();
+  OutEstimate.WindowSeconds = WindowSeconds;
+
+  const TUniquePtr<FChannelSketches>* Sketches = Channels.Find(Channel);
+
+  if (!Sketches)
+    return false;
+
+  (*Sketches)->Advance(GetSlice(Now));
+
+  double InverseSum = 0.0;
+  int32 ZeroRegisters = 0;
+
+  for (int32 Register = 0; Register < RegisterCount; ++Register)
+  {
+    uint8 Value = 0;
+
+    for (int32 Slice = 0; Slice < SliceCount; ++Slice)
+      Value = FMath::Max(Value, (*Sketches)->Registers[Slice][Register]);
+
+    InverseSum += FMath::Pow(2.0, -static_cast<double>(Value));
+    ZeroRegisters += Value == 0;
+  }
+
+  const double M = RegisterCount;
+  const double Alpha = 0.7213 / (1.0 + 1.079 / M);
+  double Estimate = Alpha * M * M / InverseSum;
+
+  // Small range correction, linear counting is more accurate while many registers are still empty
+  if (Estimate <= 2.5 * M && ZeroRegisters > 0)
+    Estimate = M * FMath::Loge(M / ZeroRegisters);
+
+  OutEstimate.Estimate = FMath::RoundToInt64(Estimate);
+  return true;
+}
+
+float FTMIUniqueChatters::GetRelativeError()
+{
+  return 1.04f / FMath::Sqrt(static_cast<float>(RegisterCount));
+}
+
+void FTMIUniqueChatters::Remove(const FString& Channel)
+{
+  Channels.Remove(Channel);
+}
+
+void FTMIUniqueChatters::Reset()
+{
+  Channels.Reset();
+}
@@ -0,0 +1,57 @@
+#include "TMIUniqueChatters.h"
+
+BEGIN_DEFINE_SPEC(TMIUniqueChattersSpec, "TMIUniqueChatters", EAutomationTestFlags::ProductFilter | EAutomationTestFlags::ApplicationContextMask)
+
+FTMIUniqueChatters Chatters;
+FTWUniqueChatterEstimate Estimate;
+
+END_DEFINE_SPEC(TMIUniqueChattersSpec);
+
+void TMIUniqueChattersSpec::Define()
+{
+  BeforeEach([this]()
+  {
+    Chatters.SetWindow(60.f);
+  });
+
+  It("should count small sets closely and ignore repeats", [this]()
+  {
+    for (int32 Repeat = 0; Repeat < 10; ++Repeat)
+    {
+      for (int32 User = 0; User < 20; ++User)
+        Chatters.Add(TEXT("ronni"), FString::FromInt(User), 1.0);
+    }
+
+    TestTrue("Has Estimate", Chatters.Estimate(TEXT("ronni"), 1.0, Estimate));
+    TestTrue("Close To 20", FMath::Abs(Estimate.Estimate - 20) <= 2);
+  });
+
+  It("should stay within the error bound for large sets", [this]()
+  {
+    const int32 Users = 50000;
+
+    for (int32 User = 0; User < Users; ++User)
+      Chatters.Add(TEXT("ronni"), FString::FromInt(100000 + User), 1.0);
+
+    TestTrue("Has Estimate", Chatters.Estimate(TEXT("ronni"), 1.0, Estimate));
+
+    // Three standard errors
+    const double Error = FMath::Abs(static_cast<double>(Estimate.Estimate - Users)) / Users;
+    TestTrue(FString::Printf(TEXT("Relative error %f"), Error), Error <= 3.0 * Estimate.RelativeError);
+  });
+
+  It("should forget chatters once the window passed them", [this]()
+  {
+    Chatters.Add(TEXT("ronni"), TEXT("1"), 1.0);
+    Chatters.Add(TEXT("ronni"), TEXT("2"), 45.0);
+
+    TestTrue("Has Estimate", Chatters.Estimate(TEXT("ronni"), 50.0, Estimate));
+    TestEqual("Both", Estimate.Estimate, (int64)2);
+
+    Chatters.Estimate(TEXT("ronni"), 70.0, Estimate);
+    TestEqual("First Expired", Estimate.Estimate, (int64)1);
+
+    Chatters.Estimate(TEXT("ronni"), 200.0, Estimate);
+    TestEqual("All Expired", Estimate.Estimate, (int64)0);
+  });
+}
@@ -0,0 +1,148 @@
+#include "TMIUserDirectory.h"
+
+FTMIUserDirectory::FTMIUserDirectory(int32 InCapacity)
+{
+  SetCapacity(InCapacity);
+}
+
+void FTMIUserDirectory::SetCapacity(int32 NewCapacity)
+{
+  Capacity = FMath::Max(NewCapacity, 0);
+
+  while (Index.Num() > Capacity)
+  {
+    EvictOldest();
+  }
+}
+
+TSharedRef<const FTWChatterInfo> FTMIUserDirectory::MakeInfo(const FString& UserID, const FString& Login, const FTWRawChatterTags& Raw)
+{
+  TSharedRef<FTWChatterInfo> Info = MakeShared<FTWChatterInfo>();
+  TMIParser::ParseChatterInfo(UserID, Login, Raw, Info.Get());
+  return Info;
+}
+
+TSharedRef<const FTWChatterInfo> FTMIUserDirectory::Resolve(const FString& UserID, const FString& Login, const FTWRawChatterTags& Raw)
+{
+  ++Lookups;
+
+  if (Capacity <= 0)
+    return MakeInfo(UserID, Login, Raw);
+
+  if (const int32* Found = Index.Find(UserID))
+  {
+    const int32 Slot = *Found;
+    FEntry& Entry = Entries[Slot];
+
+    if (Entry.Raw == Raw && Entry.Info->Login.Equals(Login, ESearchCase::CaseSensitive))
+    {
+      ++Hits;
+    }
+    else
+    {
+      // Records are immutable so messages already holding the old one keep a consistent snapshot
+      ++Updates;
+      Entry.Raw = Raw;
+      Entry.Info = MakeInfo(UserID, Login, Raw);
+    }
+
+    if (Head != Slot)
+    {
+      Unlink(Slot);
+      LinkFront(Slot);
+    }
+
+    return Entry.Info.ToSharedRef();
+  }
+
+  if (Index.Num() >= Capacity)
+    EvictOldest();
+
+  const int32 Slot = FreeSlots.Num() > 0 ? FreeSlots.Pop() : Entries.AddDefaulted();
+  FEntry& Entry = Entries[Slot];
+
+  Entry.Raw = Raw;
+  Entry.Info = MakeInfo(UserID, Login, Raw);
+  Index.Add(UserID, Slot);
+  LinkFront(Slot);
+
+  return Entry.Info.ToSharedRef();
+}
+
+TSharedPtr<const FTWChatterInfo> FTMIUserDirectory::Find(const FString& UserID) const
+{
+  const int32* Slot = Index.Find(UserID);
+  return Slot != nullptr ? Entries[*Slot].Info : nullptr;
+}
+
+void FTMIUserDirectory::Reset()
+{
+  Entries.Reset();
+  FreeSlots.Reset();
+  Index.Reset();
+  Head = INDEX_NONE;
+  Tail = INDEX_NONE;
+  Lookups = Hits = Updates = Evictions = 0;
+}
+
+FTWUserDirectoryStats FTMIUserDirectory::GetStats() const
+{
+  FTWUserDirectoryStats Stats;
+  Stats.Num = Index.Num();
+  Stats.Capacity = Capacity;
+  Stats.Lookups = Lookups;
+  Stats.Hits = Hits;
+  Stats.Updates = Updates;
+  Stats.Evictions = Evictions;
+  Stats.HitRate = Lookups > 0 ? static_cast<float>(static_cast<double>(Hits) / Lookups) : 0.0f;
+  return Stats;
+}
+
+void FTMIUserDirectory::Unlink(int32 Slot)
+{
+  FEntry& Entry = Entries[Slot];
+
+  if (Entry.Prev != INDEX_NONE)
+    Entries[Entry.Prev].Next = Entry.Next;
+  else
+    Head = Entry.Next;
+
+  if (Entry.Next != INDEX_NONE)
+    Entries[Entry.Next].Prev = Entry.Prev;
+  else
+    Tail = Entry.Prev;
+
+  Entry.Prev = Entry.Next = INDEX_NONE;
+}
+
+void FTMIUserDirectory::LinkFront(int32 Slot)
+{
+  FEntry& Entry = Entries[Slot];
+  Entry.Prev = INDEX_NONE;
+  Entry.Next = Head;
+
+  if (Head != INDEX_NONE)
+    Entries[Head].Prev = Slot;
+
+  Head = Slot;
+
+  if (Tail == INDEX_NONE)
+    Tail = Slot;
+}
+
+void FTMIUserDirectory::EvictOldest()
+{
+  if (Tail == INDEX_NONE)
+    return;
+
+  const int32 Slot = Tail;
+  Unlink(Slot);
+
+  FEntry& Entry = Entries[Slot];
+  Index.Remove(Entry.Info->UserID);
+  Entry.Info.Reset();
+  Entry.Raw = FTWRawChatterTags();
+  FreeSlots.Add(Slot);
+
+  ++Evictions;
+}
@@ -0,0 +1,83 @@
+#include "TMIWebSocketTransport.h"
+#include "TMIChatter.h"
+#include "WebSocketsModule.h"
+#include "IWebSocket.h"
+
+namespace
+{
+  const TCHAR* TwitchTMI_WebsocketURL = TEXT("wss://irc-ws.chat.twitch.tv:443/");
+}
+
+FTMIWebSocketTransport::FTMIWebSocketTransport()
+{
+  Socket = FTMIChatterModule::GetWebSockets().CreateWebSocket(TwitchTMI_WebsocketURL, TEXT("wss"));
+
+  // The socket never outlives us, so capturing this is safe
+  Socket->OnConnected().AddLambda([this]()
+  {
+    if (Events.Connected)
+      Events.Connected();
+  });
+
+  Socket->OnConnectionError().AddLambda([this](const FString& Error)
+  {
+    if (Events.Error)
+      Events.Error(Error);
+  });
+
+  Socket->OnClosed().AddLambda([this](int32 StatusCode, const FString& Reason, bool bWasClean)
+  {
+    if (Events.Closed)
+      Events.Closed(Reason);
+  });
+
+  Socket->OnMessage().AddLambda([this](const FString& Frame)
+  {
+    TArray<FString> Lines;
+    Frame.ParseIntoArray(Lines, TEXT("\r\n"));
+
+    // A handler may replace the events, or close us, halfway through the frame
+    for (FString& Line : Lines)
+    {
+      if (Events.Line)
+        Events.Line(MoveTemp(Line));
+    }
+  });
+}
+
+FTMIWebSocketTransport::~FTMIWebSocketTransport()
+{
+  Socket->OnConnected().Clear();
+  Socket->OnConnectionError().Clear();
+  Socket->OnClosed().Clear();
+  Socket->OnMessage().Clear();
+
+  if (Socket->IsConnected())
+    Socket->Close();
+}
+
+void FTMIWebSocketTransport::Connect()
+{
+  Socket->Connect();
+}
+
+void FTMIWebSocketTransport::Close()
+{
+  Socket->Close();
+}
+
+bool FTMIWebSocketTransport::IsConnected() const
+{
+  return Socket->IsConnected();
+}
+
+void FTMIWebSocketTransport::Send(const FString& Text)
+{
+  Socket->Send(Text);
+}
+
+void FTMIWebSocketTransport::Send(const uint8* Data, int32 Size)
+{
+  // Sent as a text frame, without another conversion
+  Socket->Send(Data, Size, false);
+}
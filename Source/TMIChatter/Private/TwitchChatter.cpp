@@ -1,9 +1,9 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "TwitchChatter.h"
-#include "WebSocketsModule.h"
-
-#include "Modules/ModuleManager.h"
+#include "TMIWebSocketTransport.h"
+#include "TMITcpTransport.h"
+#include "Async/Async.h"
 
 #ifdef TWITCH_CHATTER_DEV_COLLECTION
 #include "Misc/FileHelper.h"
@@ -13,164 +13,295 @@
 
 DEFINE_LOG_CATEGORY(LogTwitchChatter);
 
+// Fires the C++ event, and the Blueprint delegate unless it is compiled out or disabled at runtime
+#if TWITCH_CHATTER_BLUEPRINT_EVENTS
+#define TWITCH_BROADCAST(Event, Delegate, ...) \
+  do { \
+    Event.Broadcast(__VA_ARGS__); \
+    if (!bNativeEventsOnly) \
+      Delegate.Broadcast(__VA_ARGS__); \
+  } while (0)
+#else
+#define TWITCH_BROADCAST(Event, Delegate, ...) Event.Broadcast(__VA_ARGS__)
+#endif
+
 
 
 UTwitchChatter::UTwitchChatter()
 {
-  const FString& Protocol = TwitchTMI_WebsocketURL.Left(TwitchTMI_WebsocketURL.Find(":"));
+  // The socket and the client's hooks are only created by the first Connect, see EnsureSocket
+  Client.SetUserDirectory(&UserDirectory);
 
-  FWebSocketsModule* _WebSocketModule = &FModuleManager::LoadModuleChecked<FWebSocketsModule>(TEXT("WebSockets"));
+  // The client parses and dispatches, what's left is analytics and firing the events
+  FTMIClientEvents Events;
 
-  check(_WebSocketModule != nullptr);
+#ifdef TWITCH_CHATTER_DEV_COLLECTION
+  Events.Received = [](const TMIParser::MessageBundle& Bundle, const FString& Line)
+  {
+    if (!Bundle.RawCommand.IsNumeric())
+    {
+      const FString SaveFile = FString::Printf(TEXT("%s/DevCollection/%s.txt"), *FPaths::ProjectDir(), *Bundle.RawCommand);
+      FFileHelper::SaveStringToFile(Line + TEXT("\n"), *SaveFile, FFileHelper::EEncodingOptions::ForceUTF8, &IFileManager::Get(), EFileWrite::FILEWRITE_Append);
+    }
+  };
+#endif
 
-  Socket = _WebSocketModule->CreateWebSocket(
-    TwitchTMI_WebsocketURL,
-    Protocol
-  );
+  Events.Authenticated = [this](FGlobalUserStateMessage& Message)
+  {
+    EnsureTickerIfNeeded();
+    TWITCH_BROADCAST(EventAuthSuccess, OnAuthenticationSuccess, Message);
+  };
 
-  Socket->OnConnected().AddLambda([&]() -> void {
-    TWITCH_LOG(Log, TEXT("TWITCH: Socket Connected"));
+  Events.AuthFailed = [this]()
+  {
+    TWITCH_BROADCAST(EventAuthFailure, OnAuthenticationFailed);
+  };
 
-    ConnectedChannels.Empty();
+  Events.ReconnectRequested = [this]()
+  {
+    TWITCH_LOG(Log, TEXT("We've been asked to reconnect"));
+    BeginMigration();
+  };
 
-    EventSocketConnected.Broadcast();
-    OnSocketConnected.Broadcast();
+  Events.Joined = [this](const FString& Channel, double Latency)
+  {
+    DeliverJoin(Channel, Latency);
+  };
 
-    SendAuthInfo();
-  });
+  Events.Parted = [this](const FString& Channel)
+  {
+    DeliverPart(Channel);
+  };
 
-  SocketErrorDelegateHandle = Socket->OnConnectionError().AddLambda([&](const FString& Error) -> void {
-    TWITCH_LOG(Log, TEXT("TWITCH: Socket Connection Error: %s"), *Error);
+  Events.ChatMessage = [this](FPrivMsgMessage& Message)
+  {
+    DeliverChatMessage(Message);
+  };
 
-    if (EventSocketError.IsBound())
-      EventSocketError.Broadcast();
+  Events.ClearChat = [this](FClearChatMessage& Message)
+  {
+    DeliverClearChat(Message);
+  };
 
-    if (OnSocketError.IsBound())
-      OnSocketError.Broadcast();
+  Events.ClearMsg = [this](FClearMsgMessage& Message)
+  {
+    DeliverClearMsg(Message);
+  };
 
-    if (bReconnect)
-      Reconnect();
-  });
+  Events.Whisper = [this](FWhisperMessage& Message)
+  {
+    TWITCH_BROADCAST(EventWhispered, OnWhispered, Message);
+  };
 
-  SocketClosedDelegateHandle = Socket->OnClosed().AddLambda([&](int32 StatusCode, const FString &Reason, bool WasClean) -> void {
-    TWITCH_LOG(Log, TEXT("TWITCH: Socket Closed: %s"), *Reason);
+  Events.UserNotice = [this](FUserNoticeMessage& Message)
+  {
+    DeliverUserNotice(Message);
+  };
 
-    if (EventSocketClosed.IsBound())
-      EventSocketClosed.Broadcast();
+  Events.Notice = [this](FNoticeMessage& Message)
+  {
+    TWITCH_BROADCAST(EventNotice, OnNotice, Message);
+  };
 
-    if (OnSocketClosed.IsBound())
-      OnSocketClosed.Broadcast();
-  });
+  Events.RoomState = [this](FRoomStateMessage& Message)
+  {
+    BroadcastChannelState(Message.Channel, ChannelStates.ApplyRoomState(Message.Channel, Message.Tags));
+  };
 
-  MessageDelegateHandle = Socket->OnMessage().AddLambda([&](const FString &Message) -> void {
-    HandleMessage(Message);
-  });
+  Events.UserState = [this](FUserStateMessage& Message)
+  {
+    BroadcastChannelState(Message.Channel, ChannelStates.ApplyUserState(Message.Channel, Message.Tags));
+  };
 
-#ifdef TWITCH_CHATTER_DEV_TESTING
-  MsgSentDelegateHandle = Socket->OnMessageSent().AddLambda([&](const FString& Message) -> void {
-    EventSentMessage.Broadcast(Message);
-  });
-#endif
+  Client.SetEvents(MoveTemp(Events));
 }
 
 
 
 UTwitchChatter::~UTwitchChatter()
 {
-#ifdef TWITCH_CHATTER_DEV_TESTING
-  Socket->OnMessageSent().Remove(MsgSentDelegateHandle);
-#endif
+  if (TickerHandle.IsValid())
+    FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
 
-  Socket->OnClosed().Remove(SocketClosedDelegateHandle);
-  Socket->OnConnectionError().Remove(SocketErrorDelegateHandle);
-  Socket->OnMessage().Remove(MessageDelegateHandle);
-
-  Disconnect();
-  Socket.Reset();
-}
-
-
-
-void UTwitchChatter::ResetEventHandlers(bool ResetEvents, bool ResetDelegates)
-{
-  if (ResetEvents)
-  {
-    EventSocketConnected.Clear();
-    EventSocketError.Clear();
-    EventSocketClosed.Clear();
-    EventChatBits.Clear();
-    EventChatCommand.Clear();
-    EventChatCleared.Clear();
-    EventMsgCleared.Clear();
-    EventChatMessage.Clear();
-    EventJoinedChannel.Clear();
-    EventPartedChannel.Clear();
-    EventAuthFailure.Clear();
-    EventAuthSuccess.Clear();
-    EventWhispered.Clear();
-    EventUserNotice.Clear();
-    EventUserSubscribed.Clear();
-    EventUserResubscribed.Clear();
-    EventRaided.Clear();
-    EventRitual.Clear();
-    EventNewBitsBadge.Clear();
-    EventSubsGifted.Clear();
-    EventSubPaidForward.Clear();
-    EventNotice.Clear();
-  }
-
-  if (ResetDelegates)
-  {
-    OnChatBits.Clear();
-    OnChatSubscriber.Clear();
-    OnChatReSubscriber.Clear();
-    OnSubsGifted.Clear();
-    OnSubsPaidForward.Clear();
-    OnNewBitsBadge.Clear();
-    OnRaided.Clear();
-    OnRitual.Clear();
-    OnChatMessage.Clear();
-    OnWhispered.Clear();
-    OnChatCommand.Clear();
-    OnNotice.Clear();
-    OnUserNotice.Clear();
-    OnJoinedChannel.Clear();
-    OnPartedChannel.Clear();
-    OnAuthenticationSuccess.Clear();
-    OnAuthenticationFailed.Clear();
-    OnClearChat.Clear();
-    OnClearMsg.Clear();
-    OnSocketConnected.Clear();
-    OnSocketError.Clear();
-    OnSocketClosed.Clear();
+  if (Socket.IsValid())
+  {
+    Socket->SetEvents(FTMITransportEvents());
+    Disconnect();
+    Socket.Reset();
   }
 }
 
 
 
-void UTwitchChatter::Connect(const FString& TryUsername, const FString& TryPassword, const TArray<FString>& MyAutoJoinChannels, bool AutoReconnect, bool EnableFastMode)
+TSharedPtr<ITMITransport> UTwitchChatter::CreateSocket() const
 {
-  if (Socket->IsConnected())
-    return;
+  if (TransportFactory)
+    return TransportFactory();
 
-  bFastMode = EnableFastMode;
-
-  if (Socket.IsValid())
+  switch (Transport)
   {
-    BotUsername = TryUsername.ToLower();
-    BotPassword = TryPassword;
-    bReconnect = AutoReconnect;
+  case ETWTransport::Tcp:
+    return MakeShared<FTMITcpTransport>();
+
+  default:
+    return MakeShared<FTMIWebSocketTransport>();
+  }
+}
+
 
-    AutoJoinChannels.Empty();
-    AutoJoinChannels.Append(MyAutoJoinChannels);
 
-    Socket->Connect();
+bool UTwitchChatter::EnsureSocket()
+{
+  // Class default objects never connect, they shouldn't hold a socket either
+  if (!Socket.IsValid() && !HasAnyFlags(RF_ClassDefaultObject))
+  {
+    Socket = CreateSocket();
+    BindSocket();
   }
-  else
+
+  return Socket.IsValid();
+}
+
+
+
+void UTwitchChatter::BindSocket()
+{
+  // The hooks hold on to this connection instead of reading Socket, PONGs are sent from the receiving thread
+  // Rebinding is safe once the previous connections' events are cleared, that waits out their receive threads
+  const TSharedPtr<ITMITransport> Transport = Socket;
+  FTMIClientHooks Hooks;
+
+  Hooks.SendText = [this, Transport](const FString& Text)
+  {
+    if (Transport.IsValid())
+      Transport->Send(Text);
+
+#ifdef TWITCH_CHATTER_DEV_TESTING
+    if (EventSentMessage.IsBound())
+      BroadcastSentFrame(Text);
+#endif
+  };
+
+  Hooks.SendUtf8 = [this, Transport](const uint8* Data, int32 Size)
+  {
+    // Already UTF-8, handed over without another conversion
+    if (Transport.IsValid())
+      Transport->Send(Data, Size);
+
+#ifdef TWITCH_CHATTER_DEV_TESTING
+    // PONGs may be sent from the receiving thread
+    if (EventSentMessage.IsBound() && IsInGameThread())
+    {
+      const FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(Data), Size);
+      BroadcastSentFrame(FString(Converted.Length(), Converted.Get()));
+    }
+#endif
+  };
+
+  Hooks.Connect = [Transport]()
+  {
+    if (Transport.IsValid())
+      Transport->Connect();
+  };
+
+  Hooks.Close = [this, Transport]()
+  {
+    if (!Transport.IsValid())
+      return;
+
+    // Tells the closed handler this isn't a lost connection
+    bExpectClose = Transport->IsConnected();
+    Transport->Close();
+  };
+
+  Hooks.ChannelsChanged = [this](const TArray<FString>& Channels)
+  {
+    ConnectedChannels = Channels;
+  };
+
+  Client.SetHooks(MoveTemp(Hooks));
+
+  FTMITransportEvents Events;
+
+  Events.Connected = [this]()
+  {
+    TWITCH_LOG(Log, TEXT("TWITCH: Socket Connected"));
+
+    ChannelStates.Reset();
+
+    // Logs in, the channels we were in before are joined again and the health probes start once we're authenticated
+    Client.SetHealthThresholds(HealthProbeInterval, HealthProbeTimeout, StaleConnectionSeconds);
+    Client.OnConnected(FPlatformTime::Seconds());
+    EnsureTickerIfNeeded();
+
+    if (NeedsDraining())
+      EnsureTicker();
+
+    TWITCH_BROADCAST(EventSocketConnected, OnSocketConnected);
+  };
+
+  Events.Error = [this](const FString& Error)
+  {
+    TWITCH_LOG(Log, TEXT("TWITCH: Socket Connection Error: %s"), *Error);
+
+    TWITCH_BROADCAST(EventSocketError, OnSocketError);
+
+    ScheduleReconnect();
+  };
+
+  Events.Closed = [this](const FString& Reason)
+  {
+    TWITCH_LOG(Log, TEXT("TWITCH: Socket Closed: %s"), *Reason);
+
+    TWITCH_BROADCAST(EventSocketClosed, OnSocketClosed);
+
+    // Closes we asked for are followed by our own Connect, if any
+    if (bExpectClose)
+      bExpectClose = false;
+    else if (PendingSocket.IsValid())
+    {
+      // Twitch retired the old connection first, the new one takes over as soon as it's logged in
+      if (bPendingAuthenticated)
+        FinishMigration();
+    }
+    else
+      ScheduleReconnect();
+  };
+
+  // Transports with a receive thread of their own only feed the ingress there, the ticker drains it
+  Events.Line = [this](FString&& Line)
+  {
+    Client.ReceiveLine(MoveTemp(Line));
+
+    if (IsInGameThread())
+      DrainIngress();
+  };
+
+  Socket->SetEvents(MoveTemp(Events));
+}
+
+
+
+bool UTwitchChatter::NeedsDraining() const
+{
+  return Socket.IsValid() && !Socket->ReceivesOnGameThread() && Socket->IsConnected();
+}
+
+
+
+void UTwitchChatter::Connect(const FString& TryUsername, const FString& TryPassword, const TArray<FString>& MyAutoJoinChannels, bool AutoReconnect, bool EnableFastMode)
+{
+  if (!EnsureSocket())
   {
-    EventSocketError.Broadcast();
-    OnSocketError.Broadcast();
+    TWITCH_BROADCAST(EventSocketError, OnSocketError);
+    return;
   }
+
+  if (Socket->IsConnected())
+    return;
+
+  Client.Start(TryUsername, TryPassword, MyAutoJoinChannels, AutoReconnect, EnableFastMode);
+  RebuildIgnoredSources();
 }
 
 
@@ -180,292 +311,866 @@ void UTwitchChatter::Reconnect()
   if (!Socket.IsValid())
     return;
 
-  if (Socket->IsConnected())
-    Disconnect();
-
-  Socket->Connect();
+  Client.Reconnect(FPlatformTime::Seconds());
 }
 
 
 
-void UTwitchChatter::Disconnect()
+void UTwitchChatter::BeginMigration()
 {
-  if (Socket != nullptr)
+  if (PendingSocket.IsValid())
+    return;
+
+  // Without a working connection to keep there is nothing to migrate
+  if (!Socket.IsValid() || !Socket->IsConnected() || !Client.IsAuthenticated())
+  {
+    Reconnect();
+    return;
+  }
+
+  TWITCH_LOG(Log, TEXT("TWITCH: Opening a new connection before leaving the old one"));
+
+  PendingSocket = CreateSocket();
+  bPendingAuthenticated = false;
+  MigrationJoins.Reset();
+  MigrationJoins.ShareBucket(Client.GetJoinBucket());
+  MigrationDeadline = FPlatformTime::Seconds() + MigrationTimeout;
+
+  FTMITransportEvents Events;
+
+  Events.Connected = [this]()
+  {
+    TArray<FString> Login;
+    Client.GetLoginLines(Login);
+    PendingSocket->Send(FString::Join(Login, TEXT("\r\n")) + TEXT("\r\n"));
+  };
+
+  Events.Error = [this](const FString& Error)
+  {
+    TWITCH_LOG(Log, TEXT("TWITCH: New connection failed: %s"), *Error);
+    AbortMigration();
+  };
+
+  Events.Closed = [this](const FString& Reason)
+  {
+    TWITCH_LOG(Log, TEXT("TWITCH: New connection closed: %s"), *Reason);
+    AbortMigration();
+  };
+
+  // The migration isn't thread safe, lines received on another thread are handed over to the game thread in order
+  Events.Line = [this](FString&& Line)
   {
-    for (const FString &Channel : ConnectedChannels)
+    if (IsInGameThread())
     {
-      SendRaw("PART #" + Channel);
+      HandleMigrationMessage(Line);
+      return;
     }
 
-    SendRaw("QUIT :Goodbye");
+    AsyncTask(ENamedThreads::GameThread, [WeakThis = TWeakObjectPtr<UTwitchChatter>(this), Line = MoveTemp(Line)]()
+    {
+      if (UTwitchChatter* Chatter = WeakThis.Get())
+        Chatter->HandleMigrationMessage(Line);
+    });
+  };
 
-    Socket->Close();
-  }
+  PendingSocket->SetEvents(MoveTemp(Events));
 
-  BotUsername = TEXT("");
-  BotPassword = TEXT("");
+  PendingSocket->Connect();
+  EnsureTicker();
 }
 
 
 
-void UTwitchChatter::SendAuthInfo() const
+void UTwitchChatter::HandleMigrationMessage(const FString& Line)
 {
-  if (Socket.IsValid())
-  {
-    if (!bFastMode)
-      SendRaw("CAP REQ :twitch.tv/tags");
+  const double Now = FPlatformTime::Seconds();
+  TMIParser::MessageBundle Bundle = TMIParser::SplitRawMessage(Line);
 
-    SendRaw("CAP REQ :twitch.tv/commands");
-    SendRaw("PASS oauth:" + BotPassword);
-    SendRaw("NICK " + BotUsername);
+  // Lines queued for the game thread may arrive after the switch-over, they're regular traffic by then
+  if (!PendingSocket.IsValid())
+  {
+    Client.Dispatch(Bundle, Line, Now);
+    return;
   }
-}
 
+  switch (Bundle.Command)
+  {
+  case EIRCCommand::PING:
+    PendingSocket->Send(TEXT("PONG :") + Bundle.Params + TEXT("\r\n"));
+    break;
 
+  case EIRCCommand::GLOBALUSERSTATE:
+    // From here on both connections deliver the same messages
+    bPendingAuthenticated = true;
+    Client.SetDeduplicating(true);
 
-void UTwitchChatter::JoinChannel(const FString& Channel)
-{
-  FString Chan = Channel.ToLower();
+    for (const FString& Channel : Client.GetChannels())
+      MigrationJoins.Request(Channel, Now);
+
+    if (MigrationJoins.HasPending())
+      PumpMigration(Now);
+    else
+      FinishMigration();
 
-  if (Socket.IsValid() && Socket->IsConnected() && !Chan.IsEmpty() && !ConnectedChannels.Contains(Chan))
+    break;
+
+  case EIRCCommand::JOIN:
   {
-    SendRaw("JOIN #" + Chan);
-    ConnectedChannels.Add(Chan);
+    MigrationJoins.OnJoined(Bundle.Target, Now);
+
+    const FTWJoinProgress Progress = MigrationJoins.GetProgress();
+
+    if (!MigrationJoins.HasPending() && Progress.Joined >= Progress.Requested)
+      FinishMigration();
+
+    break;
+  }
+
+  case EIRCCommand::RECONNECT:
+    break;
+
+  case EIRCCommand::NOTICE:
+    // Most likely a failed login, the old connection keeps going until we reconnect the usual way
+    if (!bPendingAuthenticated)
+    {
+      AbortMigration();
+      break;
+    }
+
+    [[fallthrough]];
+
+  default:
+    if (bPendingAuthenticated)
+      Client.Dispatch(Bundle, Line, Now);
   }
 }
 
 
 
-void UTwitchChatter::JoinChannels(const TArray<FString>& Channels)
+void UTwitchChatter::PumpMigration(double Now)
 {
-  for (const FString &Channel : Channels)
+  MigrationJoins.Pump(Now, [this](const FString& Line)
   {
-    JoinChannel(Channel);
-  }
+    PendingSocket->Send(Line + TEXT("\r\n"));
+  });
 }
 
 
 
-void UTwitchChatter::PartChannel(const FString& Channel)
+void UTwitchChatter::FinishMigration()
+{
+  TWITCH_LOG(Log, TEXT("TWITCH: Switched over to the new connection"));
+
+  Socket->SetEvents(FTMITransportEvents());
+  PendingSocket->SetEvents(FTMITransportEvents());
+
+  if (Socket->IsConnected())
+    Socket->Send(TEXT("QUIT :Goodbye\r\n"));
+
+  // Closing doesn't wait on any transport, one still connecting just gives up
+  Socket->Close();
+
+  // Sockets can't go away from inside their own callbacks, the ticker drops them
+  RetiredSockets.Add(Socket);
+  Socket = MoveTemp(PendingSocket);
+  PendingSocket.Reset();
+  BindSocket();
+
+  // Channels the new connection didn't get to yet are joined the regular way, neither they nor the JOINs still
+  // waiting for confirmation report a channel we never left
+  TArray<FString> Unsent;
+  TArray<FString> Unconfirmed;
+  MigrationJoins.TakePending(Unsent);
+  MigrationJoins.GetUnconfirmed(Unconfirmed);
+
+  const double Now = FPlatformTime::Seconds();
+  Client.RequeueJoins(Unsent, Unconfirmed, Now);
+
+  MigrationJoins.Reset();
+  Client.SetDeduplicating(false);
+  bPendingAuthenticated = false;
+
+  // Probes in flight went out on the old connection
+  Client.StartHealthMonitor(Now);
+  Client.Pump(Now);
+  EnsureTicker();
+}
+
+
+
+void UTwitchChatter::AbortMigration()
+{
+  if (!PendingSocket.IsValid())
+    return;
+
+  PendingSocket->SetEvents(FTMITransportEvents());
+
+  PendingSocket->Close();
+
+  RetiredSockets.Add(PendingSocket);
+  PendingSocket.Reset();
+  MigrationJoins.Reset();
+  Client.SetDeduplicating(false);
+  bPendingAuthenticated = false;
+  EnsureTicker();
+
+  // Twitch still wants us gone, fall back to reconnecting in place
+  if (Client.IsStarted())
+    Reconnect();
+}
+
+
+
+FTWConnectionHealth UTwitchChatter::GetConnectionHealth() const
+{
+  return Client.GetHealth(FPlatformTime::Seconds());
+}
+
+
+
+void UTwitchChatter::ScheduleReconnect()
 {
-  FString Chan = Channel.ToLower();
+  Client.SetReconnectDelays(ReconnectTime, MaxReconnectTime);
+
+  const double Delay = Client.OnConnectionLost(FPlatformTime::Seconds());
 
-  if (Socket.IsValid() && !Chan.IsEmpty() && ConnectedChannels.Contains(Chan))
+  if (Delay >= 0.0)
   {
-    SendRaw("PART #" + Chan);
+    TWITCH_LOG(Log, TEXT("TWITCH: Reconnecting in %.1f seconds"), Delay);
+    EnsureTicker();
   }
 }
 
 
 
-void UTwitchChatter::SendRaw(const FString& Message) const
+FTWReconnectStats UTwitchChatter::GetReconnectStats() const
 {
-  Socket->Send(Message);
-  Socket->Send("\r\n");
+  return Client.GetReconnectStats(FPlatformTime::Seconds());
 }
 
 
 
-void UTwitchChatter::Send(const FString& Channel, const FString& Message) const
+void UTwitchChatter::Disconnect()
 {
-  if (!Channel.IsEmpty() && !Message.IsEmpty())
-    SendRaw("PRIVMSG #" + Channel.ToLower() + " :" + Message);
+  if (Socket.IsValid())
+    Client.Stop();
+
+  AbortMigration();
+  RebuildIgnoredSources();
 }
 
 
 
-void UTwitchChatter::Broadcast(const FString& Message) const
+void UTwitchChatter::IgnoreLogin(const FString& Login)
 {
-  if (Message.IsEmpty())
-    return;
-
-  for (const FString&Channel : ConnectedChannels)
+  if (!Login.IsEmpty())
   {
-    Send(Channel, Message);
+    IgnoredLogins.Add(Login.ToLower());
+    RebuildIgnoredSources();
   }
 }
 
 
 
-void UTwitchChatter::HandleMessage(const FString &TMIString)
+void UTwitchChatter::UnignoreLogin(const FString& Login)
+{
+  if (IgnoredLogins.Remove(Login.ToLower()) > 0)
+    RebuildIgnoredSources();
+}
+
+
+
+void UTwitchChatter::RebuildIgnoredSources()
+{
+  Client.SetIgnoredLogins(IgnoredLogins);
+}
+
+
+
+void UTwitchChatter::JoinChannel(const FString& Channel)
+{
+  if (Socket.IsValid() && Client.JoinChannel(Channel, FPlatformTime::Seconds()))
+    EnsureTickerIfNeeded();
+}
+
+
+
+void UTwitchChatter::JoinChannels(const TArray<FString>& Channels)
 {
-  if (TMIString.IsEmpty())
+  if (!Socket.IsValid())
     return;
 
-  TArray<FString> Lines;
+  Client.JoinChannels(Channels, FPlatformTime::Seconds());
+  EnsureTickerIfNeeded();
+}
 
-  TMIString.ParseIntoArray(Lines, TEXT("\r\n"));
 
-  for (const FString &Line : Lines)
-  {
-    TMIParser::MessageBundle Bundle = TMIParser::SplitRawMessage(Line);
 
-#ifdef TWITCH_CHATTER_DEV_COLLECTION
-    if (!Bundle.RawCommand.IsNumeric())
-    {
-      const FString SaveFile = FString::Printf(TEXT("%s/DevCollection/%s.txt"), *FPaths::ProjectDir(), *Bundle.RawCommand);
-      FFileHelper::SaveStringToFile(Line + TEXT("\n"), *SaveFile, FFileHelper::EEncodingOptions::ForceUTF8, &IFileManager::Get(), EFileWrite::FILEWRITE_Append);
-    }
-#endif
+FTWJoinProgress UTwitchChatter::GetJoinProgress() const
+{
+  return Client.GetJoinProgress();
+}
 
-    switch (Bundle.Command)
-    {
-    case EIRCCommand::PRIVMSG:
-    {
-      if (Bundle.Source.Contains(BotUsername))
-        break;
 
-      FPrivMsgMessage Message = TMIParser::ParseMessage<FPrivMsgMessage>(Bundle);
 
-      EventChatMessage.Broadcast(Message);
-      OnChatMessage.Broadcast(Message);
+void UTwitchChatter::PartChannel(const FString& Channel)
+{
+  if (Socket.IsValid())
+    Client.PartChannel(Channel);
+}
 
-      if (Message.Tags.Bits > 0)
-      {
-        EventChatBits.Broadcast(Message);
-        OnChatBits.Broadcast(Message);
-      }
 
-      if (Message.Message.StartsWith(CommandPrefix))
-      {
-        FString Command, Params;
-        int32 Endex;
 
-        if (!Message.Message.FindChar(TCHAR(' '), Endex))
-          Endex = Message.Message.Len();
+bool UTwitchChatter::Send(const FString& Channel, const FString& Message)
+{
+  const bool bWhole = Client.Send(Channel, Message, FPlatformTime::Seconds());
+  EnsureTickerIfNeeded();
 
-        Command = Message.Message.Mid(1, Endex-1);
+  if (!bWhole)
+    TWITCH_LOG(Warning, TEXT("Message to #%s is %d characters, only the first %d parts were sent"), *Channel, Message.Len(), FTMIOutboundQueue::MaxMessageParts);
 
-        if (Endex < Message.Message.Len())
-          Params = Message.Message.Mid(Endex);
+  return bWhole;
+}
 
-        EventChatCommand.Broadcast(Message, Command, Params);
-        OnChatCommand.Broadcast(Message, Command, Params);
-      }
-      break;
-    }
 
-    case EIRCCommand::CLEARCHAT:
-    {
-      FClearChatMessage Message = TMIParser::ParseMessage<FClearChatMessage>(Bundle);
-      OnClearChat.Broadcast(Message);
-      EventChatCleared.Broadcast(Message);
-      break;
-    }
 
-    case EIRCCommand::CLEARMSG:
-    {
-      FClearMsgMessage Message = TMIParser::ParseMessage<FClearMsgMessage>(Bundle);
-      OnClearMsg.Broadcast(Message);
-      EventMsgCleared.Broadcast(Message);
-      break;
-    }
+bool UTwitchChatter::Broadcast(const FString& Message)
+{
+  const bool bWhole = Client.Broadcast(Message, FPlatformTime::Seconds());
+  EnsureTickerIfNeeded();
 
-    case EIRCCommand::WHISPER:
-    {
-      FWhisperMessage Message = TMIParser::ParseMessage<FWhisperMessage>(Bundle);
-      EventWhispered.Broadcast(Message);
-      OnWhispered.Broadcast(Message);
-      break;
-    }
+  if (!bWhole)
+    TWITCH_LOG(Warning, TEXT("Broadcast message is %d characters, only the first %d parts were sent"), Message.Len(), FTMIOutboundQueue::MaxMessageParts);
 
-    case EIRCCommand::USERNOTICE:
-    {
-      FUserNoticeMessage Message = TMIParser::ParseMessage<FUserNoticeMessage>(Bundle);
-      OnUserNotice.Broadcast(Message);
-      EventUserNotice.Broadcast(Message);
-
-      switch (Message.Tags.MsgID)
-      {
-      case ETWUserNoticeMsgId::Resubscription:
-        EventUserResubscribed.Broadcast(Message, FSubscriptionNoticeTags(Message.Tags.MessageParams));
-        OnChatReSubscriber.Broadcast(Message, FSubscriptionNoticeTags(Message.Tags.MessageParams));
-        break;
-
-      case ETWUserNoticeMsgId::Subscription:
-        EventUserSubscribed.Broadcast(Message, FSubscriptionNoticeTags(Message.Tags.MessageParams));
-        OnChatSubscriber.Broadcast(Message, FSubscriptionNoticeTags(Message.Tags.MessageParams));
-        break;
-
-      case ETWUserNoticeMsgId::SubscriptionGift:
-        EventSubsGifted.Broadcast(Message, FSubgiftNoticeTags(Message.Tags.MessageParams));
-        OnSubsGifted.Broadcast(Message, FSubgiftNoticeTags(Message.Tags.MessageParams));
-        break;
-
-      case ETWUserNoticeMsgId::BitsBadgeTier:
-        EventNewBitsBadge.Broadcast(Message, FBitsBadgeTierNoticeTags(Message.Tags.MessageParams));
-        OnNewBitsBadge.Broadcast(Message, FBitsBadgeTierNoticeTags(Message.Tags.MessageParams));
-        break;
-
-      case ETWUserNoticeMsgId::Raid:
-        EventRaided.Broadcast(Message, FRaidNoticeTags(Message.Tags.MessageParams));
-        OnRaided.Broadcast(Message, FRaidNoticeTags(Message.Tags.MessageParams));
-        break;
-
-      case ETWUserNoticeMsgId::Ritual:
-        EventRitual.Broadcast(Message, FRitualNoticeTags(Message.Tags.MessageParams));
-        OnRitual.Broadcast(Message, FRitualNoticeTags(Message.Tags.MessageParams));
-        break;
-
-      case ETWUserNoticeMsgId::CommunityPayForward:
-      case ETWUserNoticeMsgId::StandardPayForward:
-        EventSubPaidForward.Broadcast(Message, FSubPaidForwardNoticeTags(Message.Tags.MessageParams));
-        OnSubsPaidForward.Broadcast(Message, FSubPaidForwardNoticeTags(Message.Tags.MessageParams));
-        break;
-      }
-      break;
-    }
+  return bWhole;
+}
 
-    case EIRCCommand::NOTICE:
-    {
-      FNoticeMessage Message = TMIParser::ParseMessage<FNoticeMessage>(Bundle);
-
-      if (!bAuthenticated)
-      {
-        if (!Message.Channel.Compare("*"))
-        {
-          EventAuthFailure.Broadcast();
-          OnAuthenticationFailed.Broadcast();
-        }
-      }
-      else
-      {
-        EventNotice.Broadcast(Message);
-        OnNotice.Broadcast(Message);
-      }
-      break;
-    }
 
-    case EIRCCommand::PING:
-      Socket->Send(TEXT("PONG :") + Bundle.Params);
-      break;
 
-    case EIRCCommand::RECONNECT:
-      TWITCH_LOG(Log, TEXT("We've been asked to reconnect"));
-      Reconnect();
-      break;
+bool UTwitchChatter::BroadcastTo(const TArray<FString>& ToChannels, const FString& Message)
+{
+  const bool bWhole = Client.BroadcastTo(ToChannels, Message, FPlatformTime::Seconds());
+  EnsureTickerIfNeeded();
 
-    case EIRCCommand::JOIN:
-      EventJoinedChannel.Broadcast(Bundle.Target);
-      OnJoinedChannel.Broadcast(Bundle.Target);
-      break;
+  if (!bWhole)
+    TWITCH_LOG(Warning, TEXT("Broadcast message is %d characters, only the first %d parts were sent"), Message.Len(), FTMIOutboundQueue::MaxMessageParts);
 
-    case EIRCCommand::PART:
-      EventPartedChannel.Broadcast(Bundle.Target);
-      OnPartedChannel.Broadcast(Bundle.Target);
-      break;
+  return bWhole;
+}
 
-    case EIRCCommand::GLOBALUSERSTATE:
-    {
-      FGlobalUserStateMessage Message = TMIParser::ParseMessage<FGlobalUserStateMessage>(Bundle);
 
-      bAuthenticated = true;
-      EventAuthSuccess.Broadcast(Message);
-      OnAuthenticationSuccess.Broadcast(Message);
-      JoinChannels(AutoJoinChannels);
-      break;
-    }
-    }
+
+void UTwitchChatter::BroadcastSentFrame(const FString& Frame)
+{
+  // A frame can carry several CRLF terminated lines, report them one by one
+  TArray<FString> Lines;
+  Frame.ParseIntoArray(Lines, TEXT("\r\n"));
+
+  for (const FString& Line : Lines)
+    EventSentMessage.Broadcast(Line);
+}
+
+
+
+FTWOutboundStats UTwitchChatter::GetOutboundStats() const
+{
+  return Client.GetOutboundStats(FPlatformTime::Seconds());
+}
+
+
+
+void UTwitchChatter::DrainIngress()
+{
+  Client.Drain(FPlatformTime::Seconds());
+}
+
+
+
+void UTwitchChatter::DeliverChatMessage(FPrivMsgMessage& Message)
+{
+  const double Now = FPlatformTime::Seconds();
+
+  if (bTokenizeMessages)
+    TMIParser::TokenizeMessage(Message.Message, Message.Tags.Emotes, Message.Tags.Bits > 0, Message.Runs);
+
+  if (bDetectDuplicates)
+    DuplicateDetector.Observe(Message.Channel, Message.Message, Now, Message.DuplicateClusterID, Message.DuplicateCount);
+
+  MessageHistory.Add(Message);
+
+  ChatMetrics.Record(Message.Channel, ETWChatMetric::Messages, 1, Now);
+  UniqueChatters.Add(Message.Channel, Message.Tags.UserID, Now);
+  Trends.Add(Message);
+
+  if (Message.Tags.Bits > 0)
+    ChatMetrics.Record(Message.Channel, ETWChatMetric::Bits, Message.Tags.Bits, Now);
+
+  // Repeats are counted above but only dispatched in bulk
+  if (bCollapseDuplicates && Message.DuplicateCount > 1 && Message.Tags.Bits == 0 && !Message.Message.StartsWith(CommandPrefix))
+  {
+    FCollapsedDuplicates& Collapsed = CollapsedDuplicates.FindOrAdd(Message.DuplicateClusterID);
+    Collapsed.Latest = MoveTemp(Message);
+    Collapsed.Collapsed += 1;
+
+    EnsureTicker();
+    return;
+  }
+
+  TWITCH_BROADCAST(EventChatMessage, OnChatMessage, Message);
+
+  TArray<FTWKeywordMatch> KeywordMatches;
+
+  if (KeywordMatcher.Scan(Message.Message, KeywordMatches))
+  {
+    TWITCH_BROADCAST(EventKeywordsMatched, OnKeywordsMatched, Message, KeywordMatches);
+  }
+
+  if (Message.Tags.Bits > 0)
+  {
+    TWITCH_BROADCAST(EventChatBits, OnChatBits, Message);
+  }
+
+  if (Message.Message.StartsWith(CommandPrefix))
+  {
+    FString Command, Params;
+    int32 Endex;
+
+    if (!Message.Message.FindChar(TCHAR(' '), Endex))
+      Endex = Message.Message.Len();
+
+    Command = Message.Message.Mid(1, Endex-1);
+
+    if (Endex < Message.Message.Len())
+      Params = Message.Message.Mid(Endex);
+
+    if (Polls.HandleCommand(Message, Command, Params))
+      return;
+
+    TWITCH_BROADCAST(EventChatCommand, OnChatCommand, Message, Command, Params);
+  }
+}
+
+
+
+void UTwitchChatter::DeliverClearChat(FClearChatMessage& Message)
+{
+  TWITCH_BROADCAST(EventChatCleared, OnClearChat, Message);
+
+  TArray<FGuid> RemovedIDs;
+
+  if (!Message.Tags.TargetUserID.IsEmpty())
+  {
+    if (MessageHistory.RemoveUser(Message.Channel, Message.Tags.TargetUserID, RemovedIDs))
+      TWITCH_BROADCAST(EventHistoryChanged, OnHistoryChanged, Message.Channel, ETWHistoryChange::UserPurged, RemovedIDs);
+  }
+  else if (MessageHistory.ClearChannel(Message.Channel, RemovedIDs))
+  {
+    TWITCH_BROADCAST(EventHistoryChanged, OnHistoryChanged, Message.Channel, ETWHistoryChange::Cleared, RemovedIDs);
+  }
+}
+
+
+
+void UTwitchChatter::DeliverClearMsg(FClearMsgMessage& Message)
+{
+  TWITCH_BROADCAST(EventMsgCleared, OnClearMsg, Message);
+
+  FGuid TargetID;
+  TArray<FGuid> RemovedIDs;
+
+  if (FGuid::ParseExact(Message.Tags.TargetMsgID, EGuidFormats::DigitsWithHyphens, TargetID)
+    && MessageHistory.RemoveMessage(Message.Channel, TargetID, RemovedIDs))
+  {
+    TWITCH_BROADCAST(EventHistoryChanged, OnHistoryChanged, Message.Channel, ETWHistoryChange::MessageDeleted, RemovedIDs);
+  }
+}
+
+
+
+void UTwitchChatter::DeliverUserNotice(FUserNoticeMessage& Message)
+{
+  TWITCH_BROADCAST(EventUserNotice, OnUserNotice, Message);
+
+  switch (Message.Tags.MsgID)
+  {
+  case ETWUserNoticeMsgId::Resubscription:
+  {
+    const FSubscriptionNoticeTags Tags(Message.Tags.MessageParams);
+    ChatMetrics.Record(Message.Channel, ETWChatMetric::Subscriptions, 1, FPlatformTime::Seconds());
+    TWITCH_BROADCAST(EventUserResubscribed, OnChatReSubscriber, Message, Tags);
+    break;
+  }
+
+  case ETWUserNoticeMsgId::Subscription:
+  {
+    const FSubscriptionNoticeTags Tags(Message.Tags.MessageParams);
+    ChatMetrics.Record(Message.Channel, ETWChatMetric::Subscriptions, 1, FPlatformTime::Seconds());
+    TWITCH_BROADCAST(EventUserSubscribed, OnChatSubscriber, Message, Tags);
+    break;
+  }
+
+  case ETWUserNoticeMsgId::SubscriptionGift:
+  {
+    const FSubgiftNoticeTags Tags(Message.Tags.MessageParams);
+    ChatMetrics.Record(Message.Channel, ETWChatMetric::Subscriptions, 1, FPlatformTime::Seconds());
+    TWITCH_BROADCAST(EventSubsGifted, OnSubsGifted, Message, Tags);
+    break;
+  }
+
+  case ETWUserNoticeMsgId::BitsBadgeTier:
+  {
+    const FBitsBadgeTierNoticeTags Tags(Message.Tags.MessageParams);
+    TWITCH_BROADCAST(EventNewBitsBadge, OnNewBitsBadge, Message, Tags);
+    break;
+  }
+
+  case ETWUserNoticeMsgId::Raid:
+  {
+    const FRaidNoticeTags Tags(Message.Tags.MessageParams);
+    TWITCH_BROADCAST(EventRaided, OnRaided, Message, Tags);
+    break;
+  }
+
+  case ETWUserNoticeMsgId::Ritual:
+  {
+    const FRitualNoticeTags Tags(Message.Tags.MessageParams);
+    TWITCH_BROADCAST(EventRitual, OnRitual, Message, Tags);
+    break;
+  }
+
+  case ETWUserNoticeMsgId::CommunityPayForward:
+  case ETWUserNoticeMsgId::StandardPayForward:
+  {
+    const FSubPaidForwardNoticeTags Tags(Message.Tags.MessageParams);
+    TWITCH_BROADCAST(EventSubPaidForward, OnSubsPaidForward, Message, Tags);
+    break;
+  }
+  }
+}
+
+
+
+void UTwitchChatter::DeliverJoin(const FString& Channel, double Latency)
+{
+  TWITCH_BROADCAST(EventJoinedChannel, OnJoinedChannel, Channel);
+
+  if (Latency >= 0.0)
+  {
+    const FTWJoinProgress Progress = Client.GetJoinProgress();
+    TWITCH_BROADCAST(EventJoinProgress, OnJoinProgress, Channel, static_cast<float>(Latency), Progress);
+  }
+}
+
+
+
+void UTwitchChatter::DeliverPart(const FString& Channel)
+{
+  ChannelStates.Remove(Channel);
+  ChatMetrics.Remove(Channel);
+  UniqueChatters.Remove(Channel);
+  Trends.Remove(Channel);
+  DuplicateDetector.Remove(Channel);
+  TWITCH_BROADCAST(EventPartedChannel, OnPartedChannel, Channel);
+}
+
+
+
+void UTwitchChatter::BroadcastChannelState(const FString& Channel, ETWChannelStateField ChangedFields)
+{
+  const FTWChannelState* State = ChannelStates.Find(Channel);
+
+  if (State == nullptr)
+    return;
+
+  Client.SetChannelLimits(Channel, State->bIsModerator || State->bIsBroadcaster, State->IsPrivileged() ? 0 : State->SlowModeSeconds);
+
+  if (ChangedFields == ETWChannelStateField::None)
+    return;
+
+  EventChannelStateChanged.Broadcast(*State, ChangedFields);
+
+#if TWITCH_CHATTER_BLUEPRINT_EVENTS
+  if (!bNativeEventsOnly)
+    OnChannelStateChanged.Broadcast(*State, static_cast<int32>(ChangedFields));
+#endif
+}
+
+
+
+bool UTwitchChatter::GetChannelState(const FString& Channel, FTWChannelState& OutState) const
+{
+  const FTWChannelState* State = ChannelStates.Find(Channel.ToLower());
+
+  if (State == nullptr)
+    return false;
+
+  OutState = *State;
+  return true;
+}
+
+
+
+int32 UTwitchChatter::GetSlowModeDelay(const FString& Channel) const
+{
+  const FTWChannelState* State = ChannelStates.Find(Channel.ToLower());
+
+  if (State == nullptr || State->IsPrivileged())
+    return 0;
+
+  return State->SlowModeSeconds;
+}
+
+
+
+void UTwitchChatter::SetUserDirectoryCapacity(int32 Capacity)
+{
+  UserDirectory.SetCapacity(Capacity);
+}
+
+
+
+FTWUserDirectoryStats UTwitchChatter::GetUserDirectoryStats() const
+{
+  return UserDirectory.GetStats();
+}
+
+
+
+bool UTwitchChatter::FindChatter(const FString& UserID, FTWChatterInfo& OutChatter) const
+{
+  TSharedPtr<const FTWChatterInfo> Chatter = UserDirectory.Find(UserID);
+
+  if (!Chatter.IsValid())
+    return false;
+
+  OutChatter = *Chatter;
+  return true;
+}
+
+
+
+bool UTwitchChatter::GetMessageChatter(const FPrivMsgMessage& Message, FTWChatterInfo& OutChatter)
+{
+  if (!Message.Tags.Chatter.IsValid())
+    return false;
+
+  OutChatter = *Message.Tags.Chatter;
+  return true;
+}
+
+
+
+void UTwitchChatter::SetDefaultHistoryCapacity(int32 Capacity)
+{
+  MessageHistory.SetDefaultCapacity(Capacity);
+}
+
+
+
+void UTwitchChatter::SetChannelHistoryCapacity(const FString& Channel, int32 Capacity)
+{
+  MessageHistory.SetChannelCapacity(Channel, Capacity);
+}
+
+
+
+TArray<FPrivMsgMessage> UTwitchChatter::GetChannelHistory(const FString& Channel) const
+{
+  TArray<FPrivMsgMessage> Messages;
+  MessageHistory.GetMessages(Channel.ToLower(), Messages);
+  return Messages;
+}
+
+
+
+void UTwitchChatter::SetKeywords(const TArray<FString>& Keywords, bool bCaseInsensitive)
+{
+  KeywordMatcher.SetPatterns(Keywords, bCaseInsensitive);
+}
+
+
+
+void UTwitchChatter::ClearKeywords()
+{
+  KeywordMatcher.Reset();
+}
+
+
+
+void UTwitchChatter::SetMetricWindows(const TArray<float>& WindowSeconds)
+{
+  ChatMetrics.SetWindows(WindowSeconds);
+}
+
+
+
+TArray<float> UTwitchChatter::GetMetricWindows() const
+{
+  return ChatMetrics.GetWindows();
+}
+
+
+
+bool UTwitchChatter::GetChatRates(const FString& Channel, int32 WindowIndex, FTWChatRates& OutRates) const
+{
+  return ChatMetrics.GetRates(Channel.ToLower(), WindowIndex, FPlatformTime::Seconds(), OutRates);
+}
+
+
+
+void UTwitchChatter::SetUniqueChattersWindow(float WindowSeconds)
+{
+  UniqueChatters.SetWindow(WindowSeconds);
+}
+
+
+
+bool UTwitchChatter::GetUniqueChatters(const FString& Channel, FTWUniqueChatterEstimate& OutEstimate) const
+{
+  return UniqueChatters.Estimate(Channel.ToLower(), FPlatformTime::Seconds(), OutEstimate);
+}
+
+
+
+int32 UTwitchChatter::StartPoll(const FString& Channel, const FTWPollSettings& Settings)
+{
+  const int32 PollID = Polls.StartPoll(Channel, Settings, FPlatformTime::Seconds());
+
+  if (PollID != INDEX_NONE)
+    EnsureTicker();
+
+  return PollID;
+}
+
+
+
+bool UTwitchChatter::EndPoll(int32 PollID)
+{
+  FTWPollSnapshot Snapshot;
+
+  if (!Polls.EndPoll(PollID, Snapshot))
+    return false;
+
+  TWITCH_BROADCAST(EventPollUpdated, OnPollUpdated, Snapshot);
+  return true;
+}
+
+
+
+bool UTwitchChatter::GetPollSnapshot(int32 PollID, FTWPollSnapshot& OutSnapshot) const
+{
+  return Polls.GetSnapshot(PollID, OutSnapshot);
+}
+
+
+
+void UTwitchChatter::SetTrendCapacity(int32 Capacity)
+{
+  Trends.SetCapacity(Capacity);
+}
+
+
+
+TArray<FTWHeavyHitter> UTwitchChatter::GetTopEmotes(const FString& Channel, int32 Count) const
+{
+  TArray<FTWHeavyHitter> Top;
+  Trends.GetTopEmotes(Channel.ToLower(), Count, Top);
+  return Top;
+}
+
+
+
+TArray<FTWHeavyHitter> UTwitchChatter::GetTopWords(const FString& Channel, int32 Count) const
+{
+  TArray<FTWHeavyHitter> Top;
+  Trends.GetTopWords(Channel.ToLower(), Count, Top);
+  return Top;
+}
+
+
+
+void UTwitchChatter::SetDuplicateWindow(float WindowSeconds)
+{
+  DuplicateDetector.SetWindow(WindowSeconds);
+}
+
+
+
+void UTwitchChatter::EnsureTicker()
+{
+  if (!TickerHandle.IsValid())
+    TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &UTwitchChatter::Tick));
+}
+
+
+
+void UTwitchChatter::EnsureTickerIfNeeded()
+{
+  if (Client.NeedsTick())
+    EnsureTicker();
+}
+
+
+
+bool UTwitchChatter::Tick(float DeltaTime)
+{
+  const double Now = FPlatformTime::Seconds();
+
+  RetiredSockets.Reset();
+  DrainIngress();
+
+  if (PendingSocket.IsValid())
+  {
+    if (Now < MigrationDeadline)
+      PumpMigration(Now);
+    else if (bPendingAuthenticated)
+      FinishMigration();
+    else
+      AbortMigration();
+  }
+
+  // Sends what the rate limits allow, probes the connection and makes due reconnect attempts
+  if (!Client.Tick(Now))
+    TWITCH_LOG(Log, TEXT("TWITCH: Connection stalled, reconnecting"));
+
+  if (Client.IsHealthRunning() && Now >= NextHealthUpdate)
+  {
+    ConnectionHealth = Client.GetHealth(Now);
+    NextHealthUpdate = Now + 1.0;
+  }
+
+  Polls.Tick(Now, [this](const FTWPollSnapshot& Snapshot)
+  {
+    TWITCH_BROADCAST(EventPollUpdated, OnPollUpdated, Snapshot);
+  });
+
+  if (CollapsedDuplicates.Num() > 0 && Now >= NextCollapseFlush)
+  {
+    FlushCollapsedDuplicates();
+    NextCollapseFlush = Now + 1.0;
+  }
+
+  // Returning false removes the ticker, EnsureTicker adds it back once there is work again
+  if (!Polls.HasPolls() && CollapsedDuplicates.Num() == 0 && !Client.NeedsTick() && !PendingSocket.IsValid()
+    && RetiredSockets.Num() == 0 && !NeedsDraining())
+  {
+    TickerHandle.Reset();
+    return false;
+  }
+
+  return true;
+}
+
+
+
+void UTwitchChatter::FlushCollapsedDuplicates()
+{
+  TMap<int32, FCollapsedDuplicates> Flushing = MoveTemp(CollapsedDuplicates);
+  CollapsedDuplicates.Reset();
+
+  for (const TPair<int32, FCollapsedDuplicates>& Pair : Flushing)
+  {
+    TWITCH_BROADCAST(EventDuplicatesCollapsed, OnDuplicatesCollapsed, Pair.Value.Latest, Pair.Value.Collapsed);
   }
 }
 
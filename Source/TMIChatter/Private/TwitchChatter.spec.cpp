@@ -1,8 +1,10 @@
 #include "TwitchChatter.h"
+#include "TMILoopbackTransport.h"
 
 BEGIN_DEFINE_SPEC(TwitchChatterSpec, "TwitchChatter", EAutomationTestFlags::ProductFilter | EAutomationTestFlags::ApplicationContextMask)
 
 TStrongObjectPtr<UTwitchChatter> TwitchChatter = nullptr;
+TSharedPtr<FTMILoopbackTransport> Server;		// The other end of TwitchChatter's connection in Manual Input
 
 // Ensure the username is all lowercase
 const FString BOT_USERNAME = TEXT("thejollybeardobot");
@@ -135,11 +137,22 @@ void TwitchChatterSpec::Define()
       {
         if (!TwitchChatter.IsValid())
         {
+          // Logged in over a loopback, the lines below are fed in by hand
+          TSharedRef<FTMILoopbackTransport> Transport = MakeShared<FTMILoopbackTransport>();
+          Server = Transport;
+
           TwitchChatter = TStrongObjectPtr<UTwitchChatter>(NewObject<UTwitchChatter>());
-          TwitchChatter->bAuthenticated = true;
-          TwitchChatter->BotUsername = BOT_USERNAME;
+          TwitchChatter->SetTransportFactory([Transport]() -> TSharedRef<ITMITransport> { return Transport; });
+          TwitchChatter->Connect(BOT_USERNAME, TEXT("secret"), {}, false, true);
+          Server->Receive(TEXT(":tmi.twitch.tv GLOBALUSERSTATE"));
         }
 
+        TwitchChatter->IgnoredLogins.Empty();
+        TwitchChatter->RebuildIgnoredSources();
+        TwitchChatter->ChannelStates.Reset();
+        TwitchChatter->UserDirectory.SetCapacity(0);
+        TwitchChatter->UserDirectory.Reset();
+
         TwitchChatter->ResetEventHandlers();
 
         Done.Execute();
@@ -169,7 +182,212 @@ void TwitchChatterSpec::Define()
         });
         
         bHasBits = false;
-        TwitchChatter->HandleMessage(RawMessage);
+        Server->Receive(RawMessage);
+      });
+
+      LatentIt("should only drop our own messages when the login matches exactly", [this](const FDoneDelegate& Done) {
+        const FString OwnMessage = FString::Printf(TEXT(":%s!%s@%s.tmi.twitch.tv PRIVMSG #ronni :echo"), *BOT_USERNAME, *BOT_USERNAME, *BOT_USERNAME);
+        const FString FanLogin = TEXT("not") + BOT_USERNAME + TEXT("fan");
+        const FString FanMessage = FString::Printf(TEXT(":%s!%s@%s.tmi.twitch.tv PRIVMSG #ronni :hello"), *FanLogin, *FanLogin, *FanLogin);
+
+        TwitchChatter->EventChatMessage.AddLambda([this, Done, FanLogin](const FPrivMsgMessage& Message) {
+          TestEqual("From User", Message.FromUser, FanLogin);
+          Done.Execute();
+        });
+
+        Server->Receive(OwnMessage);
+        Server->Receive(FanMessage);
+      });
+
+      It("should only report channel state fields that changed", [this]() {
+        TArray<ETWChannelStateField> Changes;
+
+        TwitchChatter->EventChannelStateChanged.AddLambda([&Changes](const FTWChannelState& State, ETWChannelStateField ChangedFields) {
+          Changes.Add(ChangedFields);
+        });
+
+        Server->Receive(TEXT("@emote-only=0;followers-only=-1;r9k=0;rituals=0;room-id=12345678;slow=0;subs-only=0 :tmi.twitch.tv ROOMSTATE #bar"));
+        Server->Receive(TEXT("@room-id=12345678;slow=10 :tmi.twitch.tv ROOMSTATE #bar"));
+        Server->Receive(TEXT("@room-id=12345678;slow=10 :tmi.twitch.tv ROOMSTATE #bar"));
+        Server->Receive(TEXT("@badge-info=;badges=moderator/1;color=;display-name=bot;emote-sets=0;mod=1;subscriber=0;user-type=mod :tmi.twitch.tv USERSTATE #bar"));
+
+        TestEqual("Change Count", Changes.Num(), 3);
+
+        if (Changes.Num() == 3)
+        {
+          TestTrue("Slow Changed", Changes[1] == ETWChannelStateField::Slow);
+          TestTrue("Moderator Changed", EnumHasAnyFlags(Changes[2], ETWChannelStateField::Moderator));
+        }
+
+        FTWChannelState State;
+        TestTrue("Has State", TwitchChatter->GetChannelState(TEXT("bar"), State));
+        TestEqual("SlowModeSeconds", State.SlowModeSeconds, 10);
+        TestFalse("EmoteOnly Kept", State.EmoteOnly);
+        TestEqual("Moderators skip slow mode", TwitchChatter->GetSlowModeDelay(TEXT("bar")), 0);
+      });
+
+      It("should share one chatter record between messages until their tags change", [this]() {
+        TArray<TSharedPtr<const FTWChatterInfo>> Chatters;
+
+        TwitchChatter->SetUserDirectoryCapacity(16);
+        TwitchChatter->EventChatMessage.AddLambda([&Chatters](const FPrivMsgMessage& Message) {
+          Chatters.Add(Message.Tags.Chatter);
+        });
+
+        Server->Receive(TEXT("@badges=vip/1;color=#0D4200;display-name=Ronni;user-id=1337 :ronni!ronni@ronni.tmi.twitch.tv PRIVMSG #ronni :one"));
+        Server->Receive(TEXT("@badges=vip/1;color=#0D4200;display-name=Ronni;user-id=1337 :ronni!ronni@ronni.tmi.twitch.tv PRIVMSG #ronni :two"));
+        Server->Receive(TEXT("@badges=vip/1;color=#FF0000;display-name=Ronni;user-id=1337 :ronni!ronni@ronni.tmi.twitch.tv PRIVMSG #ronni :three"));
+
+        TestEqual("Message Count", Chatters.Num(), 3);
+
+        if (Chatters.Num() == 3)
+        {
+          TestTrue("Chatter Resolved", Chatters[0].IsValid());
+          TestTrue("Same Record", Chatters[0] == Chatters[1]);
+          TestTrue("New Record On Change", Chatters[1] != Chatters[2]);
+          TestEqual("Display Name", Chatters[0]->DisplayName, FString(TEXT("Ronni")));
+          TestTrue("Badges", Chatters[0]->Badges.Contains(TEXT("vip")));
+        }
+
+        FTWUserDirectoryStats Stats = TwitchChatter->GetUserDirectoryStats();
+        TestEqual("Hits", Stats.Hits, (int64)1);
+        TestEqual("Updates", Stats.Updates, (int64)1);
+        TestEqual("Num", Stats.Num, 1);
+      });
+
+      LatentIt("should drop messages from ignored logins", [this](const FDoneDelegate& Done) {
+        TwitchChatter->IgnoreLogin(TEXT("NightBot"));
+
+        TwitchChatter->EventChatMessage.AddLambda([this, Done](const FPrivMsgMessage& Message) {
+          TestEqual("From User", Message.FromUser, FString(TEXT("ronni")));
+          Done.Execute();
+        });
+
+        Server->Receive(TEXT(":nightbot!nightbot@nightbot.tmi.twitch.tv PRIVMSG #ronni :!commands"));
+        Server->Receive(TEXT(":ronni!ronni@ronni.tmi.twitch.tv PRIVMSG #ronni :hi"));
+      });
+
+      It("should not create a socket before connecting", [this]() {
+        TStrongObjectPtr<UTwitchChatter> Unconnected(NewObject<UTwitchChatter>());
+        TestFalse("Instance Socket", Unconnected->Socket.IsValid());
+        TestFalse("Default Object Socket", GetDefault<UTwitchChatter>()->Socket.IsValid());
+      });
+    });
+
+    Describe("Loopback Transport", [this]()
+    {
+      It("should log in, join and answer PINGs without a network", [this]() {
+        TStrongObjectPtr<UTwitchChatter> Chatter(NewObject<UTwitchChatter>());
+        TSharedRef<FTMILoopbackTransport> Loopback = MakeShared<FTMILoopbackTransport>();
+        Chatter->SetTransportFactory([Loopback]() -> TSharedRef<ITMITransport> { return Loopback; });
+
+        bool bAuthenticated = false;
+        Chatter->EventAuthSuccess.AddLambda([&bAuthenticated](const FGlobalUserStateMessage& Message) {
+          bAuthenticated = true;
+        });
+
+        Chatter->Connect(BOT_USERNAME, TEXT("secret"), { TEXT("ronni") }, false, true);
+
+        TestEqual("Connects", Loopback->Connects, 1);
+        TestEqual("Login", FString::Join(Loopback->Sent, TEXT("|")), TEXT("CAP REQ :twitch.tv/commands|PASS oauth:secret|NICK ") + BOT_USERNAME);
+
+        Loopback->Sent.Reset();
+        Loopback->Receive(TEXT(":tmi.twitch.tv GLOBALUSERSTATE"));
+        Loopback->Receive(TEXT("PING :tmi.twitch.tv"));
+
+        TestTrue("Authenticated", bAuthenticated);
+        TestEqual("Sent", FString::Join(Loopback->Sent, TEXT("|")), FString(TEXT("JOIN #ronni|PONG :tmi.twitch.tv")));
+
+        Chatter->Disconnect();
+        TestFalse("Connected", Loopback->IsConnected());
+      });
+
+      It("should not report channels as joined again when a migration switches over before every JOIN is confirmed", [this]() {
+        TStrongObjectPtr<UTwitchChatter> Chatter(NewObject<UTwitchChatter>());
+        TArray<TSharedRef<FTMILoopbackTransport>> Loopbacks;
+        Chatter->SetTransportFactory([&Loopbacks]() -> TSharedRef<ITMITransport> { return Loopbacks.Add_GetRef(MakeShared<FTMILoopbackTransport>()); });
+
+        int32 Joined = 0;
+        Chatter->EventJoinedChannel.AddLambda([&Joined](const FString& Channel) {
+          ++Joined;
+        });
+
+        Chatter->Connect(BOT_USERNAME, TEXT("secret"), { TEXT("a"), TEXT("b"), TEXT("c") }, false, true);
+        Loopbacks[0]->Receive(TEXT(":tmi.twitch.tv GLOBALUSERSTATE"));
+
+        for (const TCHAR* Channel : { TEXT("a"), TEXT("b"), TEXT("c") })
+          Loopbacks[0]->Receive(FString::Printf(TEXT(":bot!bot@bot.tmi.twitch.tv JOIN #%s"), Channel));
+
+        TestEqual("Joined", Joined, 3);
+
+        // Only a and b fit the join limit on the new connection, c is left for after the switch-over
+        Loopbacks[0]->Receive(TEXT(":tmi.twitch.tv RECONNECT"));
+
+        if (!TestEqual("New Connection", Loopbacks.Num(), 2))
+          return;
+
+        const TSharedRef<FTMITokenBucket> JoinBucket = Chatter->Client.GetJoinBucket();
+        JoinBucket->Tokens = 2.0;
+        JoinBucket->LastRefill = FPlatformTime::Seconds();
+
+        Loopbacks[1]->Receive(TEXT(":tmi.twitch.tv GLOBALUSERSTATE"));
+        TestTrue("Joining", Loopbacks[1]->Sent.Contains(TEXT("JOIN #a,#b")));
+        Loopbacks[1]->Receive(TEXT(":bot!bot@bot.tmi.twitch.tv JOIN #a"));
+
+        // Out of time, b is still unconfirmed and c wasn't sent
+        Chatter->MigrationDeadline = 0.0;
+        Chatter->Tick(0.f);
+        TestFalse("Switched Over", Chatter->PendingSocket.IsValid());
+
+        JoinBucket->Reset();
+        Chatter->Client.Pump(FPlatformTime::Seconds());
+        TestTrue("Rejoining", Loopbacks[1]->Sent.Contains(TEXT("JOIN #c")));
+
+        Loopbacks[1]->Receive(TEXT(":bot!bot@bot.tmi.twitch.tv JOIN #b"));
+        Loopbacks[1]->Receive(TEXT(":bot!bot@bot.tmi.twitch.tv JOIN #c"));
+        TestEqual("Not Joined Again", Joined, 3);
+
+        Chatter->JoinChannel(TEXT("d"));
+        Loopbacks[1]->Receive(TEXT(":bot!bot@bot.tmi.twitch.tv JOIN #d"));
+        TestEqual("New Channel", Joined, 4);
+
+        Chatter->Disconnect();
+      });
+
+      It("should deliver messages seen by both connections once while migrating", [this]() {
+        TStrongObjectPtr<UTwitchChatter> Chatter(NewObject<UTwitchChatter>());
+        TArray<TSharedRef<FTMILoopbackTransport>> Loopbacks;
+        Chatter->SetTransportFactory([&Loopbacks]() -> TSharedRef<ITMITransport> { return Loopbacks.Add_GetRef(MakeShared<FTMILoopbackTransport>()); });
+
+        int32 Received = 0;
+        Chatter->EventChatMessage.AddLambda([&Received](const FPrivMsgMessage& Message) {
+          ++Received;
+        });
+
+        Chatter->Connect(BOT_USERNAME, TEXT("secret"), { TEXT("ronni") }, false, true);
+        Loopbacks[0]->Receive(TEXT(":tmi.twitch.tv GLOBALUSERSTATE"));
+        Loopbacks[0]->Receive(TEXT(":bot!bot@bot.tmi.twitch.tv JOIN #ronni"));
+
+        // Logged in on the new connection, its JOIN isn't confirmed yet so both keep delivering
+        Loopbacks[0]->Receive(TEXT(":tmi.twitch.tv RECONNECT"));
+
+        if (!TestEqual("New Connection", Loopbacks.Num(), 2))
+          return;
+
+        Loopbacks[1]->Receive(TEXT(":tmi.twitch.tv GLOBALUSERSTATE"));
+        TestTrue("Migrating", Chatter->PendingSocket.IsValid());
+
+        const TCHAR* First = TEXT("@id=a1;room-id=1 :ronni!ronni@ronni.tmi.twitch.tv PRIVMSG #ronni :hi");
+        const TCHAR* Second = TEXT("@id=b2;room-id=1 :ronni!ronni@ronni.tmi.twitch.tv PRIVMSG #ronni :hi");
+
+        Loopbacks[0]->Receive(First);
+        Loopbacks[1]->Receive(First);
+        Loopbacks[1]->Receive(Second);
+        Loopbacks[0]->Receive(Second);
+
+        TestEqual("Received", Received, 2);
+
+        Chatter->Disconnect();
       });
     });
   });
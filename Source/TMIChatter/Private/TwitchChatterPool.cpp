@@ -0,0 +1,412 @@
+#include "TwitchChatterPool.h"
+
+#if TWITCH_CHATTER_BLUEPRINT_EVENTS
+#define POOL_BROADCAST(Event, Delegate, ...) \
+  do { \
+    Event.Broadcast(__VA_ARGS__); \
+    if (!bNativeEventsOnly) \
+      Delegate.Broadcast(__VA_ARGS__); \
+  } while (0)
+#else
+#define POOL_BROADCAST(Event, Delegate, ...) Event.Broadcast(__VA_ARGS__)
+#endif
+
+
+
+void UTwitchChatterPool::Connect(const FString& Username, const FString& Password, const TArray<FString>& Channels, bool AutoReconnect, bool FastMode)
+{
+  if (bConnected)
+    return;
+
+  BotUsername = Username;
+  BotPassword = Password;
+  bReconnect = AutoReconnect;
+  bFastMode = FastMode;
+  bConnected = true;
+
+  JoinChannels(Channels);
+}
+
+
+
+void UTwitchChatterPool::Disconnect()
+{
+  for (TMap<int32, TObjectPtr<UTwitchChatter>>* Map : { &Shards, &RetiredShards })
+  {
+    for (const TPair<int32, TObjectPtr<UTwitchChatter>>& Shard : *Map)
+    {
+      Shard.Value->ResetEventHandlers(true, false);
+      Shard.Value->Disconnect();
+    }
+
+    Map->Reset();
+  }
+
+  Planner.Reset();
+  MovingFrom.Reset();
+
+  BotUsername = TEXT("");
+  BotPassword = TEXT("");
+  bConnected = false;
+}
+
+
+
+void UTwitchChatterPool::JoinChannel(const FString& Channel)
+{
+  JoinChannels({ Channel });
+}
+
+
+
+void UTwitchChatterPool::JoinChannels(const TArray<FString>& Channels)
+{
+  if (!bConnected)
+    return;
+
+  TArray<FString> NewChannels;
+
+  for (const FString& Channel : Channels)
+  {
+    const FString Chan = Channel.ToLower();
+
+    if (!Chan.IsEmpty() && Planner.FindShard(Chan) == INDEX_NONE)
+      NewChannels.AddUnique(Chan);
+  }
+
+  if (NewChannels.Num() == 0)
+    return;
+
+  Planner.AddMany(NewChannels);
+  SyncShards({});
+
+  // Connections still logging in join everything they own once authenticated instead
+  for (const FString& Chan : NewChannels)
+    Shards[Planner.FindShard(Chan)]->JoinChannel(Chan);
+}
+
+
+
+void UTwitchChatterPool::PartChannel(const FString& Channel)
+{
+  const FString Chan = Channel.ToLower();
+  TArray<FTMIShardMove> Moves;
+  const int32 ShardID = Planner.Remove(Chan, Moves);
+
+  if (ShardID == INDEX_NONE)
+    return;
+
+  // Halfway through a move both connections are in the channel
+  int32 FromShard = INDEX_NONE;
+
+  if (MovingFrom.RemoveAndCopyValue(Chan, FromShard))
+  {
+    if (UTwitchChatter* From = FindShard(FromShard))
+      From->PartChannel(Chan);
+  }
+
+  Shards[ShardID]->PartChannel(Chan);
+  SyncShards(Moves);
+}
+
+
+
+bool UTwitchChatterPool::Send(const FString& Channel, const FString& Message)
+{
+  if (UTwitchChatter* Shard = GetConnectionFor(Channel))
+    return Shard->Send(Channel, Message);
+
+  return true;
+}
+
+
+
+bool UTwitchChatterPool::Broadcast(const FString& Message)
+{
+  TArray<int32> ShardIDs;
+  Planner.GetShardIDs(ShardIDs);
+
+  // A moving channel is in two connections, only the one delivering it sends
+  TMap<int32, TArray<FString>> Targets;
+
+  for (int32 ShardID : ShardIDs)
+  {
+    for (const FString& Channel : Planner.GetChannels(ShardID))
+      Targets.FindOrAdd(GetOwner(Channel)).Add(Channel);
+  }
+
+  bool bWhole = true;
+
+  for (const TPair<int32, TArray<FString>>& Target : Targets)
+  {
+    if (UTwitchChatter* Shard = FindShard(Target.Key))
+      bWhole &= Shard->BroadcastTo(Target.Value, Message);
+  }
+
+  return bWhole;
+}
+
+
+
+void UTwitchChatterPool::SetChannelsPerConnection(int32 Limit)
+{
+  TArray<FTMIShardMove> Moves;
+  Planner.SetChannelsPerShard(Limit, Moves);
+
+  if (bConnected)
+    SyncShards(Moves);
+}
+
+
+
+int32 UTwitchChatterPool::GetChannelsPerConnection() const
+{
+  return Planner.GetChannelsPerShard();
+}
+
+
+
+int32 UTwitchChatterPool::GetNumConnections() const
+{
+  return Shards.Num();
+}
+
+
+
+UTwitchChatter* UTwitchChatterPool::GetConnectionFor(const FString& Channel) const
+{
+  return FindShard(GetOwner(Channel));
+}
+
+
+
+TArray<UTwitchChatter*> UTwitchChatterPool::GetConnections() const
+{
+  TArray<UTwitchChatter*> Connections;
+
+  for (const TPair<int32, TObjectPtr<UTwitchChatter>>& Shard : Shards)
+    Connections.Add(Shard.Value);
+
+  return Connections;
+}
+
+
+
+void UTwitchChatterPool::SyncShards(const TArray<FTMIShardMove>& Moves)
+{
+  TArray<int32> ShardIDs;
+  Planner.GetShardIDs(ShardIDs);
+
+  for (int32 ShardID : ShardIDs)
+  {
+    if (!Shards.Contains(ShardID))
+      OpenShard(ShardID);
+  }
+
+  // The old connection keeps delivering the channel until HandleJoinedChannel sees the new one got in
+  for (const FTMIShardMove& Move : Moves)
+  {
+    if (const int32* Delivering = MovingFrom.Find(Move.Channel))
+    {
+      // Moved again before the JOIN was confirmed, the shard in between never delivered it
+      if (UTwitchChatter* From = FindShard(Move.FromShard))
+        From->PartChannel(Move.Channel);
+
+      // Back where it still is
+      if (*Delivering == Move.ToShard)
+      {
+        MovingFrom.Remove(Move.Channel);
+        continue;
+      }
+    }
+    else
+    {
+      MovingFrom.Add(Move.Channel, Move.FromShard);
+    }
+
+    Shards[Move.ToShard]->JoinChannel(Move.Channel);
+  }
+
+  for (auto It = Shards.CreateIterator(); It; ++It)
+  {
+    if (!ShardIDs.Contains(It.Key()))
+    {
+      RetiredShards.Add(It.Key(), It.Value());
+      It.RemoveCurrent();
+    }
+  }
+
+  CloseRetiredShards();
+}
+
+
+
+void UTwitchChatterPool::CloseRetiredShards()
+{
+  for (auto It = RetiredShards.CreateIterator(); It; ++It)
+  {
+    bool bDelivering = false;
+
+    for (const TPair<FString, int32>& Move : MovingFrom)
+      bDelivering |= Move.Value == It.Key();
+
+    if (!bDelivering)
+    {
+      It.Value()->ResetEventHandlers(true, false);
+      It.Value()->Disconnect();
+      It.RemoveCurrent();
+    }
+  }
+}
+
+
+
+UTwitchChatter* UTwitchChatterPool::FindShard(int32 ShardID) const
+{
+  const TObjectPtr<UTwitchChatter>* Shard = Shards.Find(ShardID);
+
+  if (Shard == nullptr)
+    Shard = RetiredShards.Find(ShardID);
+
+  return Shard ? Shard->Get() : nullptr;
+}
+
+
+
+int32 UTwitchChatterPool::GetOwner(const FString& Channel) const
+{
+  const int32* From = MovingFrom.Find(Channel);
+  return From ? *From : Planner.FindShard(Channel);
+}
+
+
+
+UTwitchChatter* UTwitchChatterPool::OpenShard(int32 ShardID)
+{
+  UTwitchChatter* Shard = NewObject<UTwitchChatter>(this);
+  Shard->bNativeEventsOnly = true;
+
+  if (TransportFactory)
+    Shard->SetTransportFactory(TransportFactory);
+
+  // Twitch limits joins and chat per account, not per connection
+  for (TMap<int32, TObjectPtr<UTwitchChatter>>* Map : { &Shards, &RetiredShards })
+  {
+    if (Map->Num() > 0)
+    {
+      Shard->ShareRateLimits(*Map->CreateConstIterator().Value());
+      break;
+    }
+  }
+
+  Shard->EventAuthSuccess.AddUObject(this, &UTwitchChatterPool::HandleAuthSuccess, ShardID);
+  Shard->EventChatMessage.AddUObject(this, &UTwitchChatterPool::HandleChatMessage, ShardID);
+  Shard->EventChatBits.AddUObject(this, &UTwitchChatterPool::HandleChatBits, ShardID);
+  Shard->EventChatCommand.AddUObject(this, &UTwitchChatterPool::HandleChatCommand, ShardID);
+  Shard->EventChatCleared.AddUObject(this, &UTwitchChatterPool::HandleChatCleared, ShardID);
+  Shard->EventMsgCleared.AddUObject(this, &UTwitchChatterPool::HandleMsgCleared, ShardID);
+  Shard->EventNotice.AddUObject(this, &UTwitchChatterPool::HandleNotice, ShardID);
+  Shard->EventUserNotice.AddUObject(this, &UTwitchChatterPool::HandleUserNotice, ShardID);
+  Shard->EventJoinedChannel.AddUObject(this, &UTwitchChatterPool::HandleJoinedChannel, ShardID);
+  Shard->EventPartedChannel.AddUObject(this, &UTwitchChatterPool::HandlePartedChannel, ShardID);
+
+  Shards.Add(ShardID, Shard);
+  Shard->Connect(BotUsername, BotPassword, {}, bReconnect, bFastMode);
+  return Shard;
+}
+
+
+
+void UTwitchChatterPool::HandleAuthSuccess(const FGlobalUserStateMessage& Message, int32 ShardID)
+{
+  // Also covers reconnects, channels the connection already joined are skipped
+  // Retired connections own no channels, they get back into the ones they still deliver on their own
+  if (UTwitchChatter* Shard = Shards.FindRef(ShardID))
+    Shard->JoinChannels(Planner.GetChannels(ShardID));
+}
+
+
+
+void UTwitchChatterPool::HandleChatMessage(const FPrivMsgMessage& Message, int32 ShardID)
+{
+  if (Owns(ShardID, Message.Channel))
+    POOL_BROADCAST(EventChatMessage, OnChatMessage, Message);
+}
+
+
+
+void UTwitchChatterPool::HandleChatBits(const FPrivMsgMessage& Message, int32 ShardID)
+{
+  if (Owns(ShardID, Message.Channel))
+    POOL_BROADCAST(EventChatBits, OnChatBits, Message);
+}
+
+
+
+void UTwitchChatterPool::HandleChatCommand(const FPrivMsgMessage& Message, const FString& Command, const FString& Params, int32 ShardID)
+{
+  if (Owns(ShardID, Message.Channel))
+    POOL_BROADCAST(EventChatCommand, OnChatCommand, Message, Command, Params);
+}
+
+
+
+void UTwitchChatterPool::HandleChatCleared(const FClearChatMessage& Message, int32 ShardID)
+{
+  if (Owns(ShardID, Message.Channel))
+    POOL_BROADCAST(EventChatCleared, OnClearChat, Message);
+}
+
+
+
+void UTwitchChatterPool::HandleMsgCleared(const FClearMsgMessage& Message, int32 ShardID)
+{
+  if (Owns(ShardID, Message.Channel))
+    POOL_BROADCAST(EventMsgCleared, OnClearMsg, Message);
+}
+
+
+
+void UTwitchChatterPool::HandleNotice(const FNoticeMessage& Message, int32 ShardID)
+{
+  // Notices without a channel are about the connection itself
+  if (Message.Channel.IsEmpty() || Owns(ShardID, Message.Channel))
+    POOL_BROADCAST(EventNotice, OnNotice, Message);
+}
+
+
+
+void UTwitchChatterPool::HandleUserNotice(const FUserNoticeMessage& Message, int32 ShardID)
+{
+  if (Owns(ShardID, Message.Channel))
+    POOL_BROADCAST(EventUserNotice, OnUserNotice, Message);
+}
+
+
+
+void UTwitchChatterPool::HandleJoinedChannel(const FString& Channel, int32 ShardID)
+{
+  int32 FromShard = INDEX_NONE;
+
+  // A move is done once the new connection got in, the old one can leave without a gap in the channel's events
+  if (Planner.FindShard(Channel) == ShardID && MovingFrom.RemoveAndCopyValue(Channel, FromShard))
+  {
+    if (UTwitchChatter* From = FindShard(FromShard))
+      From->PartChannel(Channel);
+
+    CloseRetiredShards();
+    return;
+  }
+
+  if (Owns(ShardID, Channel))
+    POOL_BROADCAST(EventJoinedChannel, OnJoinedChannel, Channel);
+}
+
+
+
+void UTwitchChatterPool::HandlePartedChannel(const FString& Channel, int32 ShardID)
+{
+  // Channels moving to another connection aren't reported as parted
+  if (Planner.FindShard(Channel) == INDEX_NONE)
+    POOL_BROADCAST(EventPartedChannel, OnPartedChannel, Channel);
+}
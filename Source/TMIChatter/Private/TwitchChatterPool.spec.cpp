@@ -0,0 +1,116 @@
+#include "TwitchChatterPool.h"
+#include "TMILoopbackTransport.h"
+
+BEGIN_DEFINE_SPEC(TwitchChatterPoolSpec, "TwitchChatterPool", EAutomationTestFlags::ProductFilter | EAutomationTestFlags::ApplicationContextMask)
+
+TStrongObjectPtr<UTwitchChatterPool> Pool;
+TArray<TSharedRef<FTMILoopbackTransport>> Loopbacks;		// One per connection, in the order they were opened
+TArray<FString> Delivered;
+
+void Authenticate(int32 Connection)
+{
+  Loopbacks[Connection]->Receive(TEXT(":tmi.twitch.tv GLOBALUSERSTATE"));
+}
+
+void ConfirmJoin(int32 Connection, const FString& Channel)
+{
+  Loopbacks[Connection]->Receive(FString::Printf(TEXT(":bot!bot@bot.tmi.twitch.tv JOIN #%s"), *Channel));
+}
+
+void Chat(int32 Connection, const FString& Channel, const FString& Text)
+{
+  Loopbacks[Connection]->Receive(FString::Printf(TEXT(":viewer!viewer@viewer.tmi.twitch.tv PRIVMSG #%s :%s"), *Channel, *Text));
+}
+
+END_DEFINE_SPEC(TwitchChatterPoolSpec);
+
+void TwitchChatterPoolSpec::Define()
+{
+  BeforeEach([this]()
+  {
+    Pool = TStrongObjectPtr<UTwitchChatterPool>(NewObject<UTwitchChatterPool>());
+    Loopbacks.Reset();
+    Delivered.Reset();
+
+    Pool->SetTransportFactory([this]() -> TSharedRef<ITMITransport>
+    {
+      return Loopbacks.Add_GetRef(MakeShared<FTMILoopbackTransport>());
+    });
+
+    Pool->EventChatMessage.AddLambda([this](const FPrivMsgMessage& Message)
+    {
+      Delivered.Add(Message.Message);
+    });
+
+    Pool->SetChannelsPerConnection(3);
+    Pool->Connect(TEXT("bot"), TEXT("secret"), { TEXT("a"), TEXT("b"), TEXT("c") }, false, true);
+
+    Authenticate(0);
+
+    for (const TCHAR* Channel : { TEXT("a"), TEXT("b"), TEXT("c") })
+      ConfirmJoin(0, Channel);
+  });
+
+  AfterEach([this]()
+  {
+    Pool->Disconnect();
+    Pool.Reset();
+  });
+
+  It("should only part the old connection once the new one joined", [this]()
+  {
+    UTwitchChatter* First = Pool->GetConnectionFor(TEXT("c"));
+    Pool->SetChannelsPerConnection(2);
+
+    if (!TestEqual("Connections", Loopbacks.Num(), 2))
+      return;
+
+    Authenticate(1);
+    TestTrue("Joining", Loopbacks[1]->Sent.Contains(TEXT("JOIN #c")));
+    TestFalse("Still In", Loopbacks[0]->Sent.Contains(TEXT("PART #c")));
+    TestTrue("Old Connection Delivers", Pool->GetConnectionFor(TEXT("c")) == First);
+
+    Chat(0, TEXT("c"), TEXT("before"));
+    Chat(1, TEXT("c"), TEXT("before"));
+
+    ConfirmJoin(1, TEXT("c"));
+    TestTrue("Parted", Loopbacks[0]->Sent.Contains(TEXT("PART #c")));
+    TestFalse("Forgotten", First->ConnectedChannels.Contains(TEXT("c")));
+
+    Chat(0, TEXT("c"), TEXT("old"));
+    Chat(1, TEXT("c"), TEXT("after"));
+
+    TestEqual("Delivered", Delivered, TArray<FString>({ TEXT("before"), TEXT("after") }));
+    TestTrue("New Connection Delivers", Pool->GetConnectionFor(TEXT("c")) != First);
+  });
+
+  It("should join a channel moved back to a connection that parted it", [this]()
+  {
+    UTwitchChatter* First = Pool->GetConnectionFor(TEXT("c"));
+    Pool->SetChannelsPerConnection(2);
+
+    if (!TestEqual("Connections", Loopbacks.Num(), 2))
+      return;
+
+    Authenticate(1);
+    ConfirmJoin(1, TEXT("c"));
+    UTwitchChatter* Second = Pool->GetConnectionFor(TEXT("c"));
+
+    // Everything fits one connection again, the smaller one is drained back into the first
+    Loopbacks[0]->Sent.Reset();
+    Pool->SetChannelsPerConnection(3);
+
+    TestTrue("Joined Again", Loopbacks[0]->Sent.Contains(TEXT("JOIN #c")));
+    TestTrue("Retired Connection Delivers", Pool->GetConnectionFor(TEXT("c")) == Second);
+    TestTrue("Retired Connection Open", Loopbacks[1]->IsConnected());
+
+    ConfirmJoin(0, TEXT("c"));
+    TestFalse("Retired Connection Closed", Loopbacks[1]->IsConnected());
+    TestEqual("Connections", Pool->GetNumConnections(), 1);
+    TestTrue("Back", Pool->GetConnectionFor(TEXT("c")) == First);
+    TestTrue("Channels", First->ConnectedChannels.Contains(TEXT("c")));
+
+    Chat(0, TEXT("c"), TEXT("back"));
+    TestEqual("Delivered", Delivered, TArray<FString>({ TEXT("back") }));
+  });
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TMIParser.h"
+
+#include "TMIChannelState.generated.h"
+
+// Which parts of a channel's state changed in a single update
+UENUM(BlueprintType, meta = (Bitflags, UseEnumValuesAsMaskValuesInEditor = "true"))
+enum class ETWChannelStateField : uint8
+{
+	None = 0 UMETA(Hidden),
+	EmoteOnly = 1 << 0,
+	FollowersOnly = 1 << 1,
+	R9K = 1 << 2,
+	Slow = 1 << 3,
+	SubsOnly = 1 << 4,
+	Moderator = 1 << 5,		// Our moderator or broadcaster status
+	VIP = 1 << 6,
+	Subscriber = 1 << 7
+};
+ENUM_CLASS_FLAGS(ETWChannelStateField);
+
+// Everything we know about a joined channel, the room settings from ROOMSTATE and our own standing from USERSTATE
+USTRUCT(BlueprintType)
+struct FTWChannelState
+{
+	GENERATED_USTRUCT_BODY();
+
+	FTWChannelState() {}
+	explicit FTWChannelState(const FString& Channel) : Channel(Channel) {}
+
+	// Privileged users are not subject to slow mode
+	bool IsPrivileged() const
+	{
+		return bIsModerator || bIsBroadcaster || bIsVIP;
+	}
+
+	UPROPERTY(BlueprintReadOnly)
+		FString Channel;
+
+	UPROPERTY(BlueprintReadOnly)
+		bool EmoteOnly = false;
+
+	UPROPERTY(BlueprintReadOnly)
+		int32 FollowersOnlyMinMinutes = -1;	// if == -1 It is not in followers only mode
+
+	UPROPERTY(BlueprintReadOnly)
+		bool R9K = false;
+
+	UPROPERTY(BlueprintReadOnly)
+		int32 SlowModeSeconds = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+		bool SubscribersOnly = false;
+
+	UPROPERTY(BlueprintReadOnly)
+		bool bIsModerator = false;
+
+	UPROPERTY(BlueprintReadOnly)
+		bool bIsBroadcaster = false;
+
+	UPROPERTY(BlueprintReadOnly)
+		bool bIsVIP = false;
+
+	UPROPERTY(BlueprintReadOnly)
+		bool bIsSubscriber = false;
+
+	UPROPERTY(BlueprintReadOnly)
+		TMap<FString, int32> Badges;	// Our badges in this channel
+};
+
+// Per channel state, updated incrementally from ROOMSTATE deltas and USERSTATE messages
+class FTMIChannelStateStore
+{
+public:
+	// Both return the fields whose value actually changed, a channel's first update reports every field it carried
+	ETWChannelStateField ApplyRoomState(const FString& Channel, const FTWRoomStateTags& Tags);
+	ETWChannelStateField ApplyUserState(const FString& Channel, const FTWUserStateTags& Tags);
+
+	const FTWChannelState* Find(const FString& Channel) const { return States.Find(Channel); }
+
+	void Remove(const FString& Channel) { States.Remove(Channel); }
+	void Reset() { States.Reset(); }
+
+private:
+	FTWChannelState& FindOrAdd(const FString& Channel, bool& bOutAdded);
+
+	TMap<FString, FTWChannelState> States;
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "TMIChatMetrics.generated.h"
+
+UENUM(BlueprintType)
+enum class ETWChatMetric : uint8
+{
+	Messages,
+	Bits,
+	Subscriptions,		// Subs, resubs and individual gifted subs
+	Count UMETA(Hidden)
+};
+
+USTRUCT(BlueprintType)
+struct FTWChatRates
+{
+	GENERATED_USTRUCT_BODY();
+
+	UPROPERTY(BlueprintReadOnly)
+		float WindowSeconds = 0.f;
+
+	UPROPERTY(BlueprintReadOnly)
+		int64 Messages = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+		int64 Bits = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+		int64 Subscriptions = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+		float MessagesPerSecond = 0.f;
+
+	UPROPERTY(BlueprintReadOnly)
+		float BitsPerMinute = 0.f;
+
+	UPROPERTY(BlueprintReadOnly)
+		float SubsPerMinute = 0.f;
+};
+
+// Per channel counters over sliding windows
+// Every window is a ring of fixed width buckets with a running sum, so recording and querying are O(1)
+// and only the buckets that fell out of the window since the last access are cleared
+class FTMIChatMetrics
+{
+public:
+	static constexpr int32 BucketsPerWindow = 20;
+
+	FTMIChatMetrics();
+
+	// Window lengths in seconds, changing them drops the counts collected so far
+	void SetWindows(const TArray<float>& WindowSeconds);
+	const TArray<float>& GetWindows() const { return Windows; }
+
+	void Record(const FString& Channel, ETWChatMetric Metric, int64 Amount, double Now);
+
+	// Total of a metric within the window, 0 for unknown channels or windows
+	int64 GetCount(const FString& Channel, ETWChatMetric Metric, int32 WindowIndex, double Now) const;
+	bool GetRates(const FString& Channel, int32 WindowIndex, double Now, FTWChatRates& OutRates) const;
+
+	void Remove(const FString& Channel);
+	void Reset();
+
+private:
+	static constexpr int32 MetricCount = static_cast<int32>(ETWChatMetric::Count);
+
+	struct FWindowCounters
+	{
+		double BucketSeconds = 1.0;
+		int64 HeadBucket = 0;															// Absolute index of the newest bucket
+		int64 Counts[BucketsPerWindow][MetricCount] = {};
+		int64 Sums[MetricCount] = {};
+
+		void Advance(double Now);
+	};
+
+	typedef TArray<FWindowCounters, TInlineAllocator<3>> FChannelCounters;
+
+	FWindowCounters* FindWindow(const FString& Channel, int32 WindowIndex, double Now) const;
+
+	TArray<float> Windows;
+	mutable TMap<FString, FChannelCounters> Channels;	// Queries expire old buckets
+};
@@ -5,6 +5,8 @@
 #include "CoreMinimal.h"
 #include "Modules/ModuleManager.h"
 
+class FWebSocketsModule;
+
 class FTMIChatterModule : public IModuleInterface
 {
 public:
@@ -12,4 +14,10 @@ public:
 	/** IModuleInterface implementation */
 	virtual void StartupModule() override;
 	virtual void ShutdownModule() override;
+
+	// Loaded once at startup so creating a socket doesn't go through the module manager
+	static FWebSocketsModule& GetWebSockets();
+
+private:
+	static FWebSocketsModule* WebSocketsModule;
 };
@@ -0,0 +1,212 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TMIParser.h"
+#include "TMIIngress.h"
+#include "TMIOutboundQueue.h"
+#include "TMIJoinScheduler.h"
+#include "TMIReconnectPolicy.h"
+#include "TMIHealthMonitor.h"
+
+#include <atomic>
+
+// How the client reaches the world around it, whoever owns the connection fills these in
+struct FTMIClientHooks
+{
+	TFunction<void(const FString& Text)> SendText;				// CRLF terminated lines
+	TFunction<void(const uint8* Data, int32 Size)> SendUtf8;	// CRLF terminated lines, already UTF-8, PONGs are sent from whichever thread received the PING
+	TFunction<void()> Connect;
+	TFunction<void()> Close;
+	TFunction<void(const TArray<FString>& Channels)> ChannelsChanged;
+};
+
+// What the received lines mean, parsed and typed, fired on whichever thread drains the client
+struct FTMIClientEvents
+{
+	TFunction<void(const TMIParser::MessageBundle& Bundle, const FString& Line)> Received;	// Every line, before it's dispatched
+	TFunction<void(FGlobalUserStateMessage& Message)> Authenticated;
+	TFunction<void()> AuthFailed;
+	TFunction<void()> ReconnectRequested;
+	TFunction<void(const FString& Channel, double Latency)> Joined;	// Latency is negative for joins we didn't ask for
+	TFunction<void(const FString& Channel)> Parted;
+	TFunction<void(FPrivMsgMessage& Message)> ChatMessage;			// Our own echo and ignored logins are dropped
+	TFunction<void(FClearChatMessage& Message)> ClearChat;
+	TFunction<void(FClearMsgMessage& Message)> ClearMsg;
+	TFunction<void(FWhisperMessage& Message)> Whisper;
+	TFunction<void(FUserNoticeMessage& Message)> UserNotice;
+	TFunction<void(FNoticeMessage& Message)> Notice;					// Only once we're authenticated
+	TFunction<void(FRoomStateMessage& Message)> RoomState;			// Only with valid tags
+	TFunction<void(FUserStateMessage& Message)> UserState;			// Only with valid tags
+};
+
+// The engine independent core of a chat connection: credentials and joined channels, line framing, parsing and dispatch,
+// the send queues, paced joins, reconnect backoff and health probes
+// No UObjects and no ticker, the owner feeds it transport events, received frames and the time, so it runs the same
+// inside UTwitchChatter, a commandlet or a benchmark
+class FTMIClient
+{
+public:
+	FTMIClient();
+
+	void SetHooks(FTMIClientHooks InHooks);
+	void SetEvents(FTMIClientEvents InEvents);
+
+	// Connects, channels are joined once we're authenticated, the username is lower cased
+	void Start(const FString& Username, const FString& Password, const TArray<FString>& AutoJoinChannels, bool bAutoReconnect, bool bFastMode);
+
+	// Parts every channel, quits, closes and forgets the credentials
+	void Stop();
+
+	// Closes and connects again right away, the credentials, channels and queued chat are kept
+	void Reconnect(double Now);
+
+	// Transport events
+	void OnConnected(double Now);					// Sends the login
+	double OnConnectionLost(double Now);	// Returns the delay of the scheduled reconnect, negative if we stay disconnected
+
+	// Any thread, see FTMIIngress
+	void ReceiveFrame(const FString& Frame) { Ingress.ReceiveFrame(Frame); }
+	void ReceiveLine(FString&& Line) { Ingress.ReceiveLine(MoveTemp(Line)); }
+
+	// Dispatches every received line in arrival order, returns how many
+	int32 Drain(double Now);
+
+	// Applies whatever the line means for the connection and hands it to the events
+	void Dispatch(const FString& Line, double Now);
+	void Dispatch(TMIParser::MessageBundle& Bundle, const FString& Line, double Now);
+
+	// While a second connection delivers the same messages each one is only dispatched once
+	void SetDeduplicating(bool bDeduplicate);
+
+	// PRIVMSGs from these logins, and from our own, are dropped before they're parsed
+	void SetIgnoredLogins(const TSet<FString>& Logins);
+
+	// PRIVMSGs share their chatter records through the directory while it's enabled, it must outlive the client
+	void SetUserDirectory(FTMIUserDirectory* InDirectory) { UserDirectory = InDirectory; }
+
+	// Starts the health probes and joins the auto-join channels along with those we were in before reconnecting
+	void OnAuthenticated(double Now);
+
+	// Seconds since we asked to join, negative if we never did
+	double OnJoined(const FString& Channel, double Now) { return JoinScheduler.OnJoined(Channel, Now); }
+	void OnPong(const FString& Nonce, double Now) { Health.OnPong(Nonce, Now); }
+
+	// Returns false if we aren't connected or already in the channel
+	bool JoinChannel(const FString& Channel, double Now);
+
+	// Pumped once so the channels share JOIN lines
+	void JoinChannels(const TArray<FString>& Channels, double Now);
+
+	// Leaves the channel for good, it isn't joined again after a reconnect
+	bool PartChannel(const FString& Channel);
+
+	// Joins that were requested elsewhere, the channels are already ours. Their confirmations, and those of Unconfirmed
+	// JOINs already sent for channels of ours, don't report the channels as joined a second time
+	void RequeueJoins(const TArray<FString>& Channels, const TArray<FString>& Unconfirmed, double Now);
+
+	// Return false when the message was too long and its end was dropped, see FTMIOutboundQueue
+	bool Send(const FString& Channel, const FString& Message, double Now);
+	bool Broadcast(const FString& Message, double Now);
+	bool BroadcastTo(const TArray<FString>& ToChannels, const FString& Message, double Now);
+	void SendControl(const FString& Line, double Now);	// Ahead of any queued chat, never rate limited
+
+	// Moderators skip the chat limits, SlowModeSeconds paces our own messages, see FTMIOutboundQueue
+	void SetChannelLimits(const FString& Channel, bool bModerator, int32 SlowModeSeconds) { OutboundQueue.SetChannelLimits(Channel, bModerator, SlowModeSeconds); }
+
+	// Sends what the rate limits allow, probes the connection and makes due reconnect attempts
+	// Returns false when a stalled connection had to be reconnected
+	bool Tick(double Now);
+
+	// Sends what the rate limits allow right now
+	void Pump(double Now);
+
+	// Whether Tick has anything to do
+	bool NeedsTick() const;
+
+	void SetHealthThresholds(float ProbeInterval, float ProbeTimeout, float StaleSeconds);
+	void StartHealthMonitor(double Now);
+	void SetReconnectDelays(double BaseDelay, double MaxDelay) { ReconnectPolicy.SetDelays(BaseDelay, MaxDelay); }
+
+	// The join and chat limits are per account, clients logged in as the same user share one set of buckets
+	void ShareRateLimits(const FTMIClient& Other);
+	void ShareJoinBucket(const TSharedRef<FTMITokenBucket>& Bucket) { JoinScheduler.ShareBucket(Bucket); }
+	TSharedRef<FTMITokenBucket> GetJoinBucket() const { return JoinScheduler.GetBucket(); }
+
+	// CAP, PASS and NICK, without CRLF
+	void GetLoginLines(TArray<FString>& OutLines) const;
+
+	const FString& GetUsername() const { return Username; }
+	const TArray<FString>& GetChannels() const { return Channels; }
+	bool IsConnected() const { return bConnected; }
+	bool IsAuthenticated() const { return bAuthenticated; }
+	bool IsStarted() const { return bStayConnected; }
+
+	FTWJoinProgress GetJoinProgress() const { return JoinScheduler.GetProgress(); }
+	FTWOutboundStats GetOutboundStats(double Now) const { return OutboundQueue.GetStats(Now); }
+	FTWReconnectStats GetReconnectStats(double Now) const { return ReconnectPolicy.GetStats(Now); }
+	FTWConnectionHealth GetHealth(double Now) const { return Health.GetHealth(Now); }
+	bool IsHealthRunning() const { return Health.IsRunning(); }
+
+private:
+	// Per command handlers, routed through a table indexed by EIRCCommand
+	typedef void (FTMIClient::*FMessageHandler)(TMIParser::MessageBundle& Bundle, double Now);
+	static const FMessageHandler* GetMessageHandlers();
+
+	void HandlePrivMsg(TMIParser::MessageBundle& Bundle, double Now);
+	void HandleClearChat(TMIParser::MessageBundle& Bundle, double Now);
+	void HandleClearMsg(TMIParser::MessageBundle& Bundle, double Now);
+	void HandleWhisper(TMIParser::MessageBundle& Bundle, double Now);
+	void HandleUserNotice(TMIParser::MessageBundle& Bundle, double Now);
+	void HandleNotice(TMIParser::MessageBundle& Bundle, double Now);
+	void HandlePing(TMIParser::MessageBundle& Bundle, double Now);
+	void HandlePong(TMIParser::MessageBundle& Bundle, double Now);
+	void HandleReconnect(TMIParser::MessageBundle& Bundle, double Now);
+	void HandleJoin(TMIParser::MessageBundle& Bundle, double Now);
+	void HandlePart(TMIParser::MessageBundle& Bundle, double Now);
+	void HandleGlobalUserState(TMIParser::MessageBundle& Bundle, double Now);
+	void HandleRoomState(TMIParser::MessageBundle& Bundle, double Now);
+	void HandleUserState(TMIParser::MessageBundle& Bundle, double Now);
+
+	bool IsDuplicate(const TMIParser::MessageBundle& Bundle, const FString& Line);
+	void RebuildIgnoredSources();
+
+	void CloseTransport();
+	bool RequestJoin(const FString& Channel, double Now);
+	void PumpJoins(double Now);
+	void PumpOutbound(double Now);
+	void PumpControl();
+	void NotifyChannels();
+
+	FTMIClientHooks Hooks;
+	FTMIClientEvents Events;
+
+	FString Username;
+	FString Password;
+	TArray<FString> AutoJoinChannels;
+	TArray<FString> Channels;			// Asked to join on this connection
+	TArray<FString> RejoinChannels;	// Were in before the connection dropped
+	TSet<FString> QuietJoins;			// Joined again behind the scenes, their confirmations aren't reported
+
+	TSet<FString> IgnoredLogins;
+	TSet<FString> IgnoredSources;	// Our own login plus IgnoredLogins, checked with a single lookup per PRIVMSG
+	FTMIUserDirectory* UserDirectory = nullptr;
+
+	bool bDeduplicating = false;
+	TSet<FString> DeliveredIDs;		// Message IDs dispatched while deduplicating
+
+	bool bFastMode = false;
+	bool bReconnect = false;
+	bool bStayConnected = false;	// Between Start and Stop
+	std::atomic<bool> bConnected{ false };	// Read by the receiving thread when it answers a PING
+	bool bAuthenticated = false;
+
+	float HealthProbeInterval = 30.f;
+	float HealthProbeTimeout = 10.f;
+	float StaleConnectionSeconds = 90.f;
+
+	FTMIIngress Ingress;
+	FTMIOutboundQueue OutboundQueue;
+	FTMIJoinScheduler JoinScheduler;
+	FTMIReconnectPolicy ReconnectPolicy;
+	FTMIHealthMonitor Health;
+};
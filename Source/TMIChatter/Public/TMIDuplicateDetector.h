@@ -0,0 +1,52 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Groups near identical chat lines (copypasta) per channel within a time window
+// Messages are normalized (case, whitespace and punctuation ignored), shingled with a rolling hash and reduced
+// to a 64 bit SimHash. Fingerprints within MaxDistance bits of each other share a cluster, candidates are found
+// through four 16 bit bands of which at least one has to match exactly for any distance below 4
+class FTMIDuplicateDetector
+{
+public:
+	static constexpr int32 ShingleLength = 4;
+	static constexpr int32 MaxDistance = 3;
+	static constexpr int32 MaxClustersPerChannel = 2048;
+
+	void SetWindow(float WindowSeconds);
+	float GetWindow() const { return WindowSeconds; }
+
+	// Returns false for messages without any text to fingerprint, otherwise the message's cluster
+	// and how many messages the cluster saw within the window, this one included
+	bool Observe(const FString& Channel, const FString& Text, double Now, int32& OutClusterID, int32& OutCount);
+
+	static uint64 Fingerprint(const FString& Text, bool& bOutHasText);
+
+	void Remove(const FString& Channel);
+	void Reset();
+
+private:
+	static constexpr int32 BandCount = 4;
+
+	struct FCluster
+	{
+		uint64 Fingerprint = 0;
+		int32 Count = 0;
+		double LastSeen = 0.0;
+	};
+
+	struct FChannelClusters
+	{
+		TMap<int32, FCluster> Clusters;
+		TMultiMap<uint32, int32> Bands;		// Band index and bits to cluster IDs
+		double NextSweep = 0.0;
+	};
+
+	static uint32 GetBandKey(uint64 Print, int32 Band);
+	static void RemoveCluster(FChannelClusters& Channel, int32 ClusterID);
+	void Sweep(FChannelClusters& Channel, double Now) const;
+
+	float WindowSeconds = 30.f;
+	int32 NextClusterID = 0;
+	TMap<FString, FChannelClusters> Channels;
+};
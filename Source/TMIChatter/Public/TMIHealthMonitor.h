@@ -0,0 +1,88 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "TMIHealthMonitor.generated.h"
+
+USTRUCT(BlueprintType)
+struct FTWConnectionHealth
+{
+	GENERATED_USTRUCT_BODY();
+
+	UPROPERTY(BlueprintReadOnly)
+		float LastRoundTripSeconds = -1.f;		// Negative until a probe came back
+
+	UPROPERTY(BlueprintReadOnly)
+		float AverageRoundTripSeconds = 0.f;
+
+	UPROPERTY(BlueprintReadOnly)
+		float MedianRoundTripSeconds = 0.f;		// Upper bound of the histogram bucket, like the percentiles below
+
+	UPROPERTY(BlueprintReadOnly)
+		float P95RoundTripSeconds = 0.f;
+
+	UPROPERTY(BlueprintReadOnly)
+		float MaxRoundTripSeconds = 0.f;
+
+	UPROPERTY(BlueprintReadOnly)
+		float SecondsSinceLastReceive = 0.f;
+
+	UPROPERTY(BlueprintReadOnly)
+		int32 ProbesSent = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+		int32 ProbesLost = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+		TArray<int32> RoundTripHistogram;			// Bucket i counts round trips up to 2^i milliseconds, the last one the rest
+};
+
+// Sends our own PING with a nonce every probe interval and times the PONG, and watches how long ago anything arrived
+// The connection counts as dead when a probe goes unanswered for the probe timeout, or nothing at all was received
+// for the stale time, a quiet chat still gets our PONGs so that only happens to stalled connections
+class FTMIHealthMonitor
+{
+public:
+	static constexpr int32 NumBuckets = 16;
+
+	void SetThresholds(double InProbeInterval, double InProbeTimeout, double InStaleAfter);
+
+	// Stats are kept across connections, only the probe in flight is forgotten
+	void Start(double Now);
+	void Stop();
+	bool IsRunning() const { return bRunning; }
+
+	void OnReceive(double Now) { LastReceive = Now; }
+
+	// Returns false if the nonce isn't the one of our probe in flight
+	bool OnPong(const FString& Nonce, double Now);
+
+	// Sends a probe when one is due, returns false once the connection looks dead
+	bool Tick(double Now, TFunctionRef<void(const FString& Nonce)> SendProbe);
+
+	FTWConnectionHealth GetHealth(double Now) const;
+
+	static double GetBucketUpperBound(int32 Bucket);	// Seconds
+
+private:
+	double GetPercentile(double Fraction) const;
+
+	double ProbeInterval = 30.0;
+	double ProbeTimeout = 10.0;
+	double StaleAfter = 90.0;
+
+	bool bRunning = false;
+	double LastReceive = 0.0;
+	double NextProbeAt = 0.0;
+	double ProbeSentAt = 0.0;
+	FString ProbeNonce;			// Empty while no probe is in flight
+	uint32 NonceCounter = 0;
+
+	int32 Histogram[NumBuckets] = {};
+	int32 ProbesSent = 0;
+	int32 ProbesAnswered = 0;
+	int32 ProbesLost = 0;
+	double LastRoundTrip = -1.0;
+	double TotalRoundTrip = 0.0;
+	double MaxRoundTrip = 0.0;
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "TMIHeavyHitters.generated.h"
+
+struct FPrivMsgMessage;
+
+USTRUCT(BlueprintType)
+struct FTWHeavyHitter
+{
+	GENERATED_USTRUCT_BODY();
+
+	UPROPERTY(BlueprintReadOnly)
+		FString Key;
+
+	UPROPERTY(BlueprintReadOnly)
+		int64 Count = 0;	// Never below the true count
+
+	UPROPERTY(BlueprintReadOnly)
+		int64 Error = 0;	// The true count is at least Count - Error
+};
+
+// Space-Saving top-K counter over a stream of keys
+// Counters are kept in a stream summary, a list of buckets of equal count in ascending order, so an increment
+// moves a counter to the neighbouring bucket and evicting the minimum is O(1). Memory is bounded by the capacity
+class FTMIHeavyHitters
+{
+public:
+	explicit FTMIHeavyHitters(int32 Capacity = 100);
+
+	void Add(const FString& Key);
+
+	// Highest counts first
+	void GetTop(int32 Count, TArray<FTWHeavyHitter>& OutTop) const;
+
+	// Keys seen so far, any key seen more than Total / Capacity times is guaranteed to be tracked
+	int64 GetTotal() const { return Total; }
+	int32 GetCapacity() const { return Capacity; }
+
+	void Reset();
+
+private:
+	struct FCounter
+	{
+		FString Key;
+		int64 Error = 0;
+		int32 Bucket = INDEX_NONE;
+		int32 Prev = INDEX_NONE;
+		int32 Next = INDEX_NONE;
+	};
+
+	struct FBucket
+	{
+		int64 Count = 0;
+		int32 Head = INDEX_NONE;	// First counter
+		int32 Prev = INDEX_NONE;	// Lower count
+		int32 Next = INDEX_NONE;	// Higher count
+	};
+
+	void Increment(int32 CounterIndex);
+	void Unlink(int32 CounterIndex);
+	void Link(int32 CounterIndex, int32 BucketIndex);
+	int32 AllocBucket(int64 Count, int32 Prev, int32 Next);
+	void FreeBucket(int32 BucketIndex);
+
+	int32 Capacity;
+	int64 Total = 0;
+	TArray<FCounter> Counters;
+	TArray<FBucket> Buckets;
+	TArray<int32> FreeBuckets;
+	TMap<FString, int32> Index;
+	int32 MinBucket = INDEX_NONE;
+	int32 MaxBucket = INDEX_NONE;
+};
+
+// Top emotes and words per channel
+class FTMIChannelTrends
+{
+public:
+	// Counters per list per channel, 0 disables tracking
+	void SetCapacity(int32 Capacity);
+	bool IsEnabled() const { return Capacity > 0; }
+
+	void Add(const FPrivMsgMessage& Message);
+
+	void GetTopEmotes(const FString& Channel, int32 Count, TArray<FTWHeavyHitter>& OutTop) const;
+	void GetTopWords(const FString& Channel, int32 Count, TArray<FTWHeavyHitter>& OutTop) const;
+
+	void Remove(const FString& Channel);
+	void Reset();
+
+private:
+	struct FTrends
+	{
+		FTrends(int32 Capacity) : Emotes(Capacity), Words(Capacity) {}
+
+		FTMIHeavyHitters Emotes;
+		FTMIHeavyHitters Words;
+	};
+
+	int32 Capacity = 0;
+	TMap<FString, FTrends> Channels;
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+
+#include <atomic>
+
+// First stop for received lines, safe to feed from whichever thread a transport receives on
+// Server PINGs are answered on the spot through the pong sender so a hitching game thread can't get us dropped,
+// every other line is queued in arrival order until the game thread drains it
+class FTMIIngress
+{
+public:
+	// Called on the receiving thread with the complete PONG line, without CRLF
+	// Set it before anything is received, it isn't guarded against changing while a receive is running
+	void SetPongSender(TFunction<void(const FString& Line)> InSendPong) { SendPong = MoveTemp(InSendPong); }
+
+	// Frames may hold several CRLF separated lines
+	void ReceiveFrame(const FString& Frame);
+	void ReceiveLine(FString&& Line);
+
+	// Game thread only, returns how many lines went to Dispatch
+	int32 Drain(TFunctionRef<void(const FString& Line)> Dispatch);
+
+	// Whether anything, PINGs included, arrived since the last call
+	bool TakeReceived() { return bReceived.exchange(false, std::memory_order_relaxed); }
+
+	bool HasQueued() const { return !Lines.IsEmpty(); }
+	int64 GetPingsAnswered() const { return PingsAnswered.load(std::memory_order_relaxed); }
+
+	// Game thread only, drops queued lines
+	void Reset();
+
+private:
+	TQueue<FString, EQueueMode::Mpsc> Lines;
+	TFunction<void(const FString& Line)> SendPong;
+	std::atomic<int64> PingsAnswered{ 0 };
+	std::atomic<bool> bReceived{ false };
+};
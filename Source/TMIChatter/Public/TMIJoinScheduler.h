@@ -0,0 +1,80 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TMIOutboundQueue.h"
+
+#include "TMIJoinScheduler.generated.h"
+
+USTRUCT(BlueprintType)
+struct FTWJoinProgress
+{
+	GENERATED_USTRUCT_BODY();
+
+	UPROPERTY(BlueprintReadOnly)
+		int32 Requested = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+		int32 Sent = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+		int32 Joined = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+		int32 Pending = 0;		// Not sent yet, waiting for the join rate limit
+
+	UPROPERTY(BlueprintReadOnly)
+		float AverageLatencySeconds = 0.f;	// From the request to Twitch confirming the join
+
+	UPROPERTY(BlueprintReadOnly)
+		float MaxLatencySeconds = 0.f;
+};
+
+// Paces JOINs under Twitch's limit of 20 channels per 10 seconds
+// Channels are sent as comma separated JOIN #a,#b,#c lines that stay within the IRC line length,
+// every channel of a line counts against the limit
+class FTMIJoinScheduler
+{
+public:
+	static constexpr double JoinLimit = 20.0;
+	static constexpr double JoinPeriod = 10.0;
+	static constexpr int32 MaxLineLength = 510;		// 512 with the CRLF
+
+	FTMIJoinScheduler();
+
+	// Returns false if the channel is already waiting or joining
+	bool Request(const FString& Channel, double Now);
+	void Cancel(const FString& Channel);
+
+	// Hands over the channels not sent yet, as if they were never requested
+	void TakePending(TArray<FString>& OutChannels);
+
+	// Channels requested and not confirmed yet, sent or not
+	void GetUnconfirmed(TArray<FString>& OutChannels) const { RequestedAt.GetKeys(OutChannels); }
+
+	// Hands every JOIN line the rate limit allows right now to Emit, without CRLF
+	void Pump(double Now, TFunctionRef<void(const FString& Line)> Emit);
+
+	// Returns the seconds since the channel was requested, negative if we never asked to join it
+	double OnJoined(const FString& Channel, double Now);
+
+	// The join limit is per account, schedulers of connections logged in as the same user share one bucket
+	void ShareBucket(const TSharedRef<FTMITokenBucket>& Bucket) { JoinBucket = Bucket; }
+	TSharedRef<FTMITokenBucket> GetBucket() const { return JoinBucket; }
+
+	bool HasPending() const { return Pending.Num() > 0; }
+	FTWJoinProgress GetProgress() const;
+
+	// Forgets every request, counters included
+	void Reset();
+
+private:
+	TSharedRef<FTMITokenBucket> JoinBucket;
+	TArray<FString> Pending;						// In request order
+	TMap<FString, double> RequestedAt;	// Pending and sent but not confirmed
+
+	int32 Requested = 0;
+	int32 Sent = 0;
+	int32 Joined = 0;
+	double TotalLatency = 0.0;
+	double MaxLatency = 0.0;
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "TMIKeywordMatcher.generated.h"
+
+USTRUCT(BlueprintType)
+struct FTWKeywordMatch
+{
+	GENERATED_USTRUCT_BODY();
+
+	FTWKeywordMatch() {}
+	FTWKeywordMatch(int32 PatternID, int32 Start, int32 Length)
+		: PatternID(PatternID), Start(Start), Length(Length)
+	{}
+
+	UPROPERTY(BlueprintReadOnly)
+		int32 PatternID = INDEX_NONE;	// Index of the pattern in the array it was compiled from
+
+	UPROPERTY(BlueprintReadOnly)
+		int32 Start = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+		int32 Length = 0;
+};
+
+// Matches a whole set of keywords in a single pass over the text with an Aho-Corasick automaton
+// The compiled automaton is immutable, SetPatterns builds a new one and swaps it in so scans never wait on a compile
+class FTMIKeywordMatcher
+{
+public:
+	// Empty patterns are ignored but keep their ID
+	void SetPatterns(const TArray<FString>& Patterns, bool bCaseInsensitive);
+	void Reset();
+
+	bool IsEmpty() const;
+
+	// Appends every occurrence, overlapping ones included, ordered by where they end. Returns whether anything matched
+	bool Scan(const FString& Text, TArray<FTWKeywordMatch>& OutMatches) const;
+
+private:
+	struct FAutomaton
+	{
+		bool bCaseInsensitive = false;
+		int32 NumSymbols = 1;						// Symbol 0 is every character not used by any pattern
+		int32 AsciiSymbols[128];
+		TMap<TCHAR, int32> Symbols;			// Non ASCII characters
+		TArray<int32> Transitions;			// NumStates * NumSymbols, failure links already folded in
+		TArray<int32> OutputStart;			// Per state range into Outputs, NumStates + 1 entries
+		TArray<int32> Outputs;					// Pattern IDs, including those reached through failure links
+		TArray<int32> PatternLengths;
+
+		int32 GetSymbol(TCHAR Char) const;
+	};
+
+	typedef TSharedPtr<const FAutomaton, ESPMode::ThreadSafe> FAutomatonPtr;
+
+	static FAutomatonPtr Compile(const TArray<FString>& Patterns, bool bCaseInsensitive);
+	FAutomatonPtr GetAutomaton() const;
+
+	mutable FCriticalSection AutomatonLock;	// Only held to copy or swap the pointer
+	FAutomatonPtr Automaton;
+};
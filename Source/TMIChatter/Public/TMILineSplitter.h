@@ -0,0 +1,31 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Cuts IRC lines straight out of a receive buffer, no string for the whole read
+// Reads go into GetWritable, Commit hands out every complete line and keeps the partial one for the next read
+class FTMILineSplitter
+{
+public:
+	explicit FTMILineSplitter(int32 InMaxLineBytes = 16 * 1024, int32 InInitialBytes = 4096);
+
+	// Where the next read goes, grown while a single line doesn't fit
+	// Null when one line, tags included, is longer than the maximum
+	uint8* GetWritable(int32& OutSize);
+
+	// Size more bytes were read into GetWritable, lines are handed out without CR or LF, empty ones are skipped
+	void Commit(int32 Size, TFunctionRef<void(FString&& Line)> OnLine);
+
+	// Drops the partial line, for a new connection
+	void Reset();
+
+	int32 GetPending() const { return Used; }
+
+private:
+	const int32 MaxLineBytes;
+	const int32 InitialBytes;
+
+	TArray<uint8> Buffer;
+	int32 Used = 0;
+	int32 Scanned = 0;	// Bytes of Buffer known to hold no line end
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TMITransport.h"
+
+// In process transport for tests and tools: every event is delivered synchronously on the calling thread,
+// sent lines are kept and the "server" side is whatever calls Receive
+class FTMILoopbackTransport : public ITMITransport
+{
+public:
+	virtual void SetEvents(FTMITransportEvents InEvents) override { Events = MoveTemp(InEvents); }
+
+	// Connects right away unless bHoldConnect is set, see Accept
+	virtual void Connect() override;
+	virtual void Close() override;
+	virtual bool IsConnected() const override { return bConnected; }
+
+	virtual void Send(const FString& Text) override;
+	virtual void Send(const uint8* Data, int32 Size) override;
+
+	// Server side
+	void Accept();
+	void Receive(const FString& Line);
+	void Fail(const FString& Error);
+	void Drop(const FString& Reason = TEXT("Dropped"));
+
+	// Every line we sent, without CRLF, oldest first
+	TArray<FString> Sent;
+
+	// Called for every sent line, a test can answer from here
+	TFunction<void(const FString& Line)> OnSent;
+
+	bool bHoldConnect = false;
+	int32 Connects = 0;
+
+private:
+	FTMITransportEvents Events;
+	bool bConnected = false;
+};
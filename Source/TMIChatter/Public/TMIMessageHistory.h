@@ -0,0 +1,69 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TMIParser.h"
+
+#include "TMIMessageHistory.generated.h"
+
+UENUM(BlueprintType)
+enum class ETWHistoryChange : uint8
+{
+	MessageDeleted,		// A single message was removed by CLEARMSG
+	UserPurged,				// Every message of a user was removed by a CLEARCHAT timeout or ban
+	Cleared						// The whole chat was cleared
+};
+
+// Fixed capacity scrollback of PRIVMSGs per channel
+// Messages are indexed by ID and chained per user-id so CLEARMSG is O(1) and a user purge O(messages of that user)
+class FTMIMessageHistory
+{
+public:
+	// Capacity used by channels without their own, 0 disables history for them
+	void SetDefaultCapacity(int32 Capacity);
+	int32 GetDefaultCapacity() const { return DefaultCapacity; }
+
+	// Resizing keeps the newest messages that still fit
+	void SetChannelCapacity(const FString& Channel, int32 Capacity);
+	int32 GetChannelCapacity(const FString& Channel) const;
+
+	void Add(const FPrivMsgMessage& Message);
+
+	// All return whether anything was removed, with the IDs of removed messages appended to OutRemovedIDs
+	bool RemoveMessage(const FString& Channel, const FGuid& MessageID, TArray<FGuid>& OutRemovedIDs);
+	bool RemoveUser(const FString& Channel, const FString& UserID, TArray<FGuid>& OutRemovedIDs);
+	bool ClearChannel(const FString& Channel, TArray<FGuid>& OutRemovedIDs);
+
+	const FPrivMsgMessage* Find(const FString& Channel, const FGuid& MessageID) const;
+
+	// Live messages of a channel, oldest first
+	void GetMessages(const FString& Channel, TArray<FPrivMsgMessage>& OutMessages) const;
+
+	// Forgets the messages and every capacity, history is disabled until a capacity is set again
+	void Reset();
+
+private:
+	struct FSlot
+	{
+		FPrivMsgMessage Message;
+		int32 OlderByUser = INDEX_NONE;
+		int32 NewerByUser = INDEX_NONE;
+		bool bLive = false;
+	};
+
+	struct FChannelHistory
+	{
+		TArray<FSlot> Slots;
+		int32 Next = 0;								// Slot the next message is written to, also the oldest slot once full
+		TMap<FGuid, int32> ByID;
+		TMap<FString, int32> NewestByUser;	// user-id to the head of that user's chain
+	};
+
+	FChannelHistory* FindOrAddHistory(const FString& Channel);
+	static void Insert(FChannelHistory& History, const FPrivMsgMessage& Message);
+	static void Resize(FChannelHistory& History, int32 Capacity);
+	static void Unlink(FChannelHistory& History, int32 SlotIndex);
+
+	TMap<FString, FChannelHistory> Channels;
+	TMap<FString, int32> ChannelCapacities;
+	int32 DefaultCapacity = 0;
+};
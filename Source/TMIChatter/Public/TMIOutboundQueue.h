@@ -0,0 +1,187 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+
+#include <atomic>
+
+#include "TMIOutboundQueue.generated.h"
+
+USTRUCT(BlueprintType)
+struct FTWOutboundStats
+{
+	GENERATED_USTRUCT_BODY();
+
+	UPROPERTY(BlueprintReadOnly)
+		int32 QueueDepth = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+		int64 LinesSent = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+		int64 FramesSent = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+		float OldestWaitSeconds = 0.f;		// How long the oldest queued line has been waiting
+
+	UPROPERTY(BlueprintReadOnly)
+		float AverageWaitSeconds = 0.f;	// Of every line sent so far
+
+	UPROPERTY(BlueprintReadOnly)
+		float MaxWaitSeconds = 0.f;
+};
+
+// Outbound lines by priority, every pump sends a lane before looking at the next one
+enum class ETWOutboundLane : uint8
+{
+	Control,		// PONG, CAP, PASS/NICK: no rate limits, always first
+	Moderation,		// Chat commands like /ban or /timeout, ahead of regular chat
+	Chat,
+};
+
+// Continuously refilling token bucket
+struct FTMITokenBucket
+{
+	FTMITokenBucket() {}
+	FTMITokenBucket(double Capacity, double PeriodSeconds)
+		: Capacity(Capacity), RefillPerSecond(Capacity / PeriodSeconds), Tokens(Capacity)
+	{}
+
+	bool HasToken(double Now, double Count = 1.0);
+	void Consume(double Count = 1.0) { Tokens -= Count; }
+	void Reset() { Tokens = Capacity; LastRefill = 0.0; }
+
+	double Capacity = 1.0;
+	double RefillPerSecond = 1.0;
+	double Tokens = 1.0;
+	double LastRefill = 0.0;
+};
+
+// Chat lines waiting for Twitch's rate limits
+// Every line spends a token of the connection bucket (100 per 30s), lines to channels where we aren't a moderator
+// or the broadcaster also spend one of the user bucket (20 per 30s) and are paced per channel by slow mode,
+// or one message a second without it. Channels are served round robin so one busy channel can't starve the others,
+// and everything that can go out in one pump is sent as a single frame
+// Messages are kept UTF-8 encoded and each channel caches its encoded "PRIVMSG #channel :" prefix, a pump only
+// copies bytes into a reused send buffer
+// Messages over Twitch's 500 character limit are split, preferably at whitespace and never inside a character,
+// and the parts go out as a group: its rate tokens are taken at once, then the parts follow each other without pacing
+// and no other line of the channel, from either lane, comes between. A group the buckets can't afford yet holds its
+// tokens: other lines only spend what it leaves, so a steady trickle of single lines can't keep it waiting forever
+// The control lane may be fed and flushed from any thread, a receive thread answers PINGs through it, the rest
+// belongs to the thread pumping the queue. Emit is never called from two threads at once
+class FTMIOutboundQueue
+{
+public:
+	static constexpr double LimitPeriod = 30.0;
+	static constexpr double UserLimit = 20.0;
+	static constexpr double ModeratorLimit = 100.0;
+	static constexpr double ChannelInterval = 1.0;
+	static constexpr int32 MaxFrameLength = 8192;		// Bytes
+	static constexpr int32 MaxMessageLength = 500;		// UTF-16 code units, never more characters than Twitch allows
+	static constexpr int32 MaxMessageParts = 20;		// Has to fit the user bucket, anything past this is dropped and reported
+
+	FTMIOutboundQueue();
+
+	// Queues a PRIVMSG, the channel's case doesn't matter. Long messages are split into a group of lines
+	// Returns false when the message needed more than MaxMessageParts and its end was dropped
+	bool Enqueue(const FString& Channel, const FString& Message, double Now);
+
+	// Queues the same PRIVMSG to every channel, the message is only encoded (and split) once. Returns like Enqueue
+	bool EnqueueBroadcast(const TArray<FString>& ToChannels, const FString& Message, double Now);
+
+	// Queues a raw IRC line that goes out with the next pump, ahead of everything and regardless of rate limits
+	// Any thread
+	void EnqueueControl(const FString& Line);
+
+	// Hands the queued control lines, and nothing else, to Emit as one frame. Any thread
+	void PumpControl(TFunctionRef<void(const uint8* Data, int32 Size)> Emit);
+
+	// Whether a PRIVMSG is a moderation chat command and takes the moderation lane
+	static bool IsModerationCommand(const FString& Message);
+
+	void SetChannelLimits(const FString& Channel, bool bModerator, int32 SlowModeSeconds);
+
+	// Hands every line the limits allow right now to Emit, CRLF terminated and packed into as few frames as possible
+	void Pump(double Now, TFunctionRef<void(const uint8* Data, int32 Size)> Emit);
+
+	// Cuts Message into parts of at most MaxMessageLength, whitespace between parts is dropped
+	// Returns false when MaxMessageParts weren't enough, the parts then hold the start of the message
+	static bool Split(const FString& Message, TArray<FString>& OutParts);
+
+	// Both limits are per account, queues of connections logged in as the same user share the buckets
+	void ShareBuckets(const TSharedRef<FTMITokenBucket>& Connection, const TSharedRef<FTMITokenBucket>& User) { ConnectionBucket = Connection; UserBucket = User; }
+	TSharedRef<FTMITokenBucket> GetConnectionBucket() const { return ConnectionBucket; }
+	TSharedRef<FTMITokenBucket> GetUserBucket() const { return UserBucket; }
+
+	bool IsEmpty() const;
+	FTWOutboundStats GetStats(double Now) const;
+
+	// Drops queued lines and what we know about channels, the rate buckets are kept since Twitch remembers them too
+	void Reset();
+
+	// Drops the control lines only, they belong to the connection they were queued for
+	void ResetControl();
+
+private:
+	typedef TArray<UTF8CHAR> FEncodedText;
+
+	struct FQueuedLine
+	{
+		TSharedRef<const FEncodedText> Payload;	// Shared by every channel of a broadcast
+		double EnqueuedAt = 0.0;
+		int32 GroupSize = 1;						// Lines in the group this line starts, 0 for the rest of a group
+	};
+
+	struct FLaneQueue
+	{
+		TArray<FQueuedLine> Lines;
+		int32 Head = 0;								// Lines before Head were sent
+		int32 Reserved = 0;							// Lines of the current group whose tokens were already taken
+
+		bool IsEmpty() const { return Head >= Lines.Num(); }
+		FQueuedLine PopFront();
+	};
+
+	static constexpr int32 NumChannelLanes = 2;		// Moderation and chat, control lines have no channel
+
+	struct FChannelQueue
+	{
+		FEncodedText Prefix;
+		FLaneQueue Lanes[NumChannelLanes];
+		bool bModerator = false;
+		int32 SlowModeSeconds = 0;
+		double NextAllowed = 0.0;
+
+		bool IsEmpty() const { return Lanes[0].IsEmpty() && Lanes[1].IsEmpty(); }
+		bool IsInGroup() const { return Lanes[0].Reserved > 0 || Lanes[1].Reserved > 0; }
+		FLaneQueue& GetLane(ETWOutboundLane Lane) { return Lanes[static_cast<int32>(Lane) - 1]; }
+	};
+
+	static void Encode(const FString& Text, FEncodedText& Out);
+	FChannelQueue& FindOrAddChannel(const FString& Channel);
+	static bool EncodeParts(const FString& Message, TArray<TSharedRef<const FEncodedText>>& OutPayloads);
+	void Push(const FString& Channel, ETWOutboundLane Lane, const TSharedRef<const FEncodedText>& Payload, double Now, int32 GroupSize = 1);
+	void PushGroup(const FString& Channel, ETWOutboundLane Lane, const TArray<TSharedRef<const FEncodedText>>& Payloads, double Now);
+	void PumpLane(ETWOutboundLane Lane, double Now, TFunctionRef<void(const uint8* Data, int32 Size)> Emit);
+	void MakeRoom(int32 LineSize, TFunctionRef<void(const uint8* Data, int32 Size)> Emit);
+
+	TSharedRef<FTMITokenBucket> ConnectionBucket;
+	TSharedRef<FTMITokenBucket> UserBucket;
+	TMap<FString, FChannelQueue> Channels;
+	TArray<FString> ActiveChannels;		// Channels with queued lines, in round robin order
+	FString HeldFor;					// Channel of the first group that couldn't be afforded, empty when none waits
+	ETWOutboundLane HeldLane = ETWOutboundLane::Chat;
+	double HeldConnection = 0.0;		// Tokens kept for it in each bucket
+	double HeldUser = 0.0;
+	mutable FCriticalSection ControlLock;	// Also held around every Emit
+	TArray<uint8> ControlBuffer;		// Encoded and CRLF terminated control lines, guarded by ControlLock
+	TArray<uint8> SendBuffer;
+	int32 RoundRobin = 0;
+	int32 QueuedLines = 0;
+
+	int64 LinesSent = 0;
+	std::atomic<int64> FramesSent{ 0 };	// Control frames may go out on another thread
+	double TotalWait = 0.0;
+	double MaxWait = 0.0;
+};
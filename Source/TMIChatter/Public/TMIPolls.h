@@ -0,0 +1,108 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "TMIPolls.generated.h"
+
+struct FPrivMsgMessage;
+
+USTRUCT(BlueprintType)
+struct FTWPollSettings
+{
+	GENERATED_USTRUCT_BODY();
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+		FString Command = TEXT("vote");		// Without the command prefix
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+		TArray<FString> Options;				// Voted for by 1 based number or by name, case insensitive
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+		bool bWeightByBits = false;			// A vote weighs 1 plus every bit the user cheered with their votes
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+		float SnapshotInterval = 1.f;		// Seconds between update events while votes are coming in
+};
+
+USTRUCT(BlueprintType)
+struct FTWPollSnapshot
+{
+	GENERATED_USTRUCT_BODY();
+
+	UPROPERTY(BlueprintReadOnly)
+		int32 PollID = INDEX_NONE;
+
+	UPROPERTY(BlueprintReadOnly)
+		FString Channel;
+
+	UPROPERTY(BlueprintReadOnly)
+		TArray<int32> Voters;			// Per option
+
+	UPROPERTY(BlueprintReadOnly)
+		TArray<int64> Weights;		// Per option, equals Voters unless weighted by bits
+
+	UPROPERTY(BlueprintReadOnly)
+		int32 TotalVoters = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+		int64 TotalVotesCast = 0;	// Including changed votes
+
+	UPROPERTY(BlueprintReadOnly)
+		bool bClosed = false;
+};
+
+// Tallies chat votes straight from the command path
+// Every user-id has one vote, voting again moves it (last wins). Per vote work is a couple of hash lookups
+// and counter updates, listeners only see periodic snapshots of polls that changed
+class FTMIPollEngine
+{
+public:
+	// Returns the new poll's ID, or INDEX_NONE without options. Replaces a running poll with the same channel and command
+	int32 StartPoll(const FString& Channel, const FTWPollSettings& Settings, double Now);
+
+	// Closes the poll, OutSnapshot holds the final tally
+	bool EndPoll(int32 PollID, FTWPollSnapshot& OutSnapshot);
+
+	// Returns true if the command was a vote for a running poll, including votes for options that don't exist
+	bool HandleCommand(const FPrivMsgMessage& Message, const FString& Command, const FString& Params);
+
+	// Snapshots every poll that changed since its last one and is due
+	void Tick(double Now, TFunctionRef<void(const FTWPollSnapshot&)> OnSnapshot);
+
+	bool GetSnapshot(int32 PollID, FTWPollSnapshot& OutSnapshot) const;
+	bool HasPolls() const { return Polls.Num() > 0; }
+
+	void Reset();
+
+private:
+	struct FVote
+	{
+		int32 Option = INDEX_NONE;
+		int64 Bits = 0;
+	};
+
+	struct FPoll
+	{
+		FString Channel;
+		FTWPollSettings Settings;
+		TMap<FString, int32> OptionsByName;		// Lowercase
+		TArray<int32> Voters;
+		TArray<int64> Weights;
+		TMap<uint64, FVote> Votes;						// user-id to current vote
+		int64 TotalVotesCast = 0;
+		double NextSnapshot = 0.0;
+		bool bDirty = false;
+
+		int32 ParseOption(const FString& Params) const;
+		int64 GetWeight(const FVote& Vote) const;
+		void FillSnapshot(int32 PollID, FTWPollSnapshot& OutSnapshot) const;
+	};
+
+	static uint64 GetUserKey(const FString& UserID);
+
+	// There are only ever a handful of polls, a linear case insensitive search avoids building a key per vote
+	TPair<int32, FPoll>* FindPoll(const FString& Channel, const FString& Command);
+
+	TMap<int32, FPoll> Polls;
+	int32 NextPollID = 0;
+};
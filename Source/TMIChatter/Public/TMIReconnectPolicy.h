@@ -0,0 +1,83 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "TMIReconnectPolicy.generated.h"
+
+USTRUCT(BlueprintType)
+struct FTWReconnectStats
+{
+	GENERATED_USTRUCT_BODY();
+
+	UPROPERTY(BlueprintReadOnly)
+		int32 Reconnects = 0;				// Connections made after losing one
+
+	UPROPERTY(BlueprintReadOnly)
+		int32 Attempts = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+		int32 ConsecutiveFailures = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+		float NextAttemptSeconds = -1.f;	// Negative when no attempt is scheduled
+
+	UPROPERTY(BlueprintReadOnly)
+		float CurrentDowntimeSeconds = 0.f;
+
+	UPROPERTY(BlueprintReadOnly)
+		float LastDowntimeSeconds = 0.f;
+
+	UPROPERTY(BlueprintReadOnly)
+		float LongestDowntimeSeconds = 0.f;
+
+	UPROPERTY(BlueprintReadOnly)
+		float TotalDowntimeSeconds = 0.f;
+};
+
+// Exponential backoff with full jitter: the n-th attempt waits a random time between 0 and
+// min(MaxDelay, BaseDelay * 2^n), so clients losing the server together don't come back together
+// Only a successful login ends the backoff, a server that accepts and drops us right away still counts as a failure
+class FTMIReconnectPolicy
+{
+public:
+	FTMIReconnectPolicy();
+
+	void SetDelays(double InBaseDelay, double InMaxDelay);
+	void Seed(int32 Seed) { Random.Initialize(Seed); }
+
+	// Starts counting downtime, further calls until we're connected again don't restart it
+	void OnDisconnected(double Now);
+
+	// Picks the time of the next attempt and returns the delay
+	double Schedule(double Now);
+
+	bool IsScheduled() const { return bScheduled; }
+	bool IsDue(double Now) const { return bScheduled && Now >= NextAttemptAt; }
+
+	// Call when the scheduled attempt is made, a failed attempt just schedules again
+	void OnAttempt();
+
+	// Ends the downtime and resets the backoff, call once we're logged in rather than when the socket opens
+	void OnAuthenticated(double Now);
+
+	// Stops a scheduled attempt, the stats are kept
+	void Cancel();
+	FTWReconnectStats GetStats(double Now) const;
+
+private:
+	FRandomStream Random;
+	double BaseDelay = 2.0;
+	double MaxDelay = 60.0;
+
+	bool bScheduled = false;
+	bool bDown = false;
+	double NextAttemptAt = 0.0;
+	double DownSince = 0.0;
+	int32 Failures = 0;
+
+	int32 Reconnects = 0;
+	int32 Attempts = 0;
+	double LastDowntime = 0.0;
+	double LongestDowntime = 0.0;
+	double TotalDowntime = 0.0;
+};
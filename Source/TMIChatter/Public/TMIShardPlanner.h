@@ -0,0 +1,58 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FTMIShardMove
+{
+	FString Channel;
+	int32 FromShard = INDEX_NONE;
+	int32 ToShard = INDEX_NONE;
+};
+
+// Decides which connection each channel lives on, shards are identified by IDs that are never reused
+// New channels go to the least loaded shard with room, a new shard is only opened once every shard is full.
+// When channels leave and everything fits in fewer shards, the smallest shard is drained into the others
+class FTMIShardPlanner
+{
+public:
+	static constexpr int32 DefaultChannelsPerShard = 100;
+
+	// Moves channels off shards over the new limit, or drains shards the new limit makes unnecessary
+	void SetChannelsPerShard(int32 Limit, TArray<FTMIShardMove>& OutMoves);
+	int32 GetChannelsPerShard() const { return ChannelsPerShard; }
+
+	// Returns the shard holding the channel, the one it already was on if it was added before
+	int32 Add(const FString& Channel);
+
+	// Opens every shard the channels need up front so they are spread evenly instead of filling one after the other
+	void AddMany(const TArray<FString>& Channels);
+
+	// Returns the shard the channel was on, INDEX_NONE if it wasn't added
+	int32 Remove(const FString& Channel, TArray<FTMIShardMove>& OutMoves);
+
+	int32 FindShard(const FString& Channel) const;
+	const TArray<FString>& GetChannels(int32 ShardID) const;
+	void GetShardIDs(TArray<int32>& OutShardIDs) const;
+
+	int32 NumShards() const { return Shards.Num(); }
+	int32 NumChannels() const { return ChannelShards.Num(); }
+
+	void Reset();
+
+private:
+	struct FShard
+	{
+		int32 ID = INDEX_NONE;
+		TArray<FString> Channels;
+	};
+
+	FShard& OpenShard();
+	FShard* FindLeastLoaded(int32 ExceptID = INDEX_NONE);
+	void Place(const FString& Channel, FShard& Shard);
+	void Compact(TArray<FTMIShardMove>& OutMoves);
+
+	TArray<FShard> Shards;
+	TMap<FString, int32> ChannelShards;
+	int32 ChannelsPerShard = DefaultChannelsPerShard;
+	int32 NextShardID = 0;
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TMITransport.h"
+
+#include <atomic>
+
+// IRC over TLS on a TCP socket, without the websocket framing and the FString per frame that comes with it
+// Every connection gets a thread of its own that connects, runs the handshake and receives, splitting lines straight
+// out of the decrypted buffer, so PINGs are answered there however busy the game thread is
+// The certificate is checked against the engine's root certificates and the host name
+// Without TLS the OAuth token goes over the wire as is, only turn it off for a LAN relay or a test server
+class FTMITcpTransport : public ITMITransport, public TSharedFromThis<FTMITcpTransport, ESPMode::ThreadSafe>
+{
+public:
+	static constexpr int32 MaxLineBytes = 16 * 1024;	// Tags included, longer lines drop the connection
+	static constexpr double ConnectTimeout = 10.0;		// Seconds for the TCP connect, the handshake stops with Close
+
+	static constexpr int32 TlsPort = 6697;
+
+	explicit FTMITcpTransport(const FString& InHost = TEXT("irc.chat.twitch.tv"), int32 InPort = TlsPort, bool bInUseTls = true);
+	virtual ~FTMITcpTransport();
+
+	virtual void SetEvents(FTMITransportEvents InEvents) override;
+
+	// A connection still winding down is left to finish on its own thread
+	virtual void Connect() override;
+
+	// Never waits: the connection's thread notices within 100ms, closes the socket and goes away by itself
+	// Closed is only reported for connections that got as far as Connected
+	virtual void Close() override;
+	virtual bool IsConnected() const override;
+
+	virtual void Send(const FString& Text) override;
+	virtual void Send(const uint8* Data, int32 Size) override;
+
+	virtual bool ReceivesOnGameThread() const override { return false; }
+
+private:
+	struct FTlsContext;		// OpenSSL, only known to the .cpp
+	struct FConnection;		// One socket, its TLS session and its thread, which holds it until it ends
+
+	typedef TSharedPtr<FConnection, ESPMode::ThreadSafe> FConnectionPtr;
+
+	// Connection thread, the transport may be gone while it runs
+	static void Run(TWeakPtr<FTMITcpTransport, ESPMode::ThreadSafe> WeakTransport, FConnectionPtr Connection);
+
+	// Runs Post on the game thread if the transport is still there and, unless bCurrentOnly is off, still on this connection
+	static void Post(const TWeakPtr<FTMITcpTransport, ESPMode::ThreadSafe>& WeakTransport, const FConnectionPtr& Connection,
+		TFunction<void(FTMITransportEvents& Events)> Post, bool bCurrentOnly = true);
+
+	FConnectionPtr GetCurrent() const;
+
+	const FString Host;
+	const int32 Port;
+	const bool bUseTls;
+
+	TSharedPtr<FTlsContext, ESPMode::ThreadSafe> Tls;	// Shared with the connections, it may outlive us on their threads
+
+	FCriticalSection EventsLock;
+	FTMITransportEvents Events;
+
+	mutable FCriticalSection CurrentLock;
+	FConnectionPtr Current;		// Set by Connect, cleared by Close, read by senders on any thread
+};
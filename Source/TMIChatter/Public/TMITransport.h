@@ -0,0 +1,35 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+// What a transport reports back to its owner
+// Connected, Error and Closed arrive on the game thread, Line on whichever thread the transport receives on
+struct FTMITransportEvents
+{
+	TFunction<void()> Connected;
+	TFunction<void(const FString& Error)> Error;
+	TFunction<void(const FString& Reason)> Closed;
+	TFunction<void(FString&& Line)> Line;		// One IRC line, without CRLF
+};
+
+// A connection to Twitch chat carrying IRC lines, UTwitchChatter only talks to its connections through this
+// Transports are created through MakeShared and used from the game thread, Send excepted
+class ITMITransport
+{
+public:
+	virtual ~ITMITransport() {}
+
+	// Replacing the events waits for a Line callback running on another thread
+	virtual void SetEvents(FTMITransportEvents InEvents) = 0;
+
+	virtual void Connect() = 0;
+	virtual void Close() = 0;
+	virtual bool IsConnected() const = 0;
+
+	// CRLF terminated lines, safe to call from the receiving thread
+	virtual void Send(const FString& Text) = 0;
+	virtual void Send(const uint8* Data, int32 Size) = 0;		// Already UTF-8
+
+	// When false received lines wait in the owner's FTMIIngress until the game thread drains them
+	virtual bool ReceivesOnGameThread() const { return true; }
+};
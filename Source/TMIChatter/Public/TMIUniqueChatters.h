@@ -0,0 +1,60 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "TMIUniqueChatters.generated.h"
+
+USTRUCT(BlueprintType)
+struct FTWUniqueChatterEstimate
+{
+	GENERATED_USTRUCT_BODY();
+
+	UPROPERTY(BlueprintReadOnly)
+		int64 Estimate = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+		float RelativeError = 0.f;	// Standard error of the estimate, the true count is within +-2x this about 95% of the time
+
+	UPROPERTY(BlueprintReadOnly)
+		float WindowSeconds = 0.f;
+};
+
+// Approximate distinct user-id count per channel over a sliding window using HyperLogLog
+// The window is covered by a ring of sketches that rotate out as time passes, an estimate is the register-wise
+// union of the live ones. Memory is fixed at SliceCount * RegisterCount bytes per channel no matter how many chatters there are
+class FTMIUniqueChatters
+{
+public:
+	static constexpr int32 Precision = 10;
+	static constexpr int32 RegisterCount = 1 << Precision;
+	static constexpr int32 SliceCount = 6;
+
+	// Changing the window drops what was collected so far
+	void SetWindow(float WindowSeconds);
+	float GetWindow() const { return WindowSeconds; }
+
+	void Add(const FString& Channel, const FString& UserID, double Now);
+
+	// Returns false for channels nobody chatted in yet
+	bool Estimate(const FString& Channel, double Now, FTWUniqueChatterEstimate& OutEstimate) const;
+
+	// 1.04 / sqrt(RegisterCount)
+	static float GetRelativeError();
+
+	void Remove(const FString& Channel);
+	void Reset();
+
+private:
+	struct FChannelSketches
+	{
+		int64 HeadSlice = 0;			// Absolute index of the slice being written
+		uint8 Registers[SliceCount][RegisterCount];
+
+		void Advance(int64 Slice);
+	};
+
+	int64 GetSlice(double Now) const;
+
+	float WindowSeconds = 300.f;
+	mutable TMap<FString, TUniquePtr<FChannelSketches>> Channels;	// Estimates rotate expired slices out
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TMIParser.h"
+
+#include "TMIUserDirectory.generated.h"
+
+USTRUCT(BlueprintType)
+struct FTWUserDirectoryStats
+{
+	GENERATED_USTRUCT_BODY();
+
+	UPROPERTY(BlueprintReadOnly)
+		int32 Num = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+		int32 Capacity = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+		int64 Lookups = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+		int64 Hits = 0;				// Lookups answered without parsing anything
+
+	UPROPERTY(BlueprintReadOnly)
+		int64 Updates = 0;		// Known chatters whose tags changed
+
+	UPROPERTY(BlueprintReadOnly)
+		int64 Evictions = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+		float HitRate = 0.0f;
+};
+
+// Bounded LRU directory of chatters keyed by user-id
+// Every PRIVMSG from the same chatter shares one immutable FTWChatterInfo, a new record is only parsed when their tags change
+class FTMIUserDirectory
+{
+public:
+	explicit FTMIUserDirectory(int32 InCapacity = 0);
+
+	// 0 disables the directory, shrinking evicts the least recently seen chatters
+	void SetCapacity(int32 NewCapacity);
+	int32 GetCapacity() const { return Capacity; }
+	bool IsEnabled() const { return Capacity > 0; }
+	int32 Num() const { return Index.Num(); }
+
+	TSharedRef<const FTWChatterInfo> Resolve(const FString& UserID, const FString& Login, const FTWRawChatterTags& Raw);
+	TSharedPtr<const FTWChatterInfo> Find(const FString& UserID) const;
+
+	void Reset();
+	FTWUserDirectoryStats GetStats() const;
+
+private:
+	struct FEntry
+	{
+		FTWRawChatterTags Raw;
+		TSharedPtr<const FTWChatterInfo> Info;
+		int32 Prev = INDEX_NONE;
+		int32 Next = INDEX_NONE;
+	};
+
+	static TSharedRef<const FTWChatterInfo> MakeInfo(const FString& UserID, const FString& Login, const FTWRawChatterTags& Raw);
+
+	void Unlink(int32 Slot);
+	void LinkFront(int32 Slot);
+	void EvictOldest();
+
+	TArray<FEntry> Entries;
+	TArray<int32> FreeSlots;
+	TMap<FString, int32> Index;		// user-id to slot in Entries
+	int32 Head = INDEX_NONE;			// Most recently seen
+	int32 Tail = INDEX_NONE;			// Least recently seen
+	int32 Capacity = 0;
+
+	int64 Lookups = 0;
+	int64 Hits = 0;
+	int64 Updates = 0;
+	int64 Evictions = 0;
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TMITransport.h"
+
+class IWebSocket;
+
+// IRC over Twitch's secure websocket, the default transport
+// IWebSocket calls back on the game thread, every frame is split into its lines there
+class FTMIWebSocketTransport : public ITMITransport
+{
+public:
+	FTMIWebSocketTransport();
+	virtual ~FTMIWebSocketTransport();
+
+	virtual void SetEvents(FTMITransportEvents InEvents) override { Events = MoveTemp(InEvents); }
+
+	virtual void Connect() override;
+	virtual void Close() override;
+	virtual bool IsConnected() const override;
+
+	virtual void Send(const FString& Text) override;
+	virtual void Send(const uint8* Data, int32 Size) override;
+
+private:
+	FTMITransportEvents Events;
+	TSharedPtr<IWebSocket> Socket;
+};
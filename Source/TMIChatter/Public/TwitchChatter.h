@@ -4,8 +4,19 @@
 
 #include "CoreMinimal.h"
 #include "Delegates/Delegate.h"
-#include "IWebSocket.h"
+#include "Containers/Ticker.h"
+#include "TMITransport.h"
 #include "TMIParser.h"
+#include "TMIChannelState.h"
+#include "TMIUserDirectory.h"
+#include "TMIMessageHistory.h"
+#include "TMIKeywordMatcher.h"
+#include "TMIChatMetrics.h"
+#include "TMIUniqueChatters.h"
+#include "TMIPolls.h"
+#include "TMIHeavyHitters.h"
+#include "TMIDuplicateDetector.h"
+#include "TMIClient.h"
 
 #include "TwitchChatter.generated.h"
 
@@ -14,8 +25,21 @@
 #define TWITCH_CHATTER_DEV_COLLECTION 0
 #define TWITCH_CHATTER_DEV_TESTING 0
 
+// Set to 0 (e.g. through PublicDefinitions in your Build.cs) to compile out every Blueprint delegate broadcast
+// The UPROPERTY delegates still exist so Blueprints keep loading, they are simply never fired
+#ifndef TWITCH_CHATTER_BLUEPRINT_EVENTS
+#define TWITCH_CHATTER_BLUEPRINT_EVENTS 1
+#endif
+
 DECLARE_LOG_CATEGORY_EXTERN(LogTwitchChatter, Log, All);
 
+UENUM(BlueprintType)
+enum class ETWTransport : uint8
+{
+	WebSocket,		// IRC over wss://irc-ws.chat.twitch.tv
+	Tcp				// IRC over TLS on irc.chat.twitch.tv:6697, received on a thread of its own
+};
+
 #define TWITCH_LOG(Lvl, Fmt, ...) UE_LOG(LogTwitchChatter, Lvl, Fmt, __VA_ARGS__)
 
 
@@ -77,6 +101,25 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnRoomState, const FRoomStateMessag
 UDELEGATE(BlueprintAuthorityOnly)
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnChannel, const FString&, Channel);
 
+// ChangedFields is a bitmask of ETWChannelStateField
+UDELEGATE(BlueprintAuthorityOnly)
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnChannelStateChanged, const FTWChannelState&, State, int32, ChangedFields);
+
+UDELEGATE(BlueprintAuthorityOnly)
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnHistoryChanged, const FString&, Channel, ETWHistoryChange, Change, const TArray<FGuid>&, RemovedIDs);
+
+UDELEGATE(BlueprintAuthorityOnly)
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnJoinProgress, const FString&, Channel, float, LatencySeconds, const FTWJoinProgress&, Progress);
+
+UDELEGATE(BlueprintAuthorityOnly)
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnDuplicatesCollapsed, const FPrivMsgMessage&, Message, int32, Collapsed);
+
+UDELEGATE(BlueprintAuthorityOnly)
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnPollUpdated, const FTWPollSnapshot&, Snapshot);
+
+UDELEGATE(BlueprintAuthorityOnly)
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnKeywordsMatched, const FPrivMsgMessage&, Message, const TArray<FTWKeywordMatch>&, Matches);
+
 UDELEGATE(BlueprintAuthorityOnly)
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnStatus);
 
@@ -98,6 +141,12 @@ DECLARE_EVENT_OneParam(UTwitchChatter, FChannelEvent, const FString& /*Channel*/
 DECLARE_EVENT_OneParam(UTwitchChatter, FUserStateEvent, const FUserStateMessage& /*Message*/);
 DECLARE_EVENT_OneParam(UTwitchChatter, FRoomStateEvent, const FRoomStateMessage& /*Message*/);
 DECLARE_EVENT_OneParam(UTwitchChatter, FGlobalUserStateEvent, const FGlobalUserStateMessage& /*Message*/);
+DECLARE_EVENT_TwoParams(UTwitchChatter, FChannelStateEvent, const FTWChannelState& /*State*/, ETWChannelStateField /*ChangedFields*/);
+DECLARE_EVENT_ThreeParams(UTwitchChatter, FHistoryChangedEvent, const FString& /*Channel*/, ETWHistoryChange /*Change*/, const TArray<FGuid>& /*RemovedIDs*/);
+DECLARE_EVENT_TwoParams(UTwitchChatter, FKeywordsMatchedEvent, const FPrivMsgMessage& /*Message*/, const TArray<FTWKeywordMatch>& /*Matches*/);
+DECLARE_EVENT_ThreeParams(UTwitchChatter, FJoinProgressEvent, const FString& /*Channel*/, float /*LatencySeconds*/, const FTWJoinProgress& /*Progress*/);
+DECLARE_EVENT_TwoParams(UTwitchChatter, FDuplicatesCollapsedEvent, const FPrivMsgMessage& /*Message*/, int32 /*Collapsed*/);
+DECLARE_EVENT_OneParam(UTwitchChatter, FPollEvent, const FTWPollSnapshot& /*Snapshot*/);
 DECLARE_EVENT_OneParam(UTwitchChatter, FSentMessageEvent, const FString& /*Raw Message*/);
 DECLARE_EVENT(UTwitchChatter, FStatusEvent);
 
@@ -118,20 +167,32 @@ public:
 	UFUNCTION(BlueprintCallable)
 		void Disconnect();
 
+	// Joins are batched and paced under Twitch's join rate limit, see GetJoinProgress
 	UFUNCTION(BlueprintCallable)
 		void JoinChannel(const FString& Channel);
 
 	UFUNCTION(BlueprintCallable)
 		void JoinChannels(const TArray<FString> &Channels);
 
+	UFUNCTION(BlueprintPure)
+		FTWJoinProgress GetJoinProgress() const;
+
 	UFUNCTION(BlueprintCallable)
 		void PartChannel(const FString& Channel);
 
+	// Chat messages are queued and sent as fast as Twitch's rate limits allow, see GetOutboundStats
+	// Returns false when the message was too long to send whole and its end was dropped
 	UFUNCTION(BlueprintCallable)
-		void Send(const FString& Channel, const FString& Message) const;
+		bool Send(const FString& Channel, const FString& Message);
 
 	UFUNCTION(BlueprintCallable)
-		void Broadcast(const FString& Message) const;
+		bool Broadcast(const FString& Message);
+
+	// Only to these of our channels, the message is still encoded once
+	bool BroadcastTo(const TArray<FString>& ToChannels, const FString& Message);
+
+	UFUNCTION(BlueprintPure)
+		FTWOutboundStats GetOutboundStats() const;
 
 	UFUNCTION(BlueprintCallable)
 		void BindCommandMessage(const FString& Command, UObject* BindObject, const FName& FunctionName);
@@ -148,15 +209,165 @@ public:
 	UFUNCTION(BlueprintCallable)
 		void ResetEventHandlers(bool ResetEvents = true, bool ResetDelegates = true);
 
+	// Messages from ignored logins (other bots for instance) are dropped before they are parsed
+	UFUNCTION(BlueprintCallable)
+		void IgnoreLogin(const FString& Login);
+
+	UFUNCTION(BlueprintCallable)
+		void UnignoreLogin(const FString& Login);
+
+	// Returns false if we have not received any ROOMSTATE or USERSTATE for the channel yet
+	UFUNCTION(BlueprintPure)
+		bool GetChannelState(const FString& Channel, FTWChannelState& OutState) const;
+
+	// Seconds we have to wait between messages in a channel, 0 when slow mode is off or we are exempt from it
+	UFUNCTION(BlueprintPure)
+		int32 GetSlowModeDelay(const FString& Channel) const;
+
+	// Shares one FTWChatterInfo per user-id across every PRIVMSG, 0 (the default) disables it
+	// While enabled PRIVMSG tags carry the chatter in Tags.Chatter instead of their own badges, color and display name
+	UFUNCTION(BlueprintCallable)
+		void SetUserDirectoryCapacity(int32 Capacity);
+
+	UFUNCTION(BlueprintPure)
+		FTWUserDirectoryStats GetUserDirectoryStats() const;
+
+	UFUNCTION(BlueprintPure)
+		bool FindChatter(const FString& UserID, FTWChatterInfo& OutChatter) const;
+
+	UFUNCTION(BlueprintPure)
+		static bool GetMessageChatter(const FPrivMsgMessage& Message, FTWChatterInfo& OutChatter);
+
+	// Number of PRIVMSGs kept per channel, CLEARMSG and CLEARCHAT are applied to the history as they arrive
+	// The default applies to every channel without its own capacity, 0 disables history
+	UFUNCTION(BlueprintCallable)
+		void SetDefaultHistoryCapacity(int32 Capacity);
+
+	UFUNCTION(BlueprintCallable)
+		void SetChannelHistoryCapacity(const FString& Channel, int32 Capacity);
+
+	// Oldest message first
+	UFUNCTION(BlueprintPure)
+		TArray<FPrivMsgMessage> GetChannelHistory(const FString& Channel) const;
+
+	// Compiles the keywords into a new matcher and swaps it in, a match's PatternID is the keyword's index
+	UFUNCTION(BlueprintCallable)
+		void SetKeywords(const TArray<FString>& Keywords, bool bCaseInsensitive = true);
+
+	UFUNCTION(BlueprintCallable)
+		void ClearKeywords();
+
+	// Sliding windows in seconds for the chat rate metrics, 10s, 1min and 5min by default
+	UFUNCTION(BlueprintCallable)
+		void SetMetricWindows(const TArray<float>& WindowSeconds);
+
+	UFUNCTION(BlueprintPure)
+		TArray<float> GetMetricWindows() const;
+
+	// WindowIndex indexes the metric windows, returns false if nothing was recorded for the channel yet
+	UFUNCTION(BlueprintPure)
+		bool GetChatRates(const FString& Channel, int32 WindowIndex, FTWChatRates& OutRates) const;
+
+	// Sliding window for unique chatter counting, 5 minutes by default
+	UFUNCTION(BlueprintCallable)
+		void SetUniqueChattersWindow(float WindowSeconds);
+
+	// Approximate number of distinct user-ids that chatted in the window, returns false if nobody did yet
+	UFUNCTION(BlueprintPure)
+		bool GetUniqueChatters(const FString& Channel, FTWUniqueChatterEstimate& OutEstimate) const;
+
+	// Votes for a running poll are tallied directly and never reach the chat command events
+	// Returns the poll's ID, INDEX_NONE if the settings have no options
+	UFUNCTION(BlueprintCallable)
+		int32 StartPoll(const FString& Channel, const FTWPollSettings& Settings);
+
+	// Fires a last, closed, poll update with the final tally
+	UFUNCTION(BlueprintCallable)
+		bool EndPoll(int32 PollID);
+
+	UFUNCTION(BlueprintPure)
+		bool GetPollSnapshot(int32 PollID, FTWPollSnapshot& OutSnapshot) const;
+
+	// Number of emotes and words tracked per channel for the top lists, 0 (the default) disables them
+	UFUNCTION(BlueprintCallable)
+		void SetTrendCapacity(int32 Capacity);
+
+	// Approximate, see FTWHeavyHitter for the error bound of each entry
+	UFUNCTION(BlueprintPure)
+		TArray<FTWHeavyHitter> GetTopEmotes(const FString& Channel, int32 Count = 10) const;
+
+	UFUNCTION(BlueprintPure)
+		TArray<FTWHeavyHitter> GetTopWords(const FString& Channel, int32 Count = 10) const;
+
+	// How long a copypasta cluster stays alive after its last message, 30 seconds by default
+	UFUNCTION(BlueprintCallable)
+		void SetDuplicateWindow(float WindowSeconds);
+
+	// Reconnects back off exponentially with random jitter, never waiting longer than MaxReconnectTime seconds
+	UFUNCTION(BlueprintPure)
+		FTWReconnectStats GetReconnectStats() const;
+
 	UPROPERTY(BlueprintReadWrite, EditAnywhere)
 		int32 MaxReconnectTime = 60;
 
+	// Round trip times of our own PINGs and how long ago anything arrived, see FTMIHealthMonitor
+	UFUNCTION(BlueprintPure)
+		FTWConnectionHealth GetConnectionHealth() const;
+
+	// Seconds between our PINGs once authenticated, 0 turns the probes off
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+		float HealthProbeInterval = 30.f;
+
+	// We reconnect when a PING isn't answered within this many seconds
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+		float HealthProbeTimeout = 10.f;
+
+	// We reconnect when nothing at all arrived for this many seconds, 0 turns it off
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+		float StaleConnectionSeconds = 90.f;
+
+	// Refreshed about once a second while connected
+	UPROPERTY(BlueprintReadOnly)
+		FTWConnectionHealth ConnectionHealth;
+
 	UPROPERTY(BlueprintReadWrite, EditAnywhere)
 		FString CommandPrefix = TEXT("!");
 
 	UPROPERTY(BlueprintReadOnly)
 		TArray<FString> ConnectedChannels;
 
+	UPROPERTY(BlueprintReadOnly)
+		TSet<FString> IgnoredLogins;
+
+	// When set only the C++ Event* interface is fired, the Blueprint On* delegates are skipped entirely
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+		bool bNativeEventsOnly = false;
+
+	// Split chat messages into text/emote/cheermote/mention/URL runs once on receive, see FPrivMsgMessage::Runs
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+		bool bTokenizeMessages = false;
+
+	// Annotate chat messages with their copypasta cluster, see FPrivMsgMessage::DuplicateClusterID
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+		bool bDetectDuplicates = false;
+
+	// With duplicate detection on, repeats of a cluster are not dispatched as chat messages,
+	// they're reported together by the duplicates collapsed event about once per second instead
+	// Messages with bits or commands are never collapsed
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+		bool bCollapseDuplicates = false;
+
+	// Used for connections made after it's changed
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+		ETWTransport Transport = ETWTransport::WebSocket;
+
+	// Twitch limits joins and chat per account, connections logged in as the same user should share the limits
+	void ShareRateLimits(const UTwitchChatter& Other) { Client.ShareRateLimits(Other.Client); }
+
+	// Connections made after this come from Factory instead of the Transport setting, an FTMILoopbackTransport for instance
+	// Unset it to go back to the setting
+	void SetTransportFactory(TFunction<TSharedRef<ITMITransport>()> Factory) { TransportFactory = MoveTemp(Factory); }
+
 	/* Begin C++ Event Interface */
 
 	/* See https://docs.unrealengine.com/5.0/en-US/event-programming-in-unreal-engine/ for more information */
@@ -176,6 +387,11 @@ public:
 	FUserRitualEvent EventRitual;
 	FNoticeEvent EventNotice;
 	FGlobalUserStateEvent EventAuthSuccess;
+	FChannelStateEvent EventChannelStateChanged;	// Fired only when a ROOMSTATE or USERSTATE actually changes something
+	FHistoryChangedEvent EventHistoryChanged;			// Fired when moderation removes messages held in the channel history
+	FKeywordsMatchedEvent EventKeywordsMatched;		// Fired once per message with every keyword occurrence in it
+	FDuplicatesCollapsedEvent EventDuplicatesCollapsed;	// Fired with the latest message of a cluster and how many repeats were held back
+	FPollEvent EventPollUpdated;									// Fired at most once per snapshot interval per poll while it receives votes, and when it ends
 
 	// Fired when THIS BOT itself joins or leaves a channel.
 	// It's not reliable to watch joined and parted notices for others
@@ -183,6 +399,7 @@ public:
 	// and it is still unreliable, just far less so.
 	FChannelEvent EventJoinedChannel;
 	FChannelEvent EventPartedChannel;
+	FJoinProgressEvent EventJoinProgress;		// Fired after EventJoinedChannel for channels we asked to join
 
 	FStatusEvent EventAuthFailure;
 	FStatusEvent EventSocketConnected;
@@ -201,9 +418,37 @@ private:
 
 private:
 	void Reconnect();
-	void SendAuthInfo() const;
-	void HandleMessage(const FString& Message);
-	void SendRaw(const FString& Message) const;
+	void ScheduleReconnect();
+
+	TSharedPtr<ITMITransport> CreateSocket() const;
+	bool EnsureSocket();
+	void BindSocket();
+	bool NeedsDraining() const;		// Lines arrive on another thread and wait for the ticker
+
+	// Server RECONNECT: a second connection logs in and joins our channels while the old one keeps delivering,
+	// the old one is closed once every channel is joined again (or it's closed on us)
+	void BeginMigration();
+	void HandleMigrationMessage(const FString& Line);
+	void PumpMigration(double Now);
+	void FinishMigration();
+	void AbortMigration();
+	void DrainIngress();
+	void RebuildIgnoredSources();
+	void EnsureTicker();
+	void EnsureTickerIfNeeded();					// When the client has queued work
+	void BroadcastSentFrame(const FString& Frame);
+	bool Tick(float DeltaTime);
+	void FlushCollapsedDuplicates();
+
+	// Typed messages from the client, fed into the analytics and fired as events
+	void DeliverChatMessage(FPrivMsgMessage& Message);
+	void DeliverClearChat(FClearChatMessage& Message);
+	void DeliverClearMsg(FClearMsgMessage& Message);
+	void DeliverUserNotice(FUserNoticeMessage& Message);
+	void DeliverJoin(const FString& Channel, double Latency);
+	void DeliverPart(const FString& Channel);
+
+	void BroadcastChannelState(const FString& Channel, ETWChannelStateField ChangedFields);
 
 	/* Blueprint Interface, slower as it uses multicast delegates, but can be used by C++ as well for a unified path */
 	UPROPERTY(BlueprintAssignable, Category = "TwitchChat")
@@ -263,6 +508,24 @@ private:
 	UPROPERTY(BlueprintAssignable, Category = "TwitchChat")
 		FOnClearMessage OnClearMsg;
 
+	UPROPERTY(BlueprintAssignable, Category = "TwitchChat")
+		FOnChannelStateChanged OnChannelStateChanged;
+
+	UPROPERTY(BlueprintAssignable, Category = "TwitchChat")
+		FOnHistoryChanged OnHistoryChanged;
+
+	UPROPERTY(BlueprintAssignable, Category = "TwitchChat")
+		FOnKeywordsMatched OnKeywordsMatched;
+
+	UPROPERTY(BlueprintAssignable, Category = "TwitchChat")
+		FOnPollUpdated OnPollUpdated;
+
+	UPROPERTY(BlueprintAssignable, Category = "TwitchChat")
+		FOnDuplicatesCollapsed OnDuplicatesCollapsed;
+
+	UPROPERTY(BlueprintAssignable, Category = "TwitchChat")
+		FOnJoinProgress OnJoinProgress;
+
 	UPROPERTY(BlueprintAssignable, Category = "TwitchSocket")
 		FOnStatus OnSocketConnected;
 
@@ -272,26 +535,48 @@ private:
 	UPROPERTY(BlueprintAssignable, Category = "TwitchSocket")
 		FOnStatus OnSocketClosed;
 
-	FString BotUsername;
-	FString BotPassword;
-	TArray<FString> AutoJoinChannels;
+	// Credentials, channels, parsing, send queues, joins, reconnects and health probes, everything that doesn't need the engine
+	FTMIClient Client;
+
+	int32 ReconnectTime = 2;		// First backoff ceiling, doubled with every failed attempt
+	bool bExpectClose = false;		// We closed the socket ourselves
+	double NextHealthUpdate = 0.0;
+
+	FTMIChannelStateStore ChannelStates;
+	FTMIUserDirectory UserDirectory;
+	FTMIMessageHistory MessageHistory;
+	FTMIKeywordMatcher KeywordMatcher;
+	FTMIChatMetrics ChatMetrics;
+	FTMIUniqueChatters UniqueChatters;
+	FTMIPollEngine Polls;
+	FTMIChannelTrends Trends;
+	FTMIDuplicateDetector DuplicateDetector;
+
+	struct FCollapsedDuplicates
+	{
+		FPrivMsgMessage Latest;
+		int32 Collapsed = 0;
+	};
+
+	TMap<int32, FCollapsedDuplicates> CollapsedDuplicates;	// By cluster ID, flushed by the ticker
 
-	bool bFastMode = false;
-	bool bReconnect = false;
-	int32 ReconnectTime = 2;
-	bool bAuthenticated = false;
+	// Only registered while something needs periodic work, see Tick
+	FTSTicker::FDelegateHandle TickerHandle;
+	double NextCollapseFlush = 0.0;
 
 	// C++ Interface
 	TMap<FString, TSharedPtr<FChatCommandEvent>> CommandCallbacks;
 	TMap<FString, TSharedPtr<FOnChatCommand>> MulticastCommandCallbacks;
 
-	TSharedPtr<IWebSocket> Socket = nullptr;
+	TSharedPtr<ITMITransport> Socket = nullptr;		// Created by the first Connect
+	TFunction<TSharedRef<ITMITransport>()> TransportFactory;
 
-	const FString TwitchTMI_WebsocketURL = TEXT("wss://irc-ws.chat.twitch.tv:443/");
-	FDelegateHandle MessageDelegateHandle;
-	FDelegateHandle SocketErrorDelegateHandle;
-	FDelegateHandle SocketClosedDelegateHandle;
-	FDelegateHandle MsgSentDelegateHandle;
+	static constexpr double MigrationTimeout = 60.0;
+	TSharedPtr<ITMITransport> PendingSocket;
+	TArray<TSharedPtr<ITMITransport>> RetiredSockets;	// Released by the ticker
+	FTMIJoinScheduler MigrationJoins;
+	double MigrationDeadline = 0.0;
+	bool bPendingAuthenticated = false;
 
 	FSentMessageEvent EventSentMessage;
 	friend class TwitchChatterSpec;	// Yes the test class gets to look at all the bits
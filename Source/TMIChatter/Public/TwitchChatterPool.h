@@ -0,0 +1,157 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "TwitchChatter.h"
+#include "TMIShardPlanner.h"
+
+#include "TwitchChatterPool.generated.h"
+
+DECLARE_EVENT_ThreeParams(UTwitchChatterPool, FPoolChatCommandEvent, const FPrivMsgMessage& /*Message*/, const FString& /*Command*/, const FString& /*Params*/);
+DECLARE_EVENT_OneParam(UTwitchChatterPool, FPoolPrivMsgEvent, const FPrivMsgMessage& /*Message*/);
+DECLARE_EVENT_OneParam(UTwitchChatterPool, FPoolClearChatEvent, const FClearChatMessage& /*Message*/);
+DECLARE_EVENT_OneParam(UTwitchChatterPool, FPoolClearMsgEvent, const FClearMsgMessage& /*Message*/);
+DECLARE_EVENT_OneParam(UTwitchChatterPool, FPoolNoticeEvent, const FNoticeMessage& /*Message*/);
+DECLARE_EVENT_OneParam(UTwitchChatterPool, FPoolUserNoticeEvent, const FUserNoticeMessage& /*Message*/);
+DECLARE_EVENT_OneParam(UTwitchChatterPool, FPoolChannelEvent, const FString& /*Channel*/);
+
+// Spreads channels over several connections logged in as the same account, at most ChannelsPerConnection each
+// Connections are opened and closed as channels come and go, channels move between them when a connection
+// can be closed or the limit changes. Every connection reports on the game thread and a channel's events only come
+// from the connection owning it, so the pool's events are one stream in the order messages arrived
+// A moving channel stays with its old connection until the new one confirmed the JOIN, only then is it parted
+// and a connection the planner dropped closed. A move delivers no message twice, but its order isn't guaranteed:
+// around the hand-over the two connections' lines arrive in whatever order the connections deliver them
+UCLASS(Transient, BlueprintType, Blueprintable, MinimalAPI)
+class UTwitchChatterPool : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	UFUNCTION(BlueprintCallable)
+		void Connect(const FString& Username, const FString& Password, const TArray<FString>& Channels, bool AutoReconnect = true, bool FastMode = false);
+
+	UFUNCTION(BlueprintCallable)
+		void Disconnect();
+
+	UFUNCTION(BlueprintCallable)
+		void JoinChannel(const FString& Channel);
+
+	UFUNCTION(BlueprintCallable)
+		void JoinChannels(const TArray<FString>& Channels);
+
+	UFUNCTION(BlueprintCallable)
+		void PartChannel(const FString& Channel);
+
+	// Return false when the message was too long to send whole, see UTwitchChatter::Send
+	UFUNCTION(BlueprintCallable)
+		bool Send(const FString& Channel, const FString& Message);
+
+	UFUNCTION(BlueprintCallable)
+		bool Broadcast(const FString& Message);
+
+	// 100 by default, lowering it moves channels to other connections right away
+	UFUNCTION(BlueprintCallable)
+		void SetChannelsPerConnection(int32 Limit);
+
+	UFUNCTION(BlueprintPure)
+		int32 GetChannelsPerConnection() const;
+
+	UFUNCTION(BlueprintPure)
+		int32 GetNumConnections() const;
+
+	// The connection the channel lives on, for everything the pool doesn't forward
+	UFUNCTION(BlueprintPure)
+		UTwitchChatter* GetConnectionFor(const FString& Channel) const;
+
+	UFUNCTION(BlueprintPure)
+		TArray<UTwitchChatter*> GetConnections() const;
+
+	// Connections opened after this get their transport from Factory, see UTwitchChatter::SetTransportFactory
+	void SetTransportFactory(TFunction<TSharedRef<ITMITransport>()> Factory) { TransportFactory = MoveTemp(Factory); }
+
+	// When set only the C++ Event* interface is fired, the Blueprint On* delegates are skipped entirely
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+		bool bNativeEventsOnly = false;
+
+	/* Begin C++ Event Interface */
+
+	FPoolPrivMsgEvent EventChatMessage;
+	FPoolPrivMsgEvent EventChatBits;
+	FPoolChatCommandEvent EventChatCommand;
+	FPoolClearChatEvent EventChatCleared;
+	FPoolClearMsgEvent EventMsgCleared;
+	FPoolNoticeEvent EventNotice;
+	FPoolUserNoticeEvent EventUserNotice;
+	FPoolChannelEvent EventJoinedChannel;
+	FPoolChannelEvent EventPartedChannel;
+
+	/* End C++ Event Interface */
+
+	UPROPERTY(BlueprintAssignable, Category = "TwitchChat")
+		FOnMessage OnChatMessage;
+
+	UPROPERTY(BlueprintAssignable, Category = "TwitchChat")
+		FOnMessage OnChatBits;
+
+	UPROPERTY(BlueprintAssignable, Category = "TwitchChat")
+		FOnChatCommand OnChatCommand;
+
+	UPROPERTY(BlueprintAssignable, Category = "TwitchChat")
+		FOnClearChat OnClearChat;
+
+	UPROPERTY(BlueprintAssignable, Category = "TwitchChat")
+		FOnClearMessage OnClearMsg;
+
+	UPROPERTY(BlueprintAssignable, Category = "TwitchChat")
+		FOnNotice OnNotice;
+
+	UPROPERTY(BlueprintAssignable, Category = "TwitchChat")
+		FOnUserNotice OnUserNotice;
+
+	UPROPERTY(BlueprintAssignable, Category = "TwitchChat")
+		FOnChannel OnJoinedChannel;
+
+	UPROPERTY(BlueprintAssignable, Category = "TwitchChat")
+		FOnChannel OnPartedChannel;
+
+private:
+	// Opens connections for new shards and starts the moves, connections the planner dropped retire until
+	// their channels are joined elsewhere
+	void SyncShards(const TArray<FTMIShardMove>& Moves);
+	UTwitchChatter* OpenShard(int32 ShardID);
+	UTwitchChatter* FindShard(int32 ShardID) const;
+	void CloseRetiredShards();
+
+	// The connection delivering the channel, the old one while it's moving
+	int32 GetOwner(const FString& Channel) const;
+	bool Owns(int32 ShardID, const FString& Channel) const { return GetOwner(Channel) == ShardID; }
+
+	void HandleAuthSuccess(const FGlobalUserStateMessage& Message, int32 ShardID);
+	void HandleChatMessage(const FPrivMsgMessage& Message, int32 ShardID);
+	void HandleChatBits(const FPrivMsgMessage& Message, int32 ShardID);
+	void HandleChatCommand(const FPrivMsgMessage& Message, const FString& Command, const FString& Params, int32 ShardID);
+	void HandleChatCleared(const FClearChatMessage& Message, int32 ShardID);
+	void HandleMsgCleared(const FClearMsgMessage& Message, int32 ShardID);
+	void HandleNotice(const FNoticeMessage& Message, int32 ShardID);
+	void HandleUserNotice(const FUserNoticeMessage& Message, int32 ShardID);
+	void HandleJoinedChannel(const FString& Channel, int32 ShardID);
+	void HandlePartedChannel(const FString& Channel, int32 ShardID);
+
+	UPROPERTY()
+		TMap<int32, TObjectPtr<UTwitchChatter>> Shards;
+
+	// Dropped by the planner but still delivering channels that move away from them
+	UPROPERTY()
+		TMap<int32, TObjectPtr<UTwitchChatter>> RetiredShards;
+
+	FTMIShardPlanner Planner;
+	TMap<FString, int32> MovingFrom;		// Channel to the shard it's leaving, until its new shard confirmed the JOIN
+	TFunction<TSharedRef<ITMITransport>()> TransportFactory;
+
+	FString BotUsername;
+	FString BotPassword;
+	bool bReconnect = true;
+	bool bFastMode = false;
+	bool bConnected = false;
+};
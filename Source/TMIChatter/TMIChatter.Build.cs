@@ -36,13 +36,18 @@ public class TMIChatter : ModuleRules
 			new string[]
 			{
 				"CoreUObject",
-				"Engine",
-				"Json"
+				"Json",
+				"Sockets",
+				"SSL"
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
 		
 		
+		// TLS for FTMITcpTransport
+		AddEngineThirdPartyPrivateStaticDependencies(Target, "OpenSSL");
+
+
 		DynamicallyLoadedModuleNames.AddRange(
 			new string[]
 			{